@@ -7,10 +7,95 @@
 #include "chain/chain.h"
 #include "json/json_spirit.h"
 #include "utils/utilstrencodings.h"
+#include "core/init.h"
+#include "keys/pubkey.h"
+#include "structs/hash.h"
+#include "utils/sync.h"
+#include "wallet/wallettxs.h"
 
 using namespace std;
 using namespace json_spirit;
 
+// Admin fee parameters cached by GetAdminFeeParams, keyed by the last transactionparams item confirmed below the block.
+// Item replaced in reorg has different txid or block, so the cache is reloaded
+static CCriticalSection cs_AdminFeeParams;
+static bool fAdminFeeParamsLoaded=false;
+static uint256 hashAdminFeeParamsItem=0;                                        // 0 - no confirmed items
+static int nAdminFeeParamsItemBlock=-1;
+static bool fAdminFeeParamsSet=false;
+static CScript scriptAdminFeeParams;
+static double dAdminFeeParamsRatio=0;
+
+// Txid and block of the last item of subscribed stream confirmed in block nHeight or before, false if stream is not found or not subscribed
+static bool GetLastConfirmedStreamItem(string streamName, int nHeight, uint256& txid, int& block)
+{
+    mc_EntityDetails entity;
+    mc_TxEntityStat entStat;
+
+    txid=0;
+    block=-1;
+    if (pwalletTxsMain == NULL) {
+        return false;
+    }
+    if (!mc_gState->m_Assets->FindEntityByName(&entity, (char*)streamName.c_str())) {
+        return false;
+    }
+    if (entity.GetEntityType() != MC_ENT_TYPE_STREAM) {
+        return false;
+    }
+
+    entStat.Zero();
+    memcpy(&entStat, entity.GetTxID() + MC_AST_SHORT_TXID_OFFSET, MC_AST_SHORT_TXID_SIZE);
+    entStat.m_Entity.m_EntityType = MC_TET_STREAM | MC_TET_CHAINPOS;
+    if (!pwalletTxsMain->FindEntity(&entStat)) {
+        return false;
+    }
+
+    int item=(nHeight >= 0) ? pwalletTxsMain->GetBlockItemIndex(&entStat.m_Entity, nHeight) : 0;
+    if (item <= 0) {
+        return true;
+    }
+
+    mc_Buffer *entity_rows=new mc_Buffer;
+    entity_rows->Initialize(MC_TDB_ENTITY_KEY_SIZE,sizeof(mc_TxEntityRow),MC_BUF_MODE_DEFAULT);
+    if ((pwalletTxsMain->GetList(&entStat.m_Entity, item, 1, entity_rows) == MC_ERR_NOERROR) && entity_rows->GetCount()) {
+        mc_TxEntityRow *lpEntTx=(mc_TxEntityRow*)entity_rows->GetRow(0);
+        memcpy(&txid, lpEntTx->m_TxId, MC_TDB_TXID_SIZE);
+        block=lpEntTx->m_Block;
+    }
+    delete entity_rows;
+
+    return true;
+}
+
+// Value of the last item with the key confirmed in block nHeight or before, empty if there is no such item
+static string GetConfirmedStreamKeyValue(string streamName, string key, int nHeight)
+{
+    Array streamParams;
+    streamParams.push_back(streamName);
+    streamParams.push_back(key);
+    streamParams.push_back(false);
+    streamParams.push_back(99999);
+    Array items = liststreamkeyitems(streamParams, false).get_array();
+
+    int nTipHeight=chainActive.Height();
+    for (int i=(int)items.size()-1; i>=0; i--) {
+        if (items[i].type() != obj_type) {
+            continue;
+        }
+        Value confirmations=find_value(items[i].get_obj(), "confirmations");
+        if ((confirmations.type() != int_type) || (confirmations.get_int() <= 0)) {
+            continue;
+        }
+        if (nTipHeight - confirmations.get_int() + 1 > nHeight) {
+            continue;
+        }
+        Value data=find_value(items[i].get_obj(), "data");
+        return (data.type() == str_type) ? HexToStr(data.get_str()) : "";
+    }
+    return "";
+}
+
 namespace StreamUtils {
     unsigned int GetMinimumRelayTxFee() {
         if (!IsStreamExisting(STREAM_TRANSACTIONPARAMS)) {
@@ -87,6 +172,71 @@ namespace StreamUtils {
         return adminFeeRatioValue;
     }
 
+    bool GetAdminFeeParams(int nHeight, CScript& scriptAdmin, double& adminFeeRatio) {
+        // Parameters set by items confirmed in active chain below the block
+        uint256 hashItem;
+        int nItemBlock;
+        if (!GetLastConfirmedStreamItem(STREAM_TRANSACTIONPARAMS, nHeight-1, hashItem, nItemBlock)) {
+            hashItem=0;
+            nItemBlock=-1;
+        }
+
+        {
+            LOCK(cs_AdminFeeParams);
+            if (fAdminFeeParamsLoaded && (hashItem == hashAdminFeeParamsItem) && (nItemBlock == nAdminFeeParamsItemBlock)) {
+                scriptAdmin=scriptAdminFeeParams;
+                adminFeeRatio=dAdminFeeParamsRatio;
+                return fAdminFeeParamsSet;
+            }
+        }
+
+        // Stream queries take cs_main and wallet locks, cache lock is not held here
+        bool fSet=false;
+        CScript script;
+        double ratio=0;
+        if (hashItem != 0) {
+            try {
+                string ratioStr=GetConfirmedStreamKeyValue(STREAM_TRANSACTIONPARAMS, KEY_ADMINFEERATIO, nHeight-1);
+                string adminAddrStr=GetConfirmedStreamKeyValue(STREAM_TRANSACTIONPARAMS, KEY_ADMINPUBLICKEY, nHeight-1);
+                ratio=atof(ratioStr.c_str());
+                if (ratio > 0 && adminAddrStr.size() && adminAddrStr.compare("0") != 0) {
+                    std::vector<unsigned char> data(adminAddrStr.begin(), adminAddrStr.end());
+                    CPubKey pubkey(data);
+                    const unsigned char *pubkey_hash=(unsigned char *)Hash160(pubkey.begin(),pubkey.end()).begin();
+                    script = CScript() << OP_DUP << OP_HASH160 << std::vector<unsigned char>(pubkey_hash, pubkey_hash + 20) << OP_EQUALVERIFY << OP_CHECKSIG;
+                    fSet=true;
+                }
+            }
+            catch (const std::exception &exc) {
+                // Not cached, retried on next call
+                LogPrintf("ERROR: Cannot load admin fee parameters: %s\n", exc.what());
+                return false;
+            }
+        }
+        if (!fSet) {
+            ratio=0;
+        }
+
+        LOCK(cs_AdminFeeParams);
+        fAdminFeeParamsLoaded=true;
+        hashAdminFeeParamsItem=hashItem;
+        nAdminFeeParamsItemBlock=nItemBlock;
+        fAdminFeeParamsSet=fSet;
+        scriptAdminFeeParams=script;
+        dAdminFeeParamsRatio=ratio;
+        if(fDebug)LogPrint("ambr","ambr: Admin fee parameters loaded for block %d, last transactionparams item %s in block %d, ratio %f, script %s\n",
+                nHeight,hashItem.ToString().c_str(),nItemBlock,ratio,HexStr(script.begin(),script.end()));
+
+        scriptAdmin=script;
+        adminFeeRatio=ratio;
+        return fSet;
+    }
+
+    CAmount GetAdminFee(CAmount nTotal, double adminFeeRatio) {
+        // Truncated product, blocks created by earlier versions use the same rounding
+        return nTotal * adminFeeRatio;
+    }
+
     bool IsPublicAccount(string address) {
         if (!IsStreamExisting(STREAM_TRANSACTIONPARAMS)) {
             return false;
@@ -164,6 +314,30 @@ namespace StreamUtils {
 
     }
 
+    int GetStreamItemCount(string streamName) {
+        mc_EntityDetails entity;
+        mc_TxEntityStat entStat;
+
+        if (pwalletTxsMain == NULL) {
+            return -1;
+        }
+        if (!mc_gState->m_Assets->FindEntityByName(&entity, (char*)streamName.c_str())) {
+            return -1;
+        }
+        if (entity.GetEntityType() != MC_ENT_TYPE_STREAM) {
+            return -1;
+        }
+
+        entStat.Zero();
+        memcpy(&entStat, entity.GetTxID() + MC_AST_SHORT_TXID_OFFSET, MC_AST_SHORT_TXID_SIZE);
+        entStat.m_Entity.m_EntityType = MC_TET_STREAM | MC_TET_CHAINPOS;
+        if (!pwalletTxsMain->FindEntity(&entStat)) {
+            return -1;
+        }
+
+        return (int)entStat.m_LastPos;
+    }
+
 }
 
 /* AMB END */
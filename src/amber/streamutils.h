@@ -11,6 +11,8 @@
 #include "amber/utils.h"
 #include "amber/permissionutils.h"
 #include "amber/strencodings.h"
+#include "structs/amount.h"
+#include "script/script.h"
 #include "utils/util.h"
 
 using namespace std;
@@ -22,8 +24,14 @@ namespace StreamUtils {
     unsigned int GetMinimumRelayTxFee();
     string GetAdminPublicKey();
     double GetAdminFeeRatio();
+    // Admin payout script and fee ratio for block at nHeight, set by transactionparams items confirmed below it.
+    // Cached until the last such item changes. Returns false if admin fee is not set
+    bool GetAdminFeeParams(int nHeight, CScript& scriptAdmin, double& adminFeeRatio);
+    CAmount GetAdminFee(CAmount nTotal, double adminFeeRatio);
     bool IsPublicAccount(string address);
     bool IsStreamExisting(string streamName);
+    // Number of items in a subscribed stream, including unconfirmed, -1 if not found or not subscribed
+    int GetStreamItemCount(string streamName);
     bool IsAuthority(string address);
 }
 
@@ -37,6 +37,7 @@
 #define KEY_ADMINFEERATIO                   "admin-fee-ratio"
 #define KEY_PUBLICACCOUNT                   "public-account"
 #define ID_AUTHORITY		                "node-authority"
+#define ESCROW_SIGS_REQUIRED                3
 
 using namespace std;
 
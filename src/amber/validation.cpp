@@ -5,11 +5,16 @@
 #include <stdio.h>
 
 #include "amber/validation.h"
+#include "amber/streamutils.h"
 #include "structs/base58.h"
 #include "chain/chain.h"
 #include "json/json_spirit.h"
 #include "utils/utilstrencodings.h"
 #include "core/main.h" // for GetTransaction
+#ifdef ENABLE_WALLET
+#include "core/init.h" // for pwalletMain
+#include "wallet/wallet.h"
+#endif
 
 using namespace std;
 using namespace json_spirit;
@@ -188,6 +193,55 @@ bool IsMinerTx(const CTransaction& tx)
     return txsenderisminer(tx);
 }
 
+// Fee exemption decisions cached in mempool entries depend on permissions, on the
+// authoritynodes/transactionparams streams and on multisig scripts known to the wallet,
+// the version is bumped when any of them changes
+static int nFeeExemptionVersion=0;
+static uint64_t nFeeExemptionPermissionRow=0;
+static int nFeeExemptionPermissionMempool=-1;
+static int nFeeExemptionAuthNodesItems=-1;
+static int nFeeExemptionTxParamsItems=-1;
+static int nFeeExemptionWalletScripts=-1;
+
+int GetFeeExemptionVersion()
+{
+    return nFeeExemptionVersion;
+}
+
+bool UpdateFeeExemptionVersion()
+{
+    uint64_t permission_row=mc_gState->m_Permissions->m_Row;
+    int permission_mempool=mc_gState->m_Permissions->m_MemPool->GetCount();
+    int authnodes_items=StreamUtils::GetStreamItemCount(STREAM_AUTHNODES);
+    int txparams_items=StreamUtils::GetStreamItemCount(STREAM_TRANSACTIONPARAMS);
+    int wallet_scripts=0;
+#ifdef ENABLE_WALLET
+    if(pwalletMain)
+    {
+        wallet_scripts=pwalletMain->GetCScriptCount();
+    }
+#endif
+    
+    if( (permission_row == nFeeExemptionPermissionRow) && 
+        (permission_mempool == nFeeExemptionPermissionMempool) &&
+        (authnodes_items == nFeeExemptionAuthNodesItems) && 
+        (txparams_items == nFeeExemptionTxParamsItems) &&
+        (wallet_scripts == nFeeExemptionWalletScripts) )
+    {
+        return false;
+    }
+    
+    nFeeExemptionPermissionRow=permission_row;
+    nFeeExemptionPermissionMempool=permission_mempool;
+    nFeeExemptionAuthNodesItems=authnodes_items;
+    nFeeExemptionTxParamsItems=txparams_items;
+    nFeeExemptionWalletScripts=wallet_scripts;
+    nFeeExemptionVersion++;
+    
+    if(fDebug)LogPrint("mchn","mchn: Fee exemption version %d\n",nFeeExemptionVersion);
+    return true;
+}
+
 // custom transaction validation entry point, for future customisation support
 bool custom_accept_transacton(const CTransaction& tx, 
                               const CCoinsViewCache &inputs,
@@ -19,6 +19,8 @@ using namespace json_spirit;
 
 void LogInvalidBlock(CBlock& block, const CBlockIndex* pindex, std::string reason);
 bool IsMinerTx(const CTransaction& tx);
+int GetFeeExemptionVersion();
+bool UpdateFeeExemptionVersion();
 bool custom_accept_transacton(const CTransaction& tx, 
                               const CCoinsViewCache &inputs,
                               int offset,
@@ -0,0 +1,138 @@
+// Copyright (c) 2018 Apsaras Group Ltd
+// Amberchain code distributed under the GPLv3 license, see COPYING file.
+
+#include "bench/bench.h"
+
+#include "utils/utiltime.h"
+
+#include <stdio.h>
+
+#include <algorithm>
+
+using namespace std;
+
+namespace benchmark {
+
+static double Percentile(const std::vector<double>& vSorted, double p)
+{
+    if (vSorted.empty())
+        return 0;
+    size_t n = (size_t)(p * (vSorted.size() - 1) + 0.5);
+    return vSorted[std::min(n, vSorted.size() - 1)];
+}
+
+State::State(const std::string& nameIn, int64_t nMaxElapsedIn) :
+    name(nameIn), nMaxElapsed(nMaxElapsedIn), nBytesPerOp(0), nBeginTime(0), nLastTime(0),
+    nCount(0), nBatchSize(0), nRemaining(0), nPauseTime(0), nPausedInBatch(0), nMeasured(0)
+{
+}
+
+bool State::KeepRunning()
+{
+    if (nRemaining > 1)
+    {
+        nRemaining--;
+        return true;
+    }
+
+    int64_t nNow = GetTimeMicros();
+    if (nBatchSize == 0)                                                        // First call, setup is finished
+    {
+        nBeginTime = nLastTime = nNow;
+        nBatchSize = nRemaining = 1;
+        return true;
+    }
+
+    int64_t nElapsed = nNow - nLastTime - nPausedInBatch;
+    nPausedInBatch = 0;
+    nCount += nBatchSize;
+    nMeasured += nElapsed;
+    vLatency.push_back((double)nElapsed / nBatchSize);
+    nLastTime = nNow;
+
+    if (nNow - nBeginTime >= nMaxElapsed)                                       // Pauses are included, preparation is limited by -time too
+        return false;
+
+    if ((nElapsed < BATCH_MIN_TIME) && (nBatchSize < BATCH_MAX_SIZE))
+        nBatchSize *= 2;
+    nRemaining = nBatchSize;
+    return true;
+}
+
+void State::PauseTiming()
+{
+    nPauseTime = GetTimeMicros();
+}
+
+void State::ResumeTiming()
+{
+    if (nPauseTime)
+    {
+        nPausedInBatch += GetTimeMicros() - nPauseTime;
+        nPauseTime = 0;
+    }
+}
+
+void State::Report() const
+{
+    if (HasError())
+    {
+        printf("%-36s %14s  %s\n", name.c_str(), "error", strError.c_str());
+        fflush(stdout);
+        return;
+    }
+    if (nCount == 0)
+    {
+        printf("%-36s %14s\n", name.c_str(), "skipped");
+        return;
+    }
+
+    std::vector<double> vSorted = vLatency;
+    std::sort(vSorted.begin(), vSorted.end());
+
+    double dElapsed = (double)std::max(nMeasured, (int64_t)1) / 1000000.;
+    double dOpsPerSecond = nCount / dElapsed;
+
+    printf("%-36s %14.1f %12.3f %12.3f %12.3f", name.c_str(), dOpsPerSecond,
+           Percentile(vSorted, 0.50), Percentile(vSorted, 0.90), Percentile(vSorted, 0.99));
+    if (nBytesPerOp)
+        printf(" %10.1f", dOpsPerSecond * nBytesPerOp / 1000000.);
+    printf("\n");
+    fflush(stdout);
+}
+
+BenchRunner::BenchmarkMap& BenchRunner::benchmarks()
+{
+    static BenchmarkMap benchmarks_map;
+    return benchmarks_map;
+}
+
+BenchRunner::BenchRunner(const std::string& name, BenchFunction func)
+{
+    benchmarks().insert(make_pair(name, func));
+}
+
+int BenchRunner::RunAll(const std::string& strFilter, int64_t nMaxElapsed)
+{
+    int nErrors = 0;
+    printf("%-36s %14s %12s %12s %12s %10s\n", "# Benchmark", "ops/s", "p50 (us)", "p90 (us)", "p99 (us)", "MB/s");
+    for (BenchmarkMap::const_iterator it = benchmarks().begin(); it != benchmarks().end(); ++it)
+    {
+        if (!strFilter.empty() && (it->first.find(strFilter) == std::string::npos))
+            continue;
+        State state(it->first, nMaxElapsed);
+        it->second(state);
+        state.Report();
+        if (state.HasError())
+            nErrors++;
+    }
+    return nErrors;
+}
+
+void BenchRunner::ListAll()
+{
+    for (BenchmarkMap::const_iterator it = benchmarks().begin(); it != benchmarks().end(); ++it)
+        printf("%s\n", it->first.c_str());
+}
+
+}
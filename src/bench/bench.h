@@ -0,0 +1,93 @@
+// Copyright (c) 2018 Apsaras Group Ltd
+// Amberchain code distributed under the GPLv3 license, see COPYING file.
+
+#ifndef AMBER_BENCH_BENCH_H
+#define AMBER_BENCH_BENCH_H
+
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/preprocessor/cat.hpp>
+#include <boost/preprocessor/stringize.hpp>
+
+/**
+ * Micro-benchmark framework of bench_amberchain.
+ *
+ * Benchmark function does its setup first and then runs the measured operation while state.KeepRunning() returns true:
+ *
+ * static void MempoolLookup(benchmark::State& state)
+ * {
+ *     ... setup, not measured ...
+ *     while (state.KeepRunning())
+ *     {
+ *         ... one operation ...
+ *     }
+ * }
+ * BENCHMARK(MempoolLookup);
+ *
+ * Operations are timed in batches, batch size is doubled while the batch takes less than BATCH_MIN_TIME,
+ * so operations slower than that are timed one by one. Latency percentiles are computed from per-operation
+ * average of each batch. Benchmark returning without calling KeepRunning() is reported as skipped.
+ *
+ * Preparation of the next operation, e.g. signing transactions of the next block, can be excluded from the
+ * measurement by PauseTiming()/ResumeTiming() inside the loop. Benchmark which cannot run or whose operation
+ * fails calls SetError() and returns, it is reported as error and makes bench_amberchain exit with failure.
+ */
+
+namespace benchmark {
+
+/** Batch is doubled while it is faster than this, microseconds */
+static const int64_t BATCH_MIN_TIME = 20;
+/** Maximal number of operations in one batch */
+static const int64_t BATCH_MAX_SIZE = 1 << 20;
+
+class State
+{
+    std::string name;
+    int64_t nMaxElapsed;                                                        // Microseconds
+    int64_t nBytesPerOp;
+    int64_t nBeginTime;
+    int64_t nLastTime;
+    int64_t nCount;
+    int64_t nBatchSize;
+    int64_t nRemaining;
+    int64_t nPauseTime;                                                         // Start of the current pause, 0 if not paused
+    int64_t nPausedInBatch;                                                     // Paused time of the current batch
+    int64_t nMeasured;                                                          // Total time of all batches, pauses excluded
+    std::vector<double> vLatency;                                               // Per-operation average of every batch, microseconds
+    std::string strError;
+
+public:
+    State(const std::string& nameIn, int64_t nMaxElapsedIn);
+
+    bool KeepRunning();
+    void PauseTiming();
+    void ResumeTiming();
+    void SetBytesPerOp(int64_t nBytes) { nBytesPerOp = nBytes; }                // Adds MB/s column, for hashing and encoding benchmarks
+    void SetError(const std::string& strErrorIn) { strError = strErrorIn; }
+    bool HasError() const { return !strError.empty(); }
+    void Report() const;
+};
+
+typedef void (*BenchFunction)(State&);
+
+class BenchRunner
+{
+    typedef std::map<std::string, BenchFunction> BenchmarkMap;
+    static BenchmarkMap& benchmarks();
+
+public:
+    BenchRunner(const std::string& name, BenchFunction func);
+
+    static int RunAll(const std::string& strFilter, int64_t nMaxElapsed);      // Runs benchmarks with names containing strFilter, returns number of errors
+    static void ListAll();
+};
+
+}
+
+#define BENCHMARK(n) \
+    benchmark::BenchRunner BOOST_PP_CAT(bench_, BOOST_PP_CAT(__LINE__, n))(BOOST_PP_STRINGIZE(n), n);
+
+#endif // AMBER_BENCH_BENCH_H
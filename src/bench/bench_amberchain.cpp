@@ -0,0 +1,90 @@
+// Copyright (c) 2018 Apsaras Group Ltd
+// Amberchain code distributed under the GPLv3 license, see COPYING file.
+
+#include "bench/bench.h"
+#include "bench/chain.h"
+
+#include "crypto/sha256.h"
+#include "keys/key.h"
+#include "keys/pubkey.h"
+#include "multichain/multichain.h"
+#include "utils/random.h"
+#include "utils/util.h"
+
+#include <stdio.h>
+
+#include <boost/filesystem.hpp>
+
+using namespace std;
+
+/** -time default, milliseconds per benchmark */
+static const int64_t DEFAULT_BENCH_TIME = 1000;
+/** -time default with -quick */
+static const int64_t DEFAULT_BENCH_QUICK_TIME = 100;
+
+void ShutdownBenchTxDB();
+
+int main(int argc, char* argv[])
+{
+    SetupEnvironment();
+    fPrintToDebugLog = false;
+
+    mc_gState=new mc_State;
+    mc_gState->m_Params->Parse(argc, argv, MC_ETP_UTIL);
+
+    if (mapArgs.count("-?") || mapArgs.count("-help"))
+    {
+        printf("Usage: bench_amberchain [options]\n\n"
+               "  -filter=<substr>   Run only benchmarks with names containing <substr>\n"
+               "  -list              List benchmarks and exit\n"
+               "  -time=<ms>         Run each benchmark for <ms> milliseconds (default: %d)\n"
+               "  -quick             Short run, used by 'make bench' and 'make check' (default time: %d)\n"
+               "  -datadir=<dir>     Directory for the generated chain, temporary directory is used and removed if not set\n",
+               (int)DEFAULT_BENCH_TIME, (int)DEFAULT_BENCH_QUICK_TIME);
+        delete mc_gState;
+        return 0;
+    }
+
+    if (GetBoolArg("-list", false))
+    {
+        benchmark::BenchRunner::ListAll();
+        delete mc_gState;
+        return 0;
+    }
+
+    printf("Using SHA-256 implementation: %s\n", SHA256AutoDetect().c_str());
+
+    boost::filesystem::path pathTemp;
+    if (!mapArgs.count("-datadir"))
+    {
+        pathTemp = GetTempPath() / strprintf("bench_amberchain_%lu_%d", (unsigned long)GetTime(), (int)GetRand(1000000));
+        boost::filesystem::create_directories(pathTemp);
+        mapArgs["-datadir"] = pathTemp.string();
+    }
+
+    ECC_Start();
+    ECCVerifyHandle *globalVerifyHandle = new ECCVerifyHandle();
+
+    int64_t nMaxElapsed = GetArg("-time", GetBoolArg("-quick", false) ? DEFAULT_BENCH_QUICK_TIME : DEFAULT_BENCH_TIME);
+    int nErrors = benchmark::BenchRunner::RunAll(GetArg("-filter", ""), nMaxElapsed * 1000);
+
+    ShutdownBenchTxDB();
+    ShutdownBenchChain();
+    delete mc_gState;
+
+    delete globalVerifyHandle;
+    ECC_Stop();
+
+    if (!pathTemp.empty())
+    {
+        boost::system::error_code ec;
+        boost::filesystem::remove_all(pathTemp, ec);
+    }
+
+    if (nErrors)
+    {
+        fprintf(stderr, "%d benchmark(s) failed\n", nErrors);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,375 @@
+// Copyright (c) 2018 Apsaras Group Ltd
+// Amberchain code distributed under the GPLv3 license, see COPYING file.
+
+#include "bench/chain.h"
+
+#include "bench/bench.h"
+
+#include "chain/pow.h"
+#include "chainparams/chainparams.h"
+#include "core/init.h"
+#include "core/main.h"
+#include "miner/miner.h"
+#include "multichain/multichain.h"
+#include "script/sign.h"
+#include "script/standard.h"
+#include "storage/txdb.h"
+#include "structs/hash.h"
+#include "utils/util.h"
+#include "utils/utiltime.h"
+#include "wallet/wallet.h"
+#include "wallet/wallettxs.h"
+
+#include <stdio.h>
+
+#include <boost/filesystem.hpp>
+
+using namespace std;
+
+CBlockTemplate* CreateNewBlock(const CScript& scriptPubKeyIn, CWallet *pwallet, CPubKey *ppubkey, int *canMine, CBlockIndex** ppPrev);
+
+/** Stream creation transactions per block */
+static const int BENCH_STREAMS_PER_BLOCK = 250;
+/** Addresses per permission grant transaction */
+static const int BENCH_ADDRESSES_PER_TX = 250;
+/** Addresses per permission grant block */
+static const int BENCH_ADDRESSES_PER_BLOCK = 1000;
+/** Cache of block tree and coin databases */
+static const size_t BENCH_DB_CACHE = 1 << 23;
+
+CBenchChain benchChain;
+
+uint160 BenchAddress(uint32_t n)
+{
+    uint256 hash = Hash(BEGIN(n), END(n));
+    uint160 address;
+    memcpy(address.begin(), hash.begin(), sizeof(uint160));
+    return address;
+}
+
+CTxOut BenchGrantOutput(const uint160& address, const unsigned char* entity_txid, uint32_t type, uint32_t timestamp)
+{
+    mc_Script *lpScript;
+    const unsigned char *elem;
+    size_t elem_size;
+    CScript script = GetScriptForDestination(CKeyID(address));
+
+    lpScript = new mc_Script;
+    if (entity_txid)
+        lpScript->SetEntity(entity_txid + MC_AST_SHORT_TXID_OFFSET);
+    lpScript->SetPermission(type, 0, 4294967295U, timestamp);
+    for (int e = 0; e < lpScript->GetNumElements(); e++)
+    {
+        elem = lpScript->GetData(e, &elem_size);
+        script << vector<unsigned char>(elem, elem + elem_size) << OP_DROP;
+    }
+    delete lpScript;
+
+    return CTxOut(0, script);
+}
+
+static CTxOut StreamOutput(const string& name)
+{
+    mc_Script *lpDetails;
+    mc_Script *lpDetailsScript;
+    const unsigned char *script;
+    const unsigned char *elem;
+    size_t bytes, elem_size;
+    CScript scriptOpReturn;
+
+    lpDetails = new mc_Script;
+    lpDetailsScript = new mc_Script;
+    lpDetails->AddElement();
+    lpDetails->SetSpecialParamValue(MC_ENT_SPRM_NAME, (const unsigned char*)(name.c_str()), name.size());
+    script = lpDetails->GetData(0, &bytes);
+    lpDetailsScript->SetNewEntityType(MC_ENT_TYPE_STREAM, 0, script, bytes);
+    elem = lpDetailsScript->GetData(0, &elem_size);
+    scriptOpReturn << vector<unsigned char>(elem, elem + elem_size) << OP_DROP << OP_RETURN;
+    delete lpDetailsScript;
+    delete lpDetails;
+
+    return CTxOut(0, scriptOpReturn);
+}
+
+bool CBenchChain::Error(const string& strErrorIn)
+{
+    strError = strErrorIn;
+    return false;
+}
+
+bool CBenchChain::InitializeParams()
+{
+    // Permission checks are not bypassed by anyone-can-* flags, single miner is allowed to mine every block
+    char *argv[] = {(char*)"bench_amberchain", (char*)"-anyone-can-connect=0", (char*)"-anyone-can-send=0",
+                    (char*)"-anyone-can-receive=0", (char*)"-mining-diversity=0"};
+
+    boost::system::error_code ec;
+    boost::filesystem::remove_all(GetDataDir(false) / BENCH_CHAIN_NAME, ec);    // Leftovers of the run with the same -datadir
+    boost::filesystem::remove_all(GetDataDir() / "blocks", ec);
+    boost::filesystem::remove_all(GetDataDir() / "chainstate", ec);
+
+    key.MakeNewKey(true);
+    pubkey = key.GetPubKey();
+    scriptKey = GetScriptForDestination(pubkey.GetID());
+
+    if (mc_gState->m_NetworkParams->Read(BENCH_CHAIN_NAME, sizeof(argv) / sizeof(argv[0]), argv, mc_gState->GetProtocolVersion()))
+        return Error("cannot create parameter set");
+    mc_gState->m_NetworkParams->Validate();
+    if (mc_gState->m_NetworkParams->m_Status != MC_PRM_STATUS_GENERATED)
+        return Error("invalid parameter set");
+
+    SelectMultiChainParams(BENCH_CHAIN_NAME);
+    mc_gState->m_NetworkParams->SetGlobals();
+    if (mc_gState->m_NetworkParams->Build(pubkey.begin(), pubkey.size()))
+        return Error("cannot build genesis block");
+    mc_gState->m_NetworkParams->Validate();
+    if (mc_gState->m_NetworkParams->m_Status != MC_PRM_STATUS_VALID)
+        return Error("invalid parameter set after genesis block is built");
+
+    mc_gState->m_NetworkParams->SetGlobals();
+    InitializeMultiChainParams();
+    return true;
+}
+
+bool CBenchChain::InitializeDatabases()
+{
+    mc_gState->m_Permissions = new mc_Permissions;
+    if (mc_gState->m_Permissions->Initialize(BENCH_CHAIN_NAME, 0))
+        return Error("cannot initialize permission database");
+    mc_gState->m_Assets = new mc_AssetDB;
+    if (mc_gState->m_Assets->Initialize(BENCH_CHAIN_NAME, 0))
+        return Error("cannot initialize entity database");
+    pwalletTxsMain = new mc_WalletTxs;                                          // MC_WMD_NONE, block connection doesn't store wallet transactions
+
+    pblocktree = new CBlockTreeDB(BENCH_DB_CACHE, false, true);
+    pcoinsdbview = new CCoinsViewDB(BENCH_DB_CACHE, false, true);
+    pcoinsTip = new CCoinsViewCache(pcoinsdbview);
+    if (!LoadBlockIndex())
+        return Error("cannot load block index");
+    if (!InitBlockIndex())
+        return Error("cannot connect genesis block");
+
+    pwallet = new CWallet;
+    {
+        LOCK(pwallet->cs_wallet);
+        if (!pwallet->AddKeyPubKey(key, pubkey))
+            return Error("cannot add key to wallet");
+    }
+    return true;
+}
+
+// Block 1 with the first block reward, block 2 splits it into BENCH_COIN_COUNT coins
+bool CBenchChain::SplitReward()
+{
+    CBlock block;
+    if (!AssembleBlock(vector<CTransaction>(), block) || !SubmitBlock(block))
+        return false;
+
+    CMutableTransaction tx;
+    for (unsigned int i = 0; i < block.vtx[0].vout.size(); i++)
+    {
+        if (block.vtx[0].vout[i].scriptPubKey == scriptKey)
+        {
+            tx.vin.push_back(CTxIn(COutPoint(block.vtx[0].GetHash(), i)));
+            nCoinValue = block.vtx[0].vout[i].nValue / BENCH_COIN_COUNT;
+        }
+    }
+    if (nCoinValue <= 0)
+        return Error("first block reward is too small");
+
+    for (int i = 0; i < BENCH_COIN_COUNT; i++)
+        tx.vout.push_back(CTxOut(nCoinValue, scriptKey));
+    if (!SignSignature(*pwallet, scriptKey, tx, 0))
+        return Error("cannot sign reward split");
+
+    vector<CTransaction> vtx(1, CTransaction(tx));
+    if (!MineBlock(vtx))
+        return false;
+
+    for (int i = 0; i < BENCH_COIN_COUNT; i++)
+        vCoins.push_back(COutPoint(vtx[0].GetHash(), i));
+    return true;
+}
+
+bool CBenchChain::CreateStreams()
+{
+    if (mc_gState->m_Features->OpDropDetailsScripts() == 0)
+        return Error("protocol version doesn't support stream creation scripts");
+
+    vector<CTransaction> vtx;
+    for (int i = 0; i < BENCH_STREAM_COUNT; i++)
+    {
+        vStreamNames.push_back(strprintf("bench-stream-%d", i));
+        vtx.push_back(SignPayment(i % BENCH_COIN_COUNT, vector<CTxOut>(1, StreamOutput(vStreamNames.back()))));
+        if ((vtx.size() == (size_t)BENCH_STREAMS_PER_BLOCK) || (i + 1 == BENCH_STREAM_COUNT))
+        {
+            if (!MineBlock(vtx))
+                return false;
+            vtx.clear();
+        }
+    }
+
+    mc_EntityDetails entity;
+    if (!mc_gState->m_Assets->FindEntityByName(&entity, vStreamNames[0].c_str()))
+        return Error(strprintf("stream %s not found after creation", vStreamNames[0]));
+    memcpy(streamTxID.begin(), entity.GetTxID(), sizeof(uint256));
+    return true;
+}
+
+// Global connect, send and receive for every address, write to the first stream for every BENCH_STREAM_WRITER_STEP-th
+bool CBenchChain::GrantPermissions()
+{
+    uint32_t timestamp = mc_TimeNowAsUInt();
+    vector<CTransaction> vtx;
+    vector<CTxOut> vGrants;
+    int nCoin = 0;
+
+    for (int i = 0; i < BENCH_ADDRESS_COUNT; i++)
+    {
+        vAddresses.push_back(BenchAddress(i));
+        vGrants.push_back(BenchGrantOutput(vAddresses.back(), NULL, MC_PTP_CONNECT | MC_PTP_SEND | MC_PTP_RECEIVE, timestamp));
+        if ((i % BENCH_STREAM_WRITER_STEP) == 0)
+            vGrants.push_back(BenchGrantOutput(vAddresses.back(), streamTxID.begin(), MC_PTP_WRITE, timestamp));
+
+        if (((i + 1) % BENCH_ADDRESSES_PER_TX == 0) || (i + 1 == BENCH_ADDRESS_COUNT))
+        {
+            vtx.push_back(SignPayment(nCoin++ % BENCH_COIN_COUNT, vGrants));
+            vGrants.clear();
+        }
+        if (((i + 1) % BENCH_ADDRESSES_PER_BLOCK == 0) || (i + 1 == BENCH_ADDRESS_COUNT))
+        {
+            if (!MineBlock(vtx))
+                return false;
+            vtx.clear();
+        }
+    }
+    return true;
+}
+
+bool CBenchChain::Initialize()
+{
+    if (fInitialized)
+        return fReady;
+    fInitialized = true;
+
+    int64_t nStart = GetTimeMillis();
+    fReady = InitializeParams() && InitializeDatabases() && SplitReward() && CreateStreams() && GrantPermissions();
+
+    if (fReady)
+    {
+        LOCK(cs_main);
+        printf("# Chain %s generated in %dms: %d blocks, %d coins, %d streams, %d addresses\n", BENCH_CHAIN_NAME,
+               (int)(GetTimeMillis() - nStart), chainActive.Height() + 1, (int)vCoins.size(), (int)vStreamNames.size(), (int)vAddresses.size());
+    }
+    else
+    {
+        fprintf(stderr, "Cannot generate chain %s: %s\n", BENCH_CHAIN_NAME, strError.c_str());
+    }
+    return fReady;
+}
+
+void CBenchChain::Shutdown()
+{
+    if (pcoinsdbview)
+    {
+        LOCK(cs_main);
+        mempool.clear();
+        FlushStateToDisk();
+        UnloadBlockIndex();
+        delete pcoinsTip;
+        pcoinsTip = NULL;
+        delete pcoinsdbview;
+        pcoinsdbview = NULL;
+        delete pblocktree;
+        pblocktree = NULL;
+    }
+    if (pwalletTxsMain)
+    {
+        delete pwalletTxsMain;
+        pwalletTxsMain = NULL;
+    }
+    if (pwallet)
+    {
+        delete pwallet;
+        pwallet = NULL;
+    }
+    fReady = false;
+}
+
+bool InitializeBenchChain(benchmark::State& state)
+{
+    if (benchChain.Initialize())
+        return true;
+    state.SetError(benchChain.strError);
+    return false;
+}
+
+void ShutdownBenchChain()
+{
+    benchChain.Shutdown();
+}
+
+CTransaction CBenchChain::SignPayment(int nCoin, const vector<CTxOut>& vExtraOutputs) const
+{
+    CMutableTransaction tx;
+    tx.vin.push_back(CTxIn(vCoins[nCoin]));
+    tx.vout.push_back(CTxOut(nCoinValue, scriptKey));
+    tx.vout.insert(tx.vout.end(), vExtraOutputs.begin(), vExtraOutputs.end());
+    SignSignature(*pwallet, scriptKey, tx, 0);
+    return CTransaction(tx);
+}
+
+bool CBenchChain::AssembleBlock(const vector<CTransaction>& vtx, CBlock& block)
+{
+    for (unsigned int i = 0; i < vtx.size(); i++)
+    {
+        CValidationState state;
+        if (!AcceptToMemoryPool(mempool, state, vtx[i], false, NULL, false, false))
+            return Error(strprintf("transaction %s is rejected: %s", vtx[i].GetHash().ToString(), state.GetRejectReason()));
+    }
+
+    CBlockTemplate *pblocktemplate = CreateNewBlock(scriptKey, pwallet, &pubkey, NULL, NULL);
+    if (pblocktemplate == NULL)
+        return Error("cannot create block template");
+    block = pblocktemplate->block;
+    delete pblocktemplate;
+    if (block.vtx.size() != vtx.size() + 1)
+        return Error(strprintf("block template has %d of %d transactions", (int)block.vtx.size() - 1, (int)vtx.size()));
+
+    {
+        LOCK(cs_main);
+        IncrementExtraNonce(&block, chainActive.Tip(), nExtraNonce, pwallet);
+    }
+    while (!CheckProofOfWork(block.GetHash(), block.nBits, true))
+        ++block.nNonce;
+    return true;
+}
+
+bool CBenchChain::SubmitBlock(CBlock& block)
+{
+    CValidationState state;
+    if (!ProcessNewBlock(state, NULL, &block))
+        return Error(strprintf("block %s is rejected: %s", block.GetHash().ToString(), state.GetRejectReason()));
+
+    LOCK(cs_main);
+    if (chainActive.Tip()->GetBlockHash() != block.GetHash())
+        return Error(strprintf("block %s is not connected", block.GetHash().ToString()));
+    return true;
+}
+
+bool CBenchChain::MineBlock(const vector<CTransaction>& vtx)
+{
+    CBlock block;
+    if (!AssembleBlock(vtx, block) || !SubmitBlock(block))
+        return false;
+    UpdateCoins(vtx);
+    return true;
+}
+
+void CBenchChain::UpdateCoins(const vector<CTransaction>& vtx)
+{
+    for (unsigned int i = 0; i < vtx.size(); i++)
+        for (unsigned int j = 0; j < vCoins.size(); j++)
+            if (vtx[i].vin[0].prevout == vCoins[j])
+                vCoins[j] = COutPoint(vtx[i].GetHash(), 0);
+}
@@ -0,0 +1,99 @@
+// Copyright (c) 2018 Apsaras Group Ltd
+// Amberchain code distributed under the GPLv3 license, see COPYING file.
+
+#ifndef AMBER_BENCH_CHAIN_H
+#define AMBER_BENCH_CHAIN_H
+
+#include "keys/key.h"
+#include "keys/pubkey.h"
+#include "primitives/block.h"
+#include "primitives/transaction.h"
+#include "script/script.h"
+#include "structs/amount.h"
+#include "structs/uint256.h"
+
+#include <string>
+#include <vector>
+
+class CCoinsViewDB;
+class CWallet;
+
+namespace benchmark {
+class State;
+}
+
+/**
+ * Generated chain of validation and ledger benchmarks.
+ *
+ * Parameter set BENCH_CHAIN_NAME is created in the bench data directory and its genesis block is built
+ * for a key generated on the run. Blocks mined by this key with ordinary signed transactions split the
+ * first block reward into BENCH_COIN_COUNT coins, create BENCH_STREAM_COUNT streams and grant permissions
+ * to BENCH_ADDRESS_COUNT addresses, so permission and entity databases are filled by the same code paths
+ * as on a node. The chain is built on first use and kept until ShutdownBenchChain().
+ */
+
+static const char* const BENCH_CHAIN_NAME = "benchchain";
+/** Coins of the miner key, every benchmark transaction spends one of them */
+static const int BENCH_COIN_COUNT = 2000;
+/** Streams created by the miner key */
+static const int BENCH_STREAM_COUNT = 1000;
+/** Addresses with global connect, send and receive permissions */
+static const int BENCH_ADDRESS_COUNT = 5000;
+/** Every BENCH_STREAM_WRITER_STEP-th address can write to the first stream */
+static const int BENCH_STREAM_WRITER_STEP = 4;
+
+class CBenchChain
+{
+public:
+    bool fInitialized;
+    bool fReady;
+    std::string strError;                                                       // Why the chain is not ready, reported by every benchmark using it
+    CKey key;                                                                   // Genesis key, admin and the only miner
+    CPubKey pubkey;
+    CScript scriptKey;
+    CWallet *pwallet;                                                           // Keystore of the key, used for block signatures
+    std::vector<uint160> vAddresses;
+    std::vector<std::string> vStreamNames;
+    uint256 streamTxID;                                                         // Creation txid of vStreamNames[0]
+    std::vector<COutPoint> vCoins;                                              // Unspent outputs of nCoinValue paying to scriptKey
+    CAmount nCoinValue;
+
+    CBenchChain() : fInitialized(false), fReady(false), pwallet(NULL), nCoinValue(0), pcoinsdbview(NULL), nExtraNonce(0) {}
+
+    bool Initialize();
+    void Shutdown();
+
+    /** Transaction spending vCoins[nCoin] to scriptKey without fee, followed by optional extra outputs */
+    CTransaction SignPayment(int nCoin, const std::vector<CTxOut>& vExtraOutputs = std::vector<CTxOut>()) const;
+    /** Accepts transactions to the mempool, builds signed block template with all of them and solves it */
+    bool AssembleBlock(const std::vector<CTransaction>& vtx, CBlock& block);
+    /** Processes assembled block, it should become the new tip */
+    bool SubmitBlock(CBlock& block);
+    bool MineBlock(const std::vector<CTransaction>& vtx);
+    /** Replaces coins spent by mined SignPayment() transactions with their change outputs */
+    void UpdateCoins(const std::vector<CTransaction>& vtx);
+
+private:
+    CCoinsViewDB *pcoinsdbview;                                                 // Backend of pcoinsTip
+    unsigned int nExtraNonce;
+
+    bool Error(const std::string& strErrorIn);
+    bool InitializeParams();
+    bool InitializeDatabases();
+    bool SplitReward();
+    bool CreateStreams();
+    bool GrantPermissions();
+};
+
+extern CBenchChain benchChain;
+
+/** Generates the chain if needed, benchmark is reported as error if it cannot be generated */
+bool InitializeBenchChain(benchmark::State& state);
+void ShutdownBenchChain();
+
+/** Address without key, n-th of the addresses with permissions, addresses from BENCH_ADDRESS_COUNT up have none */
+uint160 BenchAddress(uint32_t n);
+/** Zero-value output granting permission type to address, for entity if entity_txid is not NULL */
+CTxOut BenchGrantOutput(const uint160& address, const unsigned char* entity_txid, uint32_t type, uint32_t timestamp);
+
+#endif // AMBER_BENCH_CHAIN_H
@@ -0,0 +1,81 @@
+// Copyright (c) 2018 Apsaras Group Ltd
+// Amberchain code distributed under the GPLv3 license, see COPYING file.
+
+#include "bench/bench.h"
+
+#include "crypto/sha256.h"
+#include "structs/hash.h"
+#include "structs/uint256.h"
+
+#include <vector>
+
+/** Input of one hashing operation */
+static const size_t BENCH_HASH_BUFFER_SIZE = 1000000;
+/** 64-byte blocks hashed by one SHA256D64 call, same as for merkle tree of 2048 transactions */
+static const size_t BENCH_D64_BLOCKS = 1024;
+
+static void SHA256Implementation(benchmark::State& state, const char *implementation)
+{
+    if (!SHA256Select(implementation))                                          // Not compiled in or not supported by CPU
+        return;
+
+    std::vector<unsigned char> in(BENCH_HASH_BUFFER_SIZE, 0);
+    unsigned char hash[CSHA256::OUTPUT_SIZE];
+    state.SetBytesPerOp(in.size());
+    while (state.KeepRunning())
+    {
+        CSHA256().Write(&in[0], in.size()).Finalize(hash);
+    }
+
+    SHA256AutoDetect();
+}
+
+static void SHA256_standard(benchmark::State& state)
+{
+    SHA256Implementation(state, "standard");
+}
+
+static void SHA256_sse41(benchmark::State& state)
+{
+    SHA256Implementation(state, "sse4.1");
+}
+
+static void SHA256_avx2(benchmark::State& state)
+{
+    SHA256Implementation(state, "avx2");
+}
+
+static void SHA256_shani(benchmark::State& state)
+{
+    SHA256Implementation(state, "shani");
+}
+
+static void SHA256D64_1024(benchmark::State& state)
+{
+    std::vector<unsigned char> in(BENCH_D64_BLOCKS * 64, 0);
+    std::vector<unsigned char> out(BENCH_D64_BLOCKS * 32, 0);
+    state.SetBytesPerOp(in.size());
+    while (state.KeepRunning())
+    {
+        SHA256D64(&out[0], &in[0], BENCH_D64_BLOCKS);
+    }
+}
+
+static void HashTransactionSized(benchmark::State& state)
+{
+    std::vector<unsigned char> in(250, 0);                                      // Typical transaction size
+    uint256 hash;
+    state.SetBytesPerOp(in.size());
+    while (state.KeepRunning())
+    {
+        hash = Hash(in.begin(), in.end());
+        in[0] = hash.begin()[0];
+    }
+}
+
+BENCHMARK(SHA256_standard);
+BENCHMARK(SHA256_sse41);
+BENCHMARK(SHA256_avx2);
+BENCHMARK(SHA256_shani);
+BENCHMARK(SHA256D64_1024);
+BENCHMARK(HashTransactionSized);
@@ -0,0 +1,128 @@
+// Copyright (c) 2018 Apsaras Group Ltd
+// Amberchain code distributed under the GPLv3 license, see COPYING file.
+
+#include "bench/bench.h"
+
+#include "json/json_spirit_reader_template.h"
+#include "json/json_spirit_utils.h"
+#include "json/json_spirit_value.h"
+#include "json/json_spirit_writer_template.h"
+#include "multichain/multichain.h"
+#include "utils/util.h"
+
+using namespace std;
+using namespace json_spirit;
+
+int ubjson_write(Value json_value,mc_Script *lpScript,int max_depth);
+Value ubjson_read(const unsigned char *elem,size_t elem_size,int max_depth,int *err);
+
+static const int BENCH_JSON_MAX_DEPTH = 100;
+
+// Stream item payload shaped like a purchase record: nested objects, array of items, strings and numbers
+static Value MakeBenchJSONValue()
+{
+    Object obj;
+    obj.push_back(Pair("id", "9f3c6a1e-55b0-4d8e-9a49-2f7c1d0b6e13"));
+    obj.push_back(Pair("timestamp", (int64_t)1530000000));
+    obj.push_back(Pair("currency", "GBP"));
+    obj.push_back(Pair("total", 1234.56));
+    obj.push_back(Pair("confirmed", true));
+    obj.push_back(Pair("note", Value::null));
+
+    Object customer;
+    customer.push_back(Pair("name", "Bench Customer"));
+    customer.push_back(Pair("address", "1AbCdEfGhIjKlMnOpQrStUvWxYz123456"));
+    customer.push_back(Pair("country", "GB"));
+    obj.push_back(Pair("customer", customer));
+
+    Array items;
+    for (int i = 0; i < 16; i++)
+    {
+        Object item;
+        item.push_back(Pair("sku", strprintf("SKU-%06d", i * 37)));
+        item.push_back(Pair("description", "Synthetic item used by bench_amberchain"));
+        item.push_back(Pair("quantity", i + 1));
+        item.push_back(Pair("price", 9.99 + i));
+        items.push_back(item);
+    }
+    obj.push_back(Pair("items", items));
+
+    Array tags;
+    tags.push_back("bench");
+    tags.push_back("purchase");
+    tags.push_back("synthetic");
+    obj.push_back(Pair("tags", tags));
+
+    return obj;
+}
+
+static void JSONEncode(benchmark::State& state)
+{
+    Value value = MakeBenchJSONValue();
+    state.SetBytesPerOp(write_string(value, false).size());
+    while (state.KeepRunning())
+    {
+        std::string str = write_string(value, false);
+    }
+}
+
+static void JSONDecode(benchmark::State& state)
+{
+    std::string str = write_string(MakeBenchJSONValue(), false);
+    state.SetBytesPerOp(str.size());
+    while (state.KeepRunning())
+    {
+        Value value;
+        read_string(str, value);
+    }
+}
+
+static void UBJSONEncode(benchmark::State& state)
+{
+    Value value = MakeBenchJSONValue();
+    mc_Script *lpScript = new mc_Script;
+    size_t size = 0;
+
+    lpScript->Clear();
+    lpScript->AddElement();
+    if (ubjson_write(value, lpScript, BENCH_JSON_MAX_DEPTH) == MC_ERR_NOERROR)
+        lpScript->GetData(0, &size);
+    state.SetBytesPerOp(size);
+
+    while (state.KeepRunning())
+    {
+        lpScript->Clear();
+        lpScript->AddElement();
+        ubjson_write(value, lpScript, BENCH_JSON_MAX_DEPTH);
+    }
+    delete lpScript;
+}
+
+static void UBJSONDecode(benchmark::State& state)
+{
+    mc_Script *lpScript = new mc_Script;
+    const unsigned char *ptr;
+    size_t size;
+    int err;
+
+    lpScript->Clear();
+    lpScript->AddElement();
+    if (ubjson_write(MakeBenchJSONValue(), lpScript, BENCH_JSON_MAX_DEPTH) != MC_ERR_NOERROR)
+    {
+        delete lpScript;
+        return;
+    }
+    ptr = lpScript->GetData(0, &size);
+    state.SetBytesPerOp(size);
+
+    while (state.KeepRunning())
+    {
+        Value value = ubjson_read(ptr, size, BENCH_JSON_MAX_DEPTH, &err);
+    }
+    delete lpScript;
+}
+
+BENCHMARK(JSONEncode);
+BENCHMARK(JSONDecode);
+BENCHMARK(UBJSONEncode);
+BENCHMARK(UBJSONDecode);
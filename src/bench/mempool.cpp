@@ -0,0 +1,102 @@
+// Copyright (c) 2018 Apsaras Group Ltd
+// Amberchain code distributed under the GPLv3 license, see COPYING file.
+
+#include "bench/bench.h"
+
+#include "chain/txmempool.h"
+#include "primitives/transaction.h"
+#include "script/script.h"
+#include "structs/hash.h"
+#include "utils/utilstrencodings.h"
+#include "utils/utiltime.h"
+
+#include <list>
+#include <vector>
+
+/** Number of transactions in the pool while measuring */
+static const int BENCH_MEMPOOL_SIZE = 100000;
+
+static CTransaction MakeBenchTransaction(uint32_t n)
+{
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.vin[0].prevout.hash = Hash(BEGIN(n), END(n));
+    tx.vin[0].prevout.n = 0;
+    tx.vin[0].scriptSig = CScript() << std::vector<unsigned char>(72, 0x30) << std::vector<unsigned char>(33, 0x02);
+    tx.vout.resize(1);
+    tx.vout[0].nValue = 0;
+    tx.vout[0].scriptPubKey = CScript() << OP_DUP << OP_HASH160 << std::vector<unsigned char>(20, (unsigned char)n) << OP_EQUALVERIFY << OP_CHECKSIG;
+    return CTransaction(tx);
+}
+
+static void FillBenchMempool(CTxMemPool& pool, std::vector<CTransaction>& vtx, int nCount)
+{
+    int64_t nTime = GetTime();
+    vtx.reserve(vtx.size() + nCount);
+    for (int i = 0; i < nCount; i++)
+    {
+        vtx.push_back(MakeBenchTransaction(vtx.size()));
+        pool.addUnchecked(vtx.back().GetHash(), CTxMemPoolEntry(vtx.back(), 1000, nTime, 0, 1));
+    }
+}
+
+// Add and remove of one transaction while BENCH_MEMPOOL_SIZE transactions are in the pool
+static void MempoolAddRemove(benchmark::State& state)
+{
+    CTxMemPool pool(CFeeRate(0));
+    std::vector<CTransaction> vtx;
+    FillBenchMempool(pool, vtx, BENCH_MEMPOOL_SIZE);
+
+    std::vector<CTransaction> vtxExtra;
+    for (int i = 0; i < 1024; i++)
+        vtxExtra.push_back(MakeBenchTransaction(BENCH_MEMPOOL_SIZE + i));
+
+    int64_t nTime = GetTime();
+    size_t n = 0;
+    std::list<CTransaction> removed;
+    while (state.KeepRunning())
+    {
+        const CTransaction& tx = vtxExtra[n++ % vtxExtra.size()];
+        pool.addUnchecked(tx.GetHash(), CTxMemPoolEntry(tx, 1000, nTime, 0, 1));
+        removed.clear();
+        pool.remove(tx, removed);
+    }
+}
+
+static void MempoolLookup(benchmark::State& state)
+{
+    CTxMemPool pool(CFeeRate(0));
+    std::vector<CTransaction> vtx;
+    FillBenchMempool(pool, vtx, BENCH_MEMPOOL_SIZE);
+
+    size_t n = 0;
+    CTransaction tx;
+    while (state.KeepRunning())
+    {
+        const uint256& hash = vtx[(n * 7919) % vtx.size()].GetHash();
+        n++;
+        if (pool.exists(hash))
+            pool.lookup(hash, tx);
+    }
+}
+
+static void MempoolLookupMissing(benchmark::State& state)
+{
+    CTxMemPool pool(CFeeRate(0));
+    std::vector<CTransaction> vtx;
+    FillBenchMempool(pool, vtx, BENCH_MEMPOOL_SIZE);
+
+    std::vector<uint256> vMissing;
+    for (int i = 0; i < 1024; i++)
+        vMissing.push_back(MakeBenchTransaction(BENCH_MEMPOOL_SIZE + i).GetHash());
+
+    size_t n = 0;
+    while (state.KeepRunning())
+    {
+        pool.exists(vMissing[n++ % vMissing.size()]);
+    }
+}
+
+BENCHMARK(MempoolAddRemove);
+BENCHMARK(MempoolLookup);
+BENCHMARK(MempoolLookupMissing);
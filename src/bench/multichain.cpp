@@ -0,0 +1,209 @@
+// Copyright (c) 2018 Apsaras Group Ltd
+// Amberchain code distributed under the GPLv3 license, see COPYING file.
+
+#include "bench/bench.h"
+#include "bench/chain.h"
+
+#include "multichain/multichain.h"
+#include "primitives/transaction.h"
+#include "script/script.h"
+#include "structs/hash.h"
+#include "structs/uint256.h"
+#include "utils/streams.h"
+#include "utils/util.h"
+#include "utils/utilstrencodings.h"
+#include "utils/utiltime.h"
+#include "version/clientversion.h"
+#include "wallet/wallettxdb.h"
+
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+using namespace std;
+
+/**
+ * Wallet transaction database of one address, filled directly in BENCH_TXDB_NAME directory of the bench data
+ * directory on first use and kept until ShutdownBenchTxDB(). Permission and entity benchmarks use the generated chain.
+ */
+
+static const char *BENCH_TXDB_NAME = "benchtxdb";
+/** Transactions of wallet entity, last block is not committed and is read from mempool */
+static const int BENCH_TXDB_TX_COUNT = 20000;
+/** Transactions per wallet transaction database block */
+static const int BENCH_TXDB_TXS_PER_BLOCK = 1000;
+
+class CBenchTxDB
+{
+public:
+    bool fInitialized;
+    bool fReady;
+    mc_TxDB *pTxDB;
+    mc_TxEntity walletEntity;
+
+    CBenchTxDB() : fInitialized(false), fReady(false), pTxDB(NULL) {}
+
+    bool Initialize();
+    void Shutdown();
+};
+
+static CBenchTxDB benchTxDB;
+
+bool CBenchTxDB::Initialize()
+{
+    if (fInitialized)
+        return fReady;
+    fInitialized = true;
+
+    mc_Buffer *lpEntities;
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    uint32_t nTimestamp = GetTime();
+    uint160 address = BenchAddress(0);
+    int err = MC_ERR_NOERROR;
+
+    boost::system::error_code ec;
+    boost::filesystem::remove_all(GetDataDir(false) / BENCH_TXDB_NAME, ec);     // Leftovers of the run with the same -datadir
+    boost::filesystem::create_directories(GetDataDir(false) / BENCH_TXDB_NAME / "wallet", ec);
+
+    pTxDB = new mc_TxDB;
+    if (pTxDB->Initialize(BENCH_TXDB_NAME, 0))
+        return false;
+
+    walletEntity.Zero();
+    walletEntity.Init(address.begin(), MC_TET_PUBKEY_ADDRESS | MC_TET_CHAINPOS);
+    if (pTxDB->AddEntity(&walletEntity, 0))
+        return false;
+
+    lpEntities = new mc_Buffer;
+    lpEntities->Initialize(sizeof(mc_TxEntity), sizeof(mc_TxEntity), MC_BUF_MODE_MAP);
+    lpEntities->Add(&walletEntity, NULL);
+
+    pTxDB->Lock(1, 0);
+    for (int i = 0; (i < BENCH_TXDB_TX_COUNT) && (err == MC_ERR_NOERROR); i++)
+    {
+        CMutableTransaction tx;
+        tx.vin.resize(1);
+        tx.vin[0].prevout.hash = Hash(BEGIN(i), END(i));
+        tx.vout.resize(1);
+        tx.vout[0].scriptPubKey = CScript() << OP_DUP << OP_HASH160 << ToByteVector(address) << OP_EQUALVERIFY << OP_CHECKSIG;
+
+        uint256 hash = tx.GetHash();
+        ss.clear();
+        ss << tx;
+        err = pTxDB->AddTx(NULL, (unsigned char*)&hash, (unsigned char*)&ss[0], ss.size(), ss.size(), -1, -1, 0, 0, 0, 0, nTimestamp, lpEntities);
+
+        if ((err == MC_ERR_NOERROR) && ((i + 1) % BENCH_TXDB_TXS_PER_BLOCK == 0) && (i + 1 < BENCH_TXDB_TX_COUNT))
+            err = pTxDB->Commit(NULL);
+    }
+    pTxDB->UnLock();
+
+    delete lpEntities;
+    fReady = (err == MC_ERR_NOERROR);
+    return fReady;
+}
+
+void CBenchTxDB::Shutdown()
+{
+    if (pTxDB)
+    {
+        delete pTxDB;
+        pTxDB = NULL;
+    }
+    fReady = false;
+}
+
+void ShutdownBenchTxDB()
+{
+    benchTxDB.Shutdown();
+}
+
+static void PermissionsCanSend(benchmark::State& state)
+{
+    if (!InitializeBenchChain(state))
+        return;
+
+    size_t n = 0;
+    while (state.KeepRunning())
+    {
+        mc_gState->m_Permissions->CanSend(NULL, benchChain.vAddresses[(n++ * 7919) % benchChain.vAddresses.size()].begin());
+    }
+}
+
+static void PermissionsCanWriteStream(benchmark::State& state)
+{
+    if (!InitializeBenchChain(state))
+        return;
+
+    size_t n = 0;
+    while (state.KeepRunning())
+    {
+        mc_gState->m_Permissions->CanWrite(benchChain.streamTxID.begin(), benchChain.vAddresses[(n++ * 7919) % benchChain.vAddresses.size()].begin());
+    }
+}
+
+static void PermissionsGetAll(benchmark::State& state)
+{
+    if (!InitializeBenchChain(state))
+        return;
+
+    size_t n = 0;
+    while (state.KeepRunning())
+    {
+        mc_gState->m_Permissions->GetAllPermissions(NULL, benchChain.vAddresses[(n++ * 7919) % benchChain.vAddresses.size()].begin(), MC_PTP_ALL);
+    }
+}
+
+static void AssetDBFindEntityByName(benchmark::State& state)
+{
+    if (!InitializeBenchChain(state))
+        return;
+
+    mc_EntityDetails entity;
+    size_t n = 0;
+    while (state.KeepRunning())
+    {
+        mc_gState->m_Assets->FindEntityByName(&entity, benchChain.vStreamNames[(n++ * 7919) % benchChain.vStreamNames.size()].c_str());
+    }
+}
+
+static void TxDBGetListLast(benchmark::State& state)
+{
+    if (!benchTxDB.Initialize())
+    {
+        state.SetError("cannot fill wallet transaction database");
+        return;
+    }
+
+    mc_Buffer *lpEntRowBuffer = new mc_Buffer;
+    lpEntRowBuffer->Initialize(MC_TDB_ENTITY_KEY_SIZE, sizeof(mc_TxEntityRow), MC_BUF_MODE_DEFAULT);
+    while (state.KeepRunning())
+    {
+        benchTxDB.pTxDB->GetList(&benchTxDB.walletEntity, 0, 10, lpEntRowBuffer);
+    }
+    delete lpEntRowBuffer;
+}
+
+static void TxDBGetListPage(benchmark::State& state)
+{
+    if (!benchTxDB.Initialize())
+    {
+        state.SetError("cannot fill wallet transaction database");
+        return;
+    }
+
+    mc_Buffer *lpEntRowBuffer = new mc_Buffer;
+    lpEntRowBuffer->Initialize(MC_TDB_ENTITY_KEY_SIZE, sizeof(mc_TxEntityRow), MC_BUF_MODE_DEFAULT);
+    size_t n = 0;
+    while (state.KeepRunning())
+    {
+        benchTxDB.pTxDB->GetList(&benchTxDB.walletEntity, 1 + (n++ * 7919) % (BENCH_TXDB_TX_COUNT - BENCH_TXDB_TXS_PER_BLOCK - 10), 10, lpEntRowBuffer);
+    }
+    delete lpEntRowBuffer;
+}
+
+BENCHMARK(PermissionsCanSend);
+BENCHMARK(PermissionsCanWriteStream);
+BENCHMARK(PermissionsGetAll);
+BENCHMARK(AssetDBFindEntityByName);
+BENCHMARK(TxDBGetListLast);
+BENCHMARK(TxDBGetListPage);
@@ -0,0 +1,72 @@
+// Copyright (c) 2018 Apsaras Group Ltd
+// Amberchain code distributed under the GPLv3 license, see COPYING file.
+
+#include "bench/bench.h"
+
+#include "json/json_spirit_value.h"
+#include "rpc/rpcserver.h"
+
+using namespace std;
+using namespace json_spirit;
+
+/** Elements in one batch request */
+static const int BENCH_RPC_BATCH_SIZE = 64;
+/** Batch worker threads for concurrent run, same as -rpcbatchthreads default */
+static const int BENCH_RPC_BATCH_THREADS = 4;
+
+static void InitBenchRPCTable()
+{
+    static bool fInitialized = false;
+    if (fInitialized)
+        return;
+    mc_InitRPCList(vStaticRPCCommands, vStaticRPCWalletReadCommands);
+    tableRPC.initialize();
+    fInitialized = true;
+}
+
+// Read-only calls not requiring chain data, getblockcount takes cs_main in CRPCTable::execute
+static Array MakeBenchBatch()
+{
+    const char *methods[] = { "getnettotals", "getmempoolinfo", "estimatefee", "getblockcount" };
+    Array vReq;
+    for (int i = 0; i < BENCH_RPC_BATCH_SIZE; i++)
+    {
+        Object req;
+        Array params;
+        const char *method = methods[i % (sizeof(methods) / sizeof(methods[0]))];
+        if (string(method) == "estimatefee")
+            params.push_back(6);
+        req.push_back(Pair("method", method));
+        req.push_back(Pair("params", params));
+        req.push_back(Pair("id", i));
+        vReq.push_back(req);
+    }
+    return vReq;
+}
+
+static void RPCBatchRun(benchmark::State& state, int nThreads)
+{
+    InitBenchRPCTable();
+    StartRPCBatchThreads(nThreads);
+
+    Array vReq = MakeBenchBatch();
+    while (state.KeepRunning())
+    {
+        string strReply = JSONRPCExecBatch(vReq);
+    }
+
+    StopRPCBatchThreads();
+}
+
+static void RPCBatchSequential(benchmark::State& state)
+{
+    RPCBatchRun(state, 0);
+}
+
+static void RPCBatchConcurrent(benchmark::State& state)
+{
+    RPCBatchRun(state, BENCH_RPC_BATCH_THREADS);
+}
+
+BENCHMARK(RPCBatchSequential);
+BENCHMARK(RPCBatchConcurrent);
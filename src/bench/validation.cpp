@@ -0,0 +1,163 @@
+// Copyright (c) 2018 Apsaras Group Ltd
+// Amberchain code distributed under the GPLv3 license, see COPYING file.
+
+#include "bench/bench.h"
+#include "bench/chain.h"
+
+#include "core/main.h"
+#include "multichain/multichain.h"
+#include "utils/util.h"
+
+#include <vector>
+
+using namespace std;
+
+bool AcceptMultiChainTransaction(const CTransaction& tx,
+                                 const CCoinsViewCache &inputs,
+                                 int offset,
+                                 bool accept,
+                                 string& reason,
+                                 uint32_t *replay);
+
+/** Transactions per block of block connection benchmarks */
+static const int BENCH_BLOCK_TX_COUNT = 200;
+/** Addresses per permission grant transaction */
+static const int BENCH_GRANT_ADDRESS_COUNT = 100;
+
+// Permission and entity checks of one transaction, changes are rolled back as accept=false
+static void CheckMultiChainTransaction(benchmark::State& state, const CTransaction& tx)
+{
+    string reason;
+
+    LOCK(cs_main);
+    CCoinsViewCache view(pcoinsTip);
+    while (state.KeepRunning())
+    {
+        if (!AcceptMultiChainTransaction(tx, view, -1, false, reason, NULL))
+        {
+            state.SetError(strprintf("transaction %s is rejected: %s", tx.GetHash().ToString(), reason));
+            return;
+        }
+    }
+}
+
+static void AcceptMultiChainTransactionPayment(benchmark::State& state)
+{
+    if (!InitializeBenchChain(state))
+        return;
+
+    CheckMultiChainTransaction(state, benchChain.SignPayment(0));
+}
+
+static void AcceptMultiChainTransactionGrant(benchmark::State& state)
+{
+    if (!InitializeBenchChain(state))
+        return;
+
+    vector<CTxOut> vGrants;
+    for (int i = 0; i < BENCH_GRANT_ADDRESS_COUNT; i++)
+        vGrants.push_back(BenchGrantOutput(BenchAddress(BENCH_ADDRESS_COUNT + i), NULL, MC_PTP_CONNECT | MC_PTP_SEND, mc_TimeNowAsUInt()));
+
+    CheckMultiChainTransaction(state, benchChain.SignPayment(0, vGrants));
+}
+
+// Signed payments from all coins, pool is cleared when all of them are accepted
+static void AcceptToMemoryPoolPayment(benchmark::State& state)
+{
+    if (!InitializeBenchChain(state))
+        return;
+
+    vector<CTransaction> vtx;
+    for (int i = 0; i < BENCH_COIN_COUNT; i++)
+        vtx.push_back(benchChain.SignPayment(i));
+
+    size_t n = 0;
+    while (state.KeepRunning())
+    {
+        if (n == vtx.size())
+        {
+            state.PauseTiming();
+            ClearMemPools();
+            state.ResumeTiming();
+            n = 0;
+        }
+        CValidationState vstate;
+        if (!AcceptToMemoryPool(mempool, vstate, vtx[n], false, NULL, false, false))
+        {
+            state.SetError(strprintf("transaction %s is rejected: %s", vtx[n].GetHash().ToString(), vstate.GetRejectReason()));
+            break;
+        }
+        n++;
+    }
+    ClearMemPools();
+}
+
+// ConnectBlock with fJustCheck, as called by TestBlockValidity: coins and block rules,
+// scripts and permissions are checked on acceptance to the mempool and are skipped
+static void ConnectBlockCheck(benchmark::State& state)
+{
+    if (!InitializeBenchChain(state))
+        return;
+
+    vector<CTransaction> vtx;
+    for (int i = 0; i < BENCH_BLOCK_TX_COUNT; i++)
+        vtx.push_back(benchChain.SignPayment(i));
+
+    CBlock block;
+    bool fAssembled = benchChain.AssembleBlock(vtx, block);
+    ClearMemPools();
+    if (!fAssembled)
+    {
+        state.SetError(benchChain.strError);
+        return;
+    }
+
+    LOCK(cs_main);
+    while (state.KeepRunning())
+    {
+        CValidationState vstate;
+        if (!TestBlockValidity(vstate, block, chainActive.Tip(), false, false))
+        {
+            state.SetError(strprintf("block %s is rejected: %s", block.GetHash().ToString(), vstate.GetRejectReason()));
+            return;
+        }
+    }
+}
+
+// Full connection of the new tip: signatures, scripts, permissions, commit to databases and mempool cleanup.
+// Transactions of the next block are signed and accepted to the mempool while timing is paused
+static void ProcessNewBlockPayments(benchmark::State& state)
+{
+    if (!InitializeBenchChain(state))
+        return;
+
+    int nNextCoin = 0;
+    while (state.KeepRunning())
+    {
+        state.PauseTiming();
+        vector<CTransaction> vtx;
+        for (int i = 0; i < BENCH_BLOCK_TX_COUNT; i++)
+            vtx.push_back(benchChain.SignPayment((nNextCoin + i) % BENCH_COIN_COUNT));
+        nNextCoin = (nNextCoin + BENCH_BLOCK_TX_COUNT) % BENCH_COIN_COUNT;
+
+        CBlock block;
+        bool fAssembled = benchChain.AssembleBlock(vtx, block);
+        state.ResumeTiming();
+
+        if (!fAssembled || !benchChain.SubmitBlock(block))
+        {
+            state.SetError(benchChain.strError);
+            break;
+        }
+        state.PauseTiming();
+        benchChain.UpdateCoins(vtx);
+        state.ResumeTiming();
+    }
+    ClearMemPools();
+}
+
+BENCHMARK(AcceptMultiChainTransactionPayment);
+BENCHMARK(AcceptMultiChainTransactionGrant);
+BENCHMARK(AcceptToMemoryPoolPayment);
+BENCHMARK(ConnectBlockCheck);
+BENCHMARK(ProcessNewBlockPayments);
@@ -34,8 +34,29 @@ void InvalidMempoolWTx(const uint256& wtxid, const char * reason)
 }
 //void InvalidWTx(const uint256& wtxid, const char * reason);
 
+/* AMB START */
+/**
+ * Estimated memory used by mempool entry, its nodes in mapTx, mapNextTx and eviction index and its hashList row
+ */
+static size_t EstimateEntryUsage(const CTransaction& tx)
+{
+    // Tree node: three pointers and color, rounded up by allocator
+    static const size_t nNodeOverhead = 4 * sizeof(void*);
+    
+    size_t nUsage = sizeof(uint256) + sizeof(CTxMemPoolEntry) + nNodeOverhead;
+    nUsage += sizeof(std::pair<std::pair<double, int64_t>, uint256>) + nNodeOverhead;
+    nUsage += sizeof(uint256);
+    nUsage += tx.vin.capacity() * sizeof(CTxIn) + tx.vout.capacity() * sizeof(CTxOut);
+    for (unsigned int i = 0; i < tx.vin.size(); i++)
+        nUsage += tx.vin[i].scriptSig.capacity() + sizeof(COutPoint) + sizeof(CInPoint) + nNodeOverhead;
+    for (unsigned int i = 0; i < tx.vout.size(); i++)
+        nUsage += tx.vout[i].scriptPubKey.capacity();
+    return nUsage;
+}
+/* AMB END */
+
 CTxMemPoolEntry::CTxMemPoolEntry():
-    nFee(0), nTxSize(0), nModSize(0), nTime(0), dPriority(0.0)
+    nFee(0), nTxSize(0), nModSize(0), nTime(0), dPriority(0.0), fFeeExempt(false), nFeeExemptVersion(-1), nUsageSize(0)
 {
     nHeight = MEMPOOL_HEIGHT;
     ResetReplayParams();
@@ -44,9 +65,10 @@ CTxMemPoolEntry::CTxMemPoolEntry():
 CTxMemPoolEntry::CTxMemPoolEntry(const CTransaction& _tx, const CAmount& _nFee,
                                  int64_t _nTime, double _dPriority,
                                  unsigned int _nHeight):
-    tx(_tx), nFee(_nFee), nTime(_nTime), dPriority(_dPriority), nHeight(_nHeight)
+    tx(_tx), nFee(_nFee), nTime(_nTime), dPriority(_dPriority), nHeight(_nHeight), fFeeExempt(false), nFeeExemptVersion(-1)
 {
     nTxSize = ::GetSerializeSize(tx, SER_NETWORK, PROTOCOL_VERSION);
+    nUsageSize = EstimateEntryUsage(tx);
 
     nModSize = tx.CalculateModifiedSize(nTxSize);
     ResetReplayParams();
@@ -415,6 +437,8 @@ public:
 };
 
 
+CMemPoolOutPointHasher::CMemPoolOutPointHasher() : salt(GetRandHash()) {}
+
 CTxMemPool::CTxMemPool(const CFeeRate& _minRelayFee) :
     nTransactionsUpdated(0),
     minRelayFee(_minRelayFee)
@@ -435,7 +459,9 @@ CTxMemPool::CTxMemPool(const CFeeRate& _minRelayFee) :
     hashList=new mc_Buffer;
     hashList->Initialize(sizeof(uint256),sizeof(uint256),0);
     hashListPos=0;
+    nRemovedGeneration=0;
 /* MCHN END */    
+    totalUsage=0;
 }
 
 CTxMemPool::~CTxMemPool()
@@ -450,12 +476,10 @@ void CTxMemPool::pruneSpent(const uint256 &hashTx, CCoins &coins)
 {
     LOCK(cs);
 
-    std::map<COutPoint, CInPoint>::iterator it = mapNextTx.lower_bound(COutPoint(hashTx, 0));
-
-    // iterate over all COutPoints in mapNextTx whose hash equals the provided hashTx
-    while (it != mapNextTx.end() && it->first.hash == hashTx) {
-        coins.Spend(it->first.n); // and remove those outputs from coins
-        it++;
+    // mapNextTx is not ordered, so every output of hashTx is looked up
+    for (unsigned int i = 0; i < coins.vout.size(); i++) {
+        if (!coins.vout[i].IsNull() && mapNextTx.count(COutPoint(hashTx, i)))
+            coins.Spend(i); // and remove those outputs from coins
     }
 }
 
@@ -485,6 +509,12 @@ bool CTxMemPool::addUnchecked(const uint256& hash, const CTxMemPoolEntry &entry)
             mapNextTx[tx.vin[i].prevout] = CInPoint(&tx, i);
         nTransactionsUpdated++;
         totalTxSize += entry.GetTxSize();
+/* AMB START */
+        totalUsage += entry.GetUsageSize();
+        for (unsigned int i = 0; i < entry.GetStreams().size(); i++)
+            mapStreamUsage[entry.GetStreams()[i]] += entry.GetUsageSize();
+        setEviction.insert(make_pair(make_pair(entry.GetFeeRate(), -entry.GetTime()), hash));
+/* AMB END */
         
 /* MCHN START */        
         if(hashListPos<hashList->m_Count)
@@ -512,10 +542,11 @@ bool CTxMemPool::defragmentHashList()
     posIn=0;
     posOut=0;
     
+    LOCK(cs);
     while(posIn<hashList->m_Count)
     {
         hash=*(uint256*)hashList->GetRow(posIn);
-        if(exists(hash))
+        if(mapTx.count(hash))
         {
             if(posIn != posOut)
             {
@@ -542,6 +573,7 @@ bool CTxMemPool::shiftHashList(uint32_t rows)
     int oldrows=hashList->m_Count;
     
     hashList->SetCount(hashList->m_Count+rows);
+    nRemovedGeneration++;
     
     if(oldrows)
     {
@@ -555,6 +587,129 @@ bool CTxMemPool::shiftHashList(uint32_t rows)
     return true;
 }
 
+int CTxMemPool::existsHashList(int nFrom, std::vector<bool>& vExists)
+{
+    LOCK(cs);
+    int count=hashList->m_Count-nFrom;
+    
+    vExists.assign(count > 0 ? count : 0, false);
+    for(int pos=nFrom;pos<hashList->m_Count;pos++)
+    {
+        vExists[pos-nFrom]=(mapTx.count(*(uint256*)hashList->GetRow(pos)) != 0);
+    }
+    
+    return vExists.size();
+}
+
+unsigned int CTxMemPool::GetRemovedGeneration() const
+{
+    LOCK(cs);
+    return nRemovedGeneration;
+}
+
+/* AMB START */
+
+uint64_t CTxMemPool::GetStreamUsage(const uint160& stream)
+{
+    LOCK(cs);
+    std::map<uint160, uint64_t>::const_iterator it = mapStreamUsage.find(stream);
+    return (it != mapStreamUsage.end()) ? it->second : 0;
+}
+
+bool CTxMemPool::SelectForEviction(uint64_t nSizeLimit, uint64_t nExtraUsage, double dMaxFeeRate, int64_t nExpiryTime,
+                                   const CTransaction& txNew, std::vector<uint256>& vEvict)
+{
+    LOCK(cs);
+    
+    uint64_t nUsage = totalUsage + nExtraUsage;
+    std::set<uint256> setSelected;
+    std::set<uint256> setParents;
+    for (unsigned int i = 0; i < txNew.vin.size(); i++)
+        setParents.insert(txNew.vin[i].prevout.hash);
+    
+    // Pass 0 - expired transactions, pass 1 - lowest fee rate
+    for (int pass = 0; (pass < 2) && (nUsage > nSizeLimit); pass++)
+    {
+        typedef std::set<std::pair<std::pair<double, int64_t>, uint256> >::const_iterator eviction_iterator;
+        for (eviction_iterator it = setEviction.begin(); (it != setEviction.end()) && (nUsage > nSizeLimit); ++it)
+        {
+            if (pass == 0)
+            {
+                if (-it->first.second >= nExpiryTime)
+                    continue;
+            }
+            else
+            {
+                if (it->first.first >= dMaxFeeRate)
+                    break;
+            }
+            
+            const uint256& hash = it->second;
+            if (setSelected.count(hash))
+                continue;
+            
+            // Transaction is evicted with all its descendants in the pool, or not at all
+            std::vector<uint256> vPackage;
+            std::set<uint256> setPackage;
+            bool fEvictable = true;
+            vPackage.push_back(hash);
+            setPackage.insert(hash);
+            for (unsigned int p = 0; (p < vPackage.size()) && fEvictable; p++)
+            {
+                CTxMemPoolMap::const_iterator itTx = mapTx.find(vPackage[p]);
+                if (itTx == mapTx.end())
+                    continue;
+                if (!itTx->second.IsEvictable() || setParents.count(vPackage[p]))
+                {
+                    fEvictable = false;
+                    break;
+                }
+                const CTransaction& tx = itTx->second.GetTx();
+                for (unsigned int i = 0; i < tx.vout.size(); i++)
+                {
+                    CTxMemPoolNextMap::const_iterator itNext = mapNextTx.find(COutPoint(tx.GetHash(), i));
+                    if (itNext == mapNextTx.end())
+                        continue;
+                    uint256 hashNext = itNext->second.ptx->GetHash();
+                    if (setPackage.insert(hashNext).second)
+                        vPackage.push_back(hashNext);
+                }
+            }
+            if (!fEvictable)
+                continue;
+            
+            for (unsigned int p = 0; p < vPackage.size(); p++)
+            {
+                if (setSelected.insert(vPackage[p]).second)
+                {
+                    CTxMemPoolMap::const_iterator itTx = mapTx.find(vPackage[p]);
+                    if (itTx != mapTx.end())
+                        nUsage -= std::min(nUsage, (uint64_t)itTx->second.GetUsageSize());
+                    vEvict.push_back(vPackage[p]);
+                }
+            }
+        }
+    }
+    
+    return nUsage <= nSizeLimit;
+}
+
+void CTxMemPool::Evict(const std::vector<uint256>& vEvict, std::list<CTransaction>& removed)
+{
+    LOCK(cs);
+    for (unsigned int i = 0; i < vEvict.size(); i++)
+    {
+        CTxMemPoolMap::const_iterator it = mapTx.find(vEvict[i]);
+        if (it != mapTx.end())
+        {
+            CTransaction tx = it->second.GetTx();
+            remove(tx, removed, true, "evicted");
+        }
+    }
+}
+
+/* AMB END */
+
 /* MCHN END */        
 
 
@@ -571,7 +726,7 @@ void CTxMemPool::remove(const CTransaction &origTx, std::list<CTransaction>& rem
             // happen during chain re-orgs if origTx isn't re-accepted into
             // the mempool for any reason.
             for (unsigned int i = 0; i < origTx.vout.size(); i++) {
-                std::map<COutPoint, CInPoint>::iterator it = mapNextTx.find(COutPoint(origTx.GetHash(), i));
+                CTxMemPoolNextMap::iterator it = mapNextTx.find(COutPoint(origTx.GetHash(), i));
                 if (it == mapNextTx.end())
                     continue;
                 txToRemove.push_back(it->second.ptx->GetHash());
@@ -586,7 +741,7 @@ void CTxMemPool::remove(const CTransaction &origTx, std::list<CTransaction>& rem
             const CTransaction& tx = mapTx[hash].GetTx();
             if (fRecursive) {
                 for (unsigned int i = 0; i < tx.vout.size(); i++) {
-                    std::map<COutPoint, CInPoint>::iterator it = mapNextTx.find(COutPoint(hash, i));
+                    CTxMemPoolNextMap::iterator it = mapNextTx.find(COutPoint(hash, i));
                     if (it == mapNextTx.end())
                         continue;
                     txToRemove.push_back(it->second.ptx->GetHash());
@@ -597,8 +752,24 @@ void CTxMemPool::remove(const CTransaction &origTx, std::list<CTransaction>& rem
 
             removed.push_back(tx);
             totalTxSize -= mapTx[hash].GetTxSize();
+/* AMB START */
+            const CTxMemPoolEntry& entry = mapTx[hash];
+            totalUsage -= entry.GetUsageSize();
+            for (unsigned int i = 0; i < entry.GetStreams().size(); i++)
+            {
+                std::map<uint160, uint64_t>::iterator itStream = mapStreamUsage.find(entry.GetStreams()[i]);
+                if (itStream != mapStreamUsage.end())
+                {
+                    itStream->second -= entry.GetUsageSize();
+                    if (itStream->second == 0)
+                        mapStreamUsage.erase(itStream);
+                }
+            }
+            setEviction.erase(make_pair(make_pair(entry.GetFeeRate(), -entry.GetTime()), hash));
+/* AMB END */
             mapTx.erase(hash);
             nTransactionsUpdated++;
+            nRemovedGeneration++;
             if(wtx_reason.size())
             {
                 if(hash == origTx.GetHash())
@@ -620,10 +791,10 @@ void CTxMemPool::removeCoinbaseSpends(const CCoinsViewCache *pcoins, unsigned in
     // Remove transactions spending a coinbase which are now immature
     LOCK(cs);
     list<CTransaction> transactionsToRemove;
-    for (std::map<uint256, CTxMemPoolEntry>::const_iterator it = mapTx.begin(); it != mapTx.end(); it++) {
+    for (CTxMemPoolMap::const_iterator it = mapTx.begin(); it != mapTx.end(); it++) {
         const CTransaction& tx = it->second.GetTx();
         BOOST_FOREACH(const CTxIn& txin, tx.vin) {
-            std::map<uint256, CTxMemPoolEntry>::const_iterator it2 = mapTx.find(txin.prevout.hash);
+            CTxMemPoolMap::const_iterator it2 = mapTx.find(txin.prevout.hash);
             if (it2 != mapTx.end())
                 continue;
             const CCoins *coins = pcoins->AccessCoins(txin.prevout.hash);
@@ -649,7 +820,7 @@ void CTxMemPool::removeConflicts(const CTransaction &tx, std::list<CTransaction>
     list<CTransaction> result;
     LOCK(cs);
     BOOST_FOREACH(const CTxIn &txin, tx.vin) {
-        std::map<COutPoint, CInPoint>::iterator it = mapNextTx.find(txin.prevout);
+        CTxMemPoolNextMap::iterator it = mapNextTx.find(txin.prevout);
         if (it != mapNextTx.end()) {
             const CTransaction &txConflict = *it->second.ptx;
             if (txConflict != tx)
@@ -693,8 +864,14 @@ void CTxMemPool::clear()
 /* MCHN START */    
     hashList->Clear();
     hashListPos=0;
+    nRemovedGeneration++;
 /* MCHN END */    
     totalTxSize = 0;
+/* AMB START */
+    totalUsage = 0;
+    mapStreamUsage.clear();
+    setEviction.clear();
+/* AMB END */
     ++nTransactionsUpdated;
 }
 
@@ -711,14 +888,14 @@ void CTxMemPool::check(const CCoinsViewCache *pcoins) const
 
     LOCK(cs);
     list<const CTxMemPoolEntry*> waitingOnDependants;
-    for (std::map<uint256, CTxMemPoolEntry>::const_iterator it = mapTx.begin(); it != mapTx.end(); it++) {
+    for (CTxMemPoolMap::const_iterator it = mapTx.begin(); it != mapTx.end(); it++) {
         unsigned int i = 0;
         checkTotal += it->second.GetTxSize();
         const CTransaction& tx = it->second.GetTx();
         bool fDependsWait = false;
         BOOST_FOREACH(const CTxIn &txin, tx.vin) {
             // Check that every mempool transaction's inputs refer to available coins, or other mempool tx's.
-            std::map<uint256, CTxMemPoolEntry>::const_iterator it2 = mapTx.find(txin.prevout.hash);
+            CTxMemPoolMap::const_iterator it2 = mapTx.find(txin.prevout.hash);
             if (it2 != mapTx.end()) {
                 const CTransaction& tx2 = it2->second.GetTx();
                 assert(tx2.vout.size() > txin.prevout.n && !tx2.vout[txin.prevout.n].IsNull());
@@ -728,7 +905,7 @@ void CTxMemPool::check(const CCoinsViewCache *pcoins) const
                 assert(coins && coins->IsAvailable(txin.prevout.n));
             }
             // Check whether its inputs are marked in mapNextTx.
-            std::map<COutPoint, CInPoint>::const_iterator it3 = mapNextTx.find(txin.prevout);
+            CTxMemPoolNextMap::const_iterator it3 = mapNextTx.find(txin.prevout);
             assert(it3 != mapNextTx.end());
             assert(it3->second.ptx == &tx);
             assert(it3->second.n == i);
@@ -758,9 +935,9 @@ void CTxMemPool::check(const CCoinsViewCache *pcoins) const
             stepsSinceLastRemove = 0;
         }
     }
-    for (std::map<COutPoint, CInPoint>::const_iterator it = mapNextTx.begin(); it != mapNextTx.end(); it++) {
+    for (CTxMemPoolNextMap::const_iterator it = mapNextTx.begin(); it != mapNextTx.end(); it++) {
         uint256 hash = it->second.ptx->GetHash();
-        map<uint256, CTxMemPoolEntry>::const_iterator it2 = mapTx.find(hash);
+        CTxMemPoolMap::const_iterator it2 = mapTx.find(hash);
         const CTransaction& tx = it2->second.GetTx();
         assert(it2 != mapTx.end());
         assert(&tx == it->second.ptx);
@@ -777,14 +954,14 @@ void CTxMemPool::queryHashes(vector<uint256>& vtxid)
 
     LOCK(cs);
     vtxid.reserve(mapTx.size());
-    for (map<uint256, CTxMemPoolEntry>::iterator mi = mapTx.begin(); mi != mapTx.end(); ++mi)
+    for (CTxMemPoolMap::iterator mi = mapTx.begin(); mi != mapTx.end(); ++mi)
         vtxid.push_back((*mi).first);
 }
 
 bool CTxMemPool::lookup(uint256 hash, CTransaction& result) const
 {
     LOCK(cs);
-    map<uint256, CTxMemPoolEntry>::const_iterator i = mapTx.find(hash);
+    CTxMemPoolMap::const_iterator i = mapTx.find(hash);
     if (i == mapTx.end()) return false;
     result = i->second.GetTx();
     return true;
@@ -850,7 +1027,7 @@ void CTxMemPool::PrioritiseTransaction(const uint256 hash, const string strHash,
 void CTxMemPool::ApplyDeltas(const uint256 hash, double &dPriorityDelta, CAmount &nFeeDelta)
 {
     LOCK(cs);
-    std::map<uint256, std::pair<double, CAmount> >::iterator pos = mapDeltas.find(hash);
+    CTxMemPoolDeltaMap::iterator pos = mapDeltas.find(hash);
     if (pos == mapDeltas.end())
         return;
     const std::pair<double, CAmount> &deltas = pos->second;
@@ -8,6 +8,7 @@
 #define BITCOIN_TXMEMPOOL_H
 
 #include <list>
+#include <set>
 
 #include "structs/amount.h"
 #include "storage/coins.h"
@@ -53,6 +54,11 @@ private:
     int nWalletFrom;
     int nWalletTo;
     
+    bool fFeeExempt; //! Sender is authority, miner or public account, decided on admission
+    int nFeeExemptVersion; //! Fee exemption version fFeeExempt was computed against, -1 if not computed
+    size_t nUsageSize; //! Estimated memory used by the entry, pool indexes and wallet rows
+    std::vector<uint160> vStreams; //! Streams the transaction publishes items to
+    
 public:
     CTxMemPoolEntry(const CTransaction& _tx, const CAmount& _nFee,
                     int64_t _nTime, double _dPriority, unsigned int _nHeight);
@@ -74,6 +80,18 @@ public:
     int ReplayPermissionTo() const { return nPermissionsTo; }
     int ReplayWalletFrom() const { return nWalletFrom; }
     int ReplayWalletTo() const { return nWalletFrom; }
+    
+    void SetFeeExempt(bool exempt, int version) { fFeeExempt=exempt; nFeeExemptVersion=version; }
+    bool IsFeeExempt() const { return fFeeExempt; }
+    int FeeExemptVersion() const { return nFeeExemptVersion; }
+    
+    size_t GetUsageSize() const { return nUsageSize; }
+    void AddUsageSize(size_t size) { nUsageSize+=size; }
+    void SetStreams(const std::vector<uint160>& streams) { vStreams=streams; }
+    const std::vector<uint160>& GetStreams() const { return vStreams; }
+    double GetFeeRate() const { return nTxSize ? (double)nFee/nTxSize : 0; }
+    // Entries without side effects on permission and entity state can be removed out of acceptance order
+    bool IsEvictable() const { return !fFeeExempt && !fFullReplay && (nPermissionsFrom == nPermissionsTo); }
 };
 
 class CMinerPolicyEstimator;
@@ -91,6 +109,23 @@ public:
     bool IsNull() const { return (ptx == NULL && n == (uint32_t) -1); }
 };
 
+class CMemPoolOutPointHasher
+{
+private:
+    uint256 salt;
+
+public:
+    CMemPoolOutPointHasher();
+
+    size_t operator()(const COutPoint& key) const {
+        return key.hash.GetHash(salt) ^ ((size_t)key.n * 0x9E3779B9);
+    }
+};
+
+typedef boost::unordered_map<uint256, CTxMemPoolEntry, CCoinsKeyHasher> CTxMemPoolMap;
+typedef boost::unordered_map<COutPoint, CInPoint, CMemPoolOutPointHasher> CTxMemPoolNextMap;
+typedef boost::unordered_map<uint256, std::pair<double, CAmount>, CCoinsKeyHasher> CTxMemPoolDeltaMap;
+
 /**
  * CTxMemPool stores valid-according-to-the-current-best-chain
  * transactions that may be included in the next block.
@@ -110,12 +145,15 @@ private:
 
     CFeeRate minRelayFee; //! Passed to constructor to avoid dependency on main
     uint64_t totalTxSize; //! sum of all mempool tx' byte sizes
+    uint64_t totalUsage; //! sum of estimated memory usage of all entries
+    std::map<uint160, uint64_t> mapStreamUsage; //! memory usage of entries by stream
+    std::set<std::pair<std::pair<double, int64_t>, uint256> > setEviction; //! fee rate, negated time, hash
 
 public:
     mutable CCriticalSection cs;
-    std::map<uint256, CTxMemPoolEntry> mapTx;
-    std::map<COutPoint, CInPoint> mapNextTx;
-    std::map<uint256, std::pair<double, CAmount> > mapDeltas;
+    CTxMemPoolMap mapTx;
+    CTxMemPoolNextMap mapNextTx;
+    CTxMemPoolDeltaMap mapDeltas;
 
     CTxMemPool(const CFeeRate& _minRelayFee);
     ~CTxMemPool();
@@ -156,12 +194,30 @@ public:
         LOCK(cs);
         return totalTxSize;
     }
+    uint64_t DynamicMemoryUsage()
+    {
+        LOCK(cs);
+        return totalUsage;
+    }
+    uint64_t GetStreamUsage(const uint160& stream);
+    
+    /** 
+     * Selects evictable transactions together with their descendants so that usage with nExtraUsage added
+     * fits into nSizeLimit. Transactions older than nExpiryTime go first, then lowest fee rate below dMaxFeeRate,
+     * newest first. Parents of txNew are kept. Returns false if the limit cannot be reached.
+     */
+    bool SelectForEviction(uint64_t nSizeLimit, uint64_t nExtraUsage, double dMaxFeeRate, int64_t nExpiryTime,
+                           const CTransaction& txNew, std::vector<uint256>& vEvict);
+    void Evict(const std::vector<uint256>& vEvict, std::list<CTransaction>& removed);
 
     bool exists(uint256 hash)
     {
         LOCK(cs);
         return (mapTx.count(hash) != 0);
     }
+    
+    /** Existence of hashList rows starting from nFrom, checked under single lock. Returns number of rows checked */
+    int existsHashList(int nFrom, std::vector<bool>& vExists);
 
     bool lookup(uint256 hash, CTransaction& result) const;
 
@@ -179,9 +235,11 @@ public:
 
     mc_Buffer *hashList;
     int hashListPos;
+    unsigned int nRemovedGeneration; //! Bumped when transactions leave the pool or hashList is reordered
     
     bool defragmentHashList();
     bool shiftHashList(uint32_t rows);
+    unsigned int GetRemovedGeneration() const;
     
 /* MCHN END */    
 };
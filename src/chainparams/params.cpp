@@ -46,6 +46,7 @@ void mc_MultichainParams::Zero()
     m_ProtocolVersion=0;
     
     m_AssetRefSize=MC_AST_SHORT_TXID_SIZE;
+    m_IsResolved=0;
 }
 
 void mc_MultichainParams::Destroy()
@@ -70,6 +71,7 @@ void mc_MultichainParams::Destroy()
         delete m_lpIndex;
         m_lpIndex=NULL;
     }    
+    m_IsResolved=0;
 }
 
 
@@ -95,6 +97,33 @@ int64_t mc_MultichainParams::GetInt64Param(const char *param)
     return mc_GetLE(ptr,size);
 }
 
+/* AMB START */
+
+#define MC_PRM_NAME_ENTRY(id,name) name,
+static const char *c_ResolvedParamNames[MC_PRM_ID_COUNT]={
+    MC_PRM_RESOLVED_LIST(MC_PRM_NAME_ENTRY)
+};
+#undef MC_PRM_NAME_ENTRY
+
+const char* mc_MultichainParams::ResolvedParamName(mc_ParamID param)
+{
+    return c_ResolvedParamNames[param];
+}
+
+void mc_MultichainParams::ResolveParams()
+{
+    int i;
+    
+    m_IsResolved=0;
+    for(i=0;i<MC_PRM_ID_COUNT;i++)
+    {
+        m_ResolvedValues[i]=GetInt64Param(c_ResolvedParamNames[i]);
+    }
+    m_IsResolved=1;
+}
+
+/* AMB END */
+
 double mc_MultichainParams::GetDoubleParam(const char *param)
 {
     int n=(int)mc_gState->m_NetworkParams->GetInt64Param(param);
@@ -134,6 +163,7 @@ void* mc_MultichainParams::GetParam(const char *param,int* size)
 int mc_MultichainParams::SetParam(const char *param,const char* value,int size)
 {
     int offset;
+    m_IsResolved=0;
     if(m_lpIndex == NULL)
     {
         return MC_ERR_INTERNAL_ERROR;
@@ -183,6 +213,7 @@ int mc_MultichainParams::SetParam(const char *param,int64_t value)
 {
     int size;
     char buf[8];
+    m_IsResolved=0;
     if(m_lpIndex == NULL)
     {
         return MC_ERR_INTERNAL_ERROR;
@@ -46,6 +46,31 @@
 #define MC_PRM_STATUS_INVALID            4
 #define MC_PRM_STATUS_VALID              5
 
+/* AMB START */
+/** Parameters read on validation paths, resolved once by SetGlobals. Enum and name table are generated from this list */
+#define MC_PRM_RESOLVED_LIST(X)                                                 \
+    X(MC_PRM_ID_SETUP_FIRST_BLOCKS,           "setupfirstblocks")               \
+    X(MC_PRM_ID_MINING_DIVERSITY,             "miningdiversity")                \
+    X(MC_PRM_ID_ANYONE_CAN_ISSUE,             "anyonecanissue")                 \
+    X(MC_PRM_ID_ADMIN_CONSENSUS_ADMIN,        "adminconsensusadmin")            \
+    X(MC_PRM_ID_ADMIN_CONSENSUS_MINE,         "adminconsensusmine")             \
+    X(MC_PRM_ID_ADMIN_CONSENSUS_ACTIVATE,     "adminconsensusactivate")         \
+    X(MC_PRM_ID_ADMIN_CONSENSUS_ISSUE,        "adminconsensusissue")            \
+    X(MC_PRM_ID_ADMIN_CONSENSUS_CREATE,       "adminconsensuscreate")           \
+    X(MC_PRM_ID_ADMIN_CONSENSUS_UPGRADE,      "adminconsensusupgrade")          \
+    X(MC_PRM_ID_SUPPORT_MINER_PRECHECK,       "supportminerprecheck")           \
+    X(MC_PRM_ID_ADDRESS_CHECKSUM_VALUE,       "addresschecksumvalue")           \
+    X(MC_PRM_ID_POW_MINIMUM_BITS,             "powminimumbits")                 \
+
+#define MC_PRM_ENUM_ENTRY(id,name) id,
+typedef enum mc_ParamID
+{
+    MC_PRM_RESOLVED_LIST(MC_PRM_ENUM_ENTRY)
+    MC_PRM_ID_COUNT
+} mc_ParamID;
+#undef MC_PRM_ENUM_ENTRY
+/* AMB END */
+
 extern int MCP_MAX_STD_OP_RETURN_COUNT;
 extern int64_t MCP_INITIAL_BLOCK_REWARD;
 extern int64_t MCP_FIRST_BLOCK_REWARD;
@@ -100,6 +125,9 @@ typedef struct mc_MultichainParams
     
     int m_AssetRefSize;
     
+    int64_t m_ResolvedValues[MC_PRM_ID_COUNT];                                  // Values of MC_PRM_RESOLVED_LIST parameters
+    int m_IsResolved;                                                           // m_ResolvedValues are valid, cleared by SetParam
+    
     mc_MultichainParams()
     {
         Zero();
@@ -130,6 +158,12 @@ typedef struct mc_MultichainParams
     int FindParam(const char *param);
     void* GetParam(const char *param,int* size);
     int64_t GetInt64Param(const char *param);
+    int64_t GetInt64Param(mc_ParamID param)                                     // Array load after SetGlobals, lookup by name before
+    {
+        return m_IsResolved ? m_ResolvedValues[param] : GetInt64Param(ResolvedParamName(param));
+    }
+    static const char* ResolvedParamName(mc_ParamID param);
+    void ResolveParams();
     double GetDoubleParam(const char *param);
     
     int SetParam(const char *param,const char* value,int size);
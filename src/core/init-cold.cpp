@@ -14,6 +14,7 @@
 #include "structs/amount.h"
 #include "chain/checkpoints.h"
 #include "compat/sanity.h"
+#include "crypto/sha256.h"
 #include "keys/key.h"
 #include "core/main.h"
 #include "miner/miner.h"
@@ -344,6 +345,9 @@ bool AppInit2_Cold(boost::thread_group& threadGroup,int OutputPipe)
 
     // ********************************************************* Step 4: application initialization: dir lock, daemonize, pidfile, debug log
 
+    // Select the fastest SHA-256 implementation supported by the CPU
+    std::string strSHA256Implementation = SHA256AutoDetect();
+
     // Initialize elliptic curve code
     ECC_Start();
     globalVerifyHandle.reset(new ECCVerifyHandle());
@@ -389,6 +393,7 @@ bool AppInit2_Cold(boost::thread_group& threadGroup,int OutputPipe)
 
 /* MCHN END */    
     LogPrintf("Using OpenSSL version %s\n", SSLeay_version(SSLEAY_VERSION));
+    LogPrintf("Using SHA256 implementation: %s\n", strSHA256Implementation);
 #ifdef ENABLE_WALLET
     LogPrintf("Using BerkeleyDB version %s\n", DbEnv::version(0, 0, 0));
 #endif
@@ -14,15 +14,20 @@
 #include "structs/amount.h"
 #include "chain/checkpoints.h"
 #include "compat/sanity.h"
+#include "crypto/sha256.h"
 #include "keys/key.h"
 #include "core/main.h"
 #include "miner/miner.h"
 #include "net/net.h"
+#include "protocol/blockencodings.h"
 #include "rpc/rpcserver.h"
+#include "script/sigcache.h"
+#include "script/sign.h"
 #include "script/standard.h"
 #include "storage/txdb.h"
 #include "ui/ui_interface.h"
 #include "utils/util.h"
+#include "utils/logwriter.h"
 #include "utils/utilmoneystr.h"
 #ifdef ENABLE_WALLET
 #include "wallet/db.h"
@@ -319,10 +324,18 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += "  -dbcache=<n>           " + strprintf(_("Set database cache size in megabytes (%d to %d, default: %d)"), nMinDbCache, nMaxDbCache, nDefaultDbCache) + "\n";
     strUsage += "  -loadblock=<file>      " + _("Imports blocks from external blk000??.dat file") + " " + _("on startup") + "\n";
     strUsage += "  -maxorphantx=<n>       " + strprintf(_("Keep at most <n> unconnectable transactions in memory (default: %u)"), DEFAULT_MAX_ORPHAN_TRANSACTIONS) + "\n";
+/* AMB START */
+    strUsage += "  -maxmempool=<n>        " + strprintf(_("Keep the transaction memory pool below <n> megabytes, evicting lowest fee rate stream items and payments first (default: %u, 0 - unlimited)"), DEFAULT_MAX_MEMPOOL_SIZE) + "\n";
+    strUsage += "  -mempoolexpiry=<n>     " + strprintf(_("Transactions older than <n> hours are evicted first when memory pool is full (default: %u)"), DEFAULT_MEMPOOL_EXPIRY) + "\n";
+    strUsage += "  -mempoolstreamquota=<n> " + strprintf(_("Items of one stream may use at most <n> percent of -maxmempool (default: %u, 0 - no quota)"), DEFAULT_MEMPOOL_STREAM_QUOTA) + "\n";
+/* AMB END */
     strUsage += "  -par=<n>               " + strprintf(_("Set the number of script verification threads (%u to %d, 0 = auto, <0 = leave that many cores free, default: %d)"), -(int)boost::thread::hardware_concurrency(), MAX_SCRIPTCHECK_THREADS, DEFAULT_SCRIPTCHECK_THREADS) + "\n";
 #ifndef WIN32
     strUsage += "  -pid=<file>            " + strprintf(_("Specify pid file (default: %s)"), "multichain.pid") + "\n";
 #endif
+    strUsage += "  -prunedepth=<n>        " + strprintf(_("Delete block files with all blocks deeper than <n> in active chain (default: 0 = disabled, minimum: %u). "
+                                                            "Files with blocks referenced by wallet, containing genesis block or written by older versions are kept. "
+                                                            "Pruned blocks are not served to peers, cannot be rescanned and -reindex is not available. Requires -txindex=0"), MIN_PRUNE_DEPTH) + "\n";
     strUsage += "  -reindex               " + _("Rebuild the blockchain and reindex transactions on startup.") + "\n";
 #if !defined(WIN32)
     strUsage += "  -sysperms              " + _("Create new files with system default permissions, instead of umask 077 (only effective with disabled wallet functionality)") + "\n";
@@ -331,6 +344,7 @@ std::string HelpMessage(HelpMessageMode mode)
 /* MCHN START */    
 /* Default was 0 */    
     strUsage += "  -txindex               " + strprintf(_("Maintain a full transaction index, used by the getrawtransaction rpc call (default: %u)"), 1) + "\n";
+    strUsage += "  -streamindex           " + strprintf(_("Maintain per-stream index of blocks with stream items, used by subscribe to skip full chain scan (default: %u)"), 1) + "\n";
 /* MCHN END */    
 
     strUsage += "\n" + _("Connection options:") + "\n";
@@ -338,6 +352,7 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += "  -banscore=<n>          " + strprintf(_("Threshold for disconnecting misbehaving peers (default: %u)"), 100) + "\n";
     strUsage += "  -bantime=<n>           " + strprintf(_("Number of seconds to keep misbehaving peers from reconnecting (default: %u)"), 86400) + "\n";
     strUsage += "  -bind=<addr>           " + _("Bind to given address and always listen on it. Use [host]:port notation for IPv6") + "\n";
+    strUsage += "  -compactblocks         " + strprintf(_("Request recent blocks from peers as short transaction IDs, reconstructing them from mempool (default: %u)"), DEFAULT_COMPACT_BLOCKS) + "\n";
     strUsage += "  -connect=<ip>          " + _("Connect only to the specified node(s)") + "\n";
     strUsage += "  -discover              " + _("Discover own IP address (default: 1 when listening and no -externalip)") + "\n";
     strUsage += "  -dns                   " + _("Allow DNS lookups for -addnode, -seednode and -connect") + " " + _("(default: 1)") + "\n";
@@ -348,6 +363,7 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += "  -maxconnections=<n>    " + strprintf(_("Maintain at most <n> connections to peers (default: %u)"), 125) + "\n";
     strUsage += "  -maxreceivebuffer=<n>  " + strprintf(_("Maximum per-connection receive buffer, <n>*1000 bytes (default: %u)"), 5000) + "\n";
     strUsage += "  -maxsendbuffer=<n>     " + strprintf(_("Maximum per-connection send buffer, <n>*1000 bytes (default: %u)"), 1000) + "\n";
+    strUsage += "  -msgprocthreads=<n>    " + strprintf(_("Number of threads processing peer messages which do not require chain lock, e.g. ping, getdata for transactions (default: %u)"), DEFAULT_MSGPROC_THREADS) + "\n";
     strUsage += "  -onion=<ip:port>       " + strprintf(_("Use separate SOCKS5 proxy to reach peers via Tor hidden services (default: %s)"), "-proxy") + "\n";
     strUsage += "  -onlynet=<net>         " + _("Only connect to nodes in network <net> (ipv4, ipv6 or onion)") + "\n";
     strUsage += "  -permitbaremultisig    " + strprintf(_("Relay non-P2SH multisig (default: %u)"), 1) + "\n";
@@ -376,13 +392,18 @@ std::string HelpMessage(HelpMessageMode mode)
         strUsage += "  -mintxfee=<amt>        " + strprintf(_("Fees (in BTC/Kb) smaller than this are considered zero fee for transaction creation (default: %s)"), FormatMoney(CWallet::minTxFee.GetFeePerK())) + "\n";
     strUsage += "  -paytxfee=<amt>        " + strprintf(_("Fee (in BTC/kB) to add to transactions you send (default: %s)"), FormatMoney(payTxFee.GetFeePerK())) + "\n";
     strUsage += "  -rescan                " + _("Rescan the block chain for missing wallet transactions") + " " + _("on startup") + "\n";
+    strUsage += "  -backgroundrescan      " + strprintf(_("Rescan for newly subscribed assets and streams in background, subscribe returns immediately (default: %u)"), 1) + "\n";
+    strUsage += "  -rescanprefetchthreads=<n> " + strprintf(_("Number of threads reading blocks ahead of background rescan (default: %d)"), DEFAULT_RESCAN_PREFETCH_THREADS) + "\n";
     strUsage += "  -salvagewallet         " + _("Attempt to recover private keys from a corrupt wallet.dat") + " " + _("on startup") + "\n";
     strUsage += "  -sendfreetransactions  " + strprintf(_("Send transactions as zero-fee transactions if possible (default: %u)"), 0) + "\n";
+    strUsage += "  -signthreads=<n>       " + strprintf(_("Set the number of threads signing inputs of large transactions (%u to %d, 0 = auto, <0 = leave that many cores free, default: %d)"), -(int)boost::thread::hardware_concurrency(), MAX_SIGN_THREADS, DEFAULT_SIGN_THREADS) + "\n";
     strUsage += "  -spendzeroconfchange   " + strprintf(_("Spend unconfirmed change when sending transactions (default: %u)"), 1) + "\n";
     strUsage += "  -txconfirmtarget=<n>   " + strprintf(_("If paytxfee is not set, include enough fee so transactions begin confirmation on average within n blocks (default: %u)"), 1) + "\n";
     strUsage += "  -maxtxfee=<amt>        " + strprintf(_("Maximum total fees to use in a single wallet transaction, setting too low may abort large transactions (default: %s)"), FormatMoney(maxTxFee)) + "\n";
     strUsage += "  -upgradewallet         " + _("Upgrade wallet to latest format") + " " + _("on startup") + "\n";
     strUsage += "  -wallet=<file>         " + _("Specify wallet file (within data directory)") + " " + strprintf(_("(default: %s)"), "wallet.dat") + "\n";
+    strUsage += "  -walletgroupcommit     " + strprintf(_("Make wallet writes durable by flushing database log once for all concurrent writers, instead of checkpointing on every write (default: %u)"), DEFAULT_WALLET_GROUP_COMMIT) + "\n";
+    strUsage += "  -walletcommitdelay=<n> " + strprintf(_("Milliseconds to wait for other wallet writers before flushing database log, the wait is outside chain and wallet locks (default: %u)"), DEFAULT_WALLET_COMMIT_DELAY) + "\n";
     strUsage += "  -walletnotify=<cmd>    " + _("Execute this command when a transaction is first seen or confirmed, if it relates to an address in the wallet or a subscribed asset or stream. ") + "\n";
     strUsage += "  -walletnotifynew=<cmd> " + _("Execute this command when a transaction is first seen, if it relates to an address in the wallet or a subscribed asset or stream. ") + "\n";
     strUsage += "                         " + _("(more details and % substitutions online)") + "\n";
@@ -422,11 +443,15 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += "  -help-debug            " + _("Show all debugging options (usage: --help -help-debug)") + "\n";
     strUsage += "  -logips                " + strprintf(_("Include IP addresses in debug output (default: %u)"), 0) + "\n";
     strUsage += "  -logtimestamps         " + strprintf(_("Prepend debug output with timestamp (default: %u)"), 1) + "\n";
+/* AMB START */
+    strUsage += "  -asynclog              " + strprintf(_("Write debug.log and module logs from dedicated thread, logging threads only copy messages to their buffers (default: %u)"), DEFAULT_ASYNC_LOG) + "\n";
+    strUsage += "  -logbuffersize=<n>     " + strprintf(_("Size of per-thread log buffer in KB, messages are dropped and counted when the buffer is full (default: %u)"), DEFAULT_LOG_BUFFER_SIZE) + "\n";
+/* AMB END */
     strUsage += "  -limitfreerelay=<n>    " + strprintf(_("Continuously rate-limit free transactions to <n>*1000 bytes per minute (default:%u)"), 0) + "\n";
     if (GetBoolArg("-help-debug", false))
     {
         strUsage += "  -relaypriority         " + strprintf(_("Require high priority for relaying free or low-fee transactions (default:%u)"), 1) + "\n";
-        strUsage += "  -maxsigcachesize=<n>   " + strprintf(_("Limit size of signature cache to <n> entries (default: %u)"), 50000) + "\n";
+        strUsage += "  -maxsigcachesize=<n>   " + strprintf(_("Limit size of signature cache to <n> entries (default: %u)"), DEFAULT_MAX_SIG_CACHE_SIZE) + "\n";
     }
     strUsage += "  -minrelaytxfee=<amt>   " + strprintf(_("Fees (in BTC/Kb) smaller than this are considered zero fee for relaying (default: %s)"), FormatMoney(::minRelayTxFee.GetFeePerK())) + "\n";
     strUsage += "  -printtoconsole        " + _("Send trace/debug info to console instead of debug.log file") + "\n";
@@ -456,6 +481,7 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += "\n" + _("Block creation options:") + "\n";
     strUsage += "  -blockminsize=<n>      " + strprintf(_("Set minimum block size in bytes (default: %u)"), 0) + "\n";
     strUsage += "  -blockmaxsize=<n>      " + strprintf(_("Set maximum block size in bytes (default: %d)"), DEFAULT_BLOCK_MAX_SIZE) + "\n";
+    strUsage += "  -incrementalblocktemplate  " + strprintf(_("Extend the previous block template with newly accepted transactions instead of rebuilding it (default: %u)"), 1) + "\n";
 //    strUsage += "  -blockprioritysize=<n> " + strprintf(_("Set maximum size of high-priority/low-fee transactions in bytes (default: %d)"), DEFAULT_BLOCK_PRIORITY_SIZE) + "\n";
 
     strUsage += "\n" + _("RPC server options:") + "\n";
@@ -469,6 +495,7 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += "                         " + _("This option can be specified multiple times") + "\n";
     strUsage += "  -rpcallowmethod=<methods> " + _("If specified, allow only comma delimited list of JSON-RPC <methods>. This option can be specified multiple times.") + "\n";
     strUsage += "  -rpcthreads=<n>        " + strprintf(_("Set the number of threads to service RPC calls (default: %d)"), 4) + "\n";
+    strUsage += "  -rpcbatchthreads=<n>   " + strprintf(_("Set the number of threads executing read-only elements of JSON-RPC batch requests concurrently, 0 - sequential (default: %d)"), 4) + "\n";
     strUsage += "  -rpckeepalive          " + strprintf(_("RPC support for HTTP persistent connections (default: %d)"), 0) + "\n";
 
     strUsage += "\n" + _("RPC SSL options") + "\n";
@@ -765,9 +792,16 @@ bool AppInit2(boost::thread_group& threadGroup,int OutputPipe)
     }
 
     // Make sure enough file descriptors are available
-    int nBind = std::max((int)mapArgs.count("-bind") + (int)mapArgs.count("-whitebind"), 1);
     nMaxConnections = GetArg("-maxconnections", 125);
+/* AMB START */
+#ifdef USE_EPOLL
+    // epoll is not limited by FD_SETSIZE, only by the process descriptor limit checked below
+    nMaxConnections = std::max(nMaxConnections, 0);
+#else
+    int nBind = std::max((int)mapArgs.count("-bind") + (int)mapArgs.count("-whitebind"), 1);
     nMaxConnections = std::max(std::min(nMaxConnections, (int)(FD_SETSIZE - nBind - MIN_CORE_FILEDESCRIPTORS)), 0);
+#endif
+/* AMB END */
     int nFD = RaiseFileDescriptorLimit(nMaxConnections + MIN_CORE_FILEDESCRIPTORS);
     if (nFD < MIN_CORE_FILEDESCRIPTORS)
         return InitError(_("Not enough file descriptors available."));
@@ -892,9 +926,13 @@ bool AppInit2(boost::thread_group& threadGroup,int OutputPipe)
 
     // ********************************************************* Step 4: application initialization: dir lock, daemonize, pidfile, debug log
 
+    // Select the fastest SHA-256 implementation supported by the CPU
+    std::string strSHA256Implementation = SHA256AutoDetect();
+
     // Initialize elliptic curve code
     ECC_Start();
     globalVerifyHandle.reset(new ECCVerifyHandle());
+    InitSignatureCache();
 
     // Sanity check
     if (!InitSanityCheck())
@@ -927,6 +965,13 @@ bool AppInit2(boost::thread_group& threadGroup,int OutputPipe)
 #endif
     if (GetBoolArg("-shrinkdebugfile", !fDebug))
         ShrinkDebugFile();
+/* AMB START */
+    if (GetBoolArg("-asynclog", DEFAULT_ASYNC_LOG) && !fPrintToConsole)
+    {
+        if (StartLogWriter((GetDataDir() / "debug.log").string(), GetArg("-logbuffersize", DEFAULT_LOG_BUFFER_SIZE)))
+            mc_gLogStringFunc = LogWriterLogString;
+    }
+/* AMB END */
     LogPrintf("\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n");
 //    LogPrintf("Bitcoin version %s (%s)\n", FormatFullVersion(), CLIENT_DATE);
 /* MCHN START */    
@@ -937,6 +982,7 @@ bool AppInit2(boost::thread_group& threadGroup,int OutputPipe)
 
 /* MCHN END */    
     LogPrintf("Using OpenSSL version %s\n", SSLeay_version(SSLEAY_VERSION));
+    LogPrintf("Using SHA256 implementation: %s\n", strSHA256Implementation);
 #ifdef ENABLE_WALLET
     LogPrintf("Using BerkeleyDB version %s\n", DbEnv::version(0, 0, 0));
 #endif
@@ -1962,6 +2008,28 @@ bool AppInit2(boost::thread_group& threadGroup,int OutputPipe)
     
     fReindex = GetBoolArg("-reindex", false);
 
+/* AMB START */
+    nPruneDepth = GetArg("-prunedepth", 0);
+    if (nPruneDepth < 0)
+        return InitError(_("Prune depth cannot be negative."));
+    if (nPruneDepth > 0)
+    {
+        if (nPruneDepth < MIN_PRUNE_DEPTH)
+        {
+            LogPrintf("Prune depth %d is below minimum, using %d\n", nPruneDepth, MIN_PRUNE_DEPTH);
+            nPruneDepth = MIN_PRUNE_DEPTH;
+        }
+        if (fReindex)
+            return InitError(_("Block files may be pruned, -reindex is not supported with -prunedepth."));
+        // Transaction index would keep positions of transactions in deleted files
+        if (GetBoolArg("-txindex", true))
+            return InitError(_("Prune mode is incompatible with -txindex, start with -txindex=0. Existing index is removed by -reindex -txindex=0 without -prunedepth."));
+        // NODE_NETWORK is kept, peers of permissioned chain may have no other source of new blocks
+        fPruneMode = true;
+        LogPrintf("Block file pruning enabled, keep depth %d\n", nPruneDepth);
+    }
+/* AMB END */
+
     // Upgrading to 0.8; hard-link the old blknnnn.dat files into /blocks/
     filesystem::path blocksDir = GetDataDir() / "blocks";
     if (!filesystem::exists(blocksDir))
@@ -2076,6 +2144,18 @@ bool AppInit2(boost::thread_group& threadGroup,int OutputPipe)
                 }
 /* MCHN END */    
 
+/* AMB START */
+                // Stream index can be dropped at any time, it is rebuilt only with -reindex
+                if (fStreamIndex && !GetBoolArg("-streamindex", true)) {
+                    fStreamIndex = false;
+                    pblocktree->WriteFlag("streamindex", false);
+                    LogPrintf("Stream index disabled\n");
+                }
+                if (!fStreamIndex && GetBoolArg("-streamindex", true)) {
+                    LogPrintf("Stream index is not available in this database, -reindex is required to build it, subscriptions will scan full chain\n");
+                }
+/* AMB END */
+
                 uiInterface.InitMessage(_("Verifying blocks..."));
                 if (!CVerifyDB().VerifyDB(pcoinsdbview, GetArg("-checklevel", 3),
                               GetArg("-checkblocks", 288))) {
@@ -2271,6 +2351,10 @@ bool AppInit2(boost::thread_group& threadGroup,int OutputPipe)
 /* MCHN END */        
         if (chainActive.Tip() && chainActive.Tip() != pindexRescan)
         {
+/* AMB START */
+            if (pindexRescan && (GetLastPrunedHeight() >= pindexRescan->nHeight))
+                return InitError(strprintf(_("Rescan from block %d is not possible, blocks up to height %d were pruned."), pindexRescan->nHeight, GetLastPrunedHeight()));
+/* AMB END */
             uiInterface.InitMessage(_("Rescanning..."));
             LogPrintf("Rescanning last %i blocks (from block %i)...\n", chainActive.Height() - pindexRescan->nHeight, pindexRescan->nHeight);
             nStart = GetTimeMillis();
@@ -2404,6 +2488,13 @@ bool AppInit2(boost::thread_group& threadGroup,int OutputPipe)
     if (pwalletMain) {
         // Run a thread to flush wallet periodically
         threadGroup.create_thread(boost::bind(&ThreadFlushWalletDB, boost::ref(pwalletMain->strWalletFile)));
+/* AMB START */        
+        if(mc_gState->m_WalletMode & MC_WMD_TXS)
+        {
+            threadGroup.create_thread(boost::bind(&TraceThread<boost::function<void()> >, "rescan", 
+                    boost::function<void()>(boost::bind(&ThreadWalletRescan, pwalletMain))));
+        }
+/* AMB END */        
     }
 #endif
 
@@ -36,6 +36,7 @@
 #include "script/script.h"
 #include "amber/streamutils.h"
 #include "amber/validation.h"
+#include "protocol/blockencodings.h"
 
 
 extern mc_WalletTxs* pwalletTxsMain;
@@ -48,6 +49,7 @@ extern mc_WalletTxs* pwalletTxsMain;
 #include <boost/algorithm/string/replace.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/fstream.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/thread.hpp>
 
 using namespace boost;
@@ -102,6 +104,12 @@ int nScriptCheckThreads = 0;
 bool fImporting = false;
 bool fReindex = false;
 bool fTxIndex = false;
+/* AMB START */
+bool fStreamIndex = false;
+bool fPruneMode = false;
+int nPruneDepth = 0;
+bool fHavePruned = false;
+/* AMB END */
 bool fIsBareMultisigStd = true;
 unsigned int nCoinCacheSize = 5000;
 int nLastForkedHeight=0;
@@ -228,6 +236,17 @@ namespace {
 
     /** Dirty block file entries. */
     set<int> setDirtyFileInfo;
+
+/* AMB START */
+    /** Set when new block file is started, files are checked for pruning on next flush. */
+    bool fCheckForPruning = false;
+
+    /** Block files referenced by shortened wallet rows, loaded on startup. */
+    CCriticalSection cs_PinnedBlockFiles;
+    set<int> setPinnedBlockFiles;
+    /** Wallet references to files below this one were created before pins were recorded. */
+    int nFirstPinTrackedFile = 0;
+/* AMB END */
 } // anon namespace
 
 //////////////////////////////////////////////////////////////////////////////
@@ -334,6 +353,8 @@ struct CNodeState {
     int nBlocksInFlight;
     //! Whether we consider this a preferred download peer.
     bool fPreferredDownload;
+    //! Compact block waiting for "blocktxn" from this peer.
+    boost::shared_ptr<PartiallyDownloadedBlock> partialBlock;
 
     CNodeState() {
         nMisbehavior = 0;
@@ -351,6 +372,9 @@ struct CNodeState {
 /** Map maintaining per-node state. Requires cs_main. */
 map<NodeId, CNodeState> mapNodeState;
 
+/** Compact block relay counters. Requires cs_main. */
+CCompactBlockStats compactBlockStats;
+
 /* MCHN START */
 
 int MultichainNode_ApplyUpgrades(int current_height)
@@ -710,7 +734,10 @@ void FindNextBlocksToDownload(NodeId nodeid, unsigned int count, std::vector<CBl
                 }
             }
 /* MCHN END */            
-            if (pindex->nStatus & BLOCK_HAVE_DATA) {
+/* AMB START */
+            // Pruned blocks of the active chain are not downloaded again
+            if ((pindex->nStatus & BLOCK_HAVE_DATA) || chainActive.Contains(pindex)) {
+/* AMB END */
                 if (pindex->nChainTx)
                     state->pindexLastCommonBlock = pindex;
             } else if (mapBlocksInFlight.count(pindex->GetBlockHash()) == 0) {
@@ -756,6 +783,7 @@ void RegisterNodeSignals(CNodeSignals& nodeSignals)
 {
     nodeSignals.GetHeight.connect(&GetHeight);
     nodeSignals.ProcessMessages.connect(&ProcessMessages);
+    nodeSignals.ProcessConcurrentMessages.connect(&ProcessConcurrentMessages);
     nodeSignals.SendMessages.connect(&SendMessages);
     nodeSignals.InitializeNode.connect(&InitializeNode);
     nodeSignals.FinalizeNode.connect(&FinalizeNode);
@@ -765,6 +793,7 @@ void UnregisterNodeSignals(CNodeSignals& nodeSignals)
 {
     nodeSignals.GetHeight.disconnect(&GetHeight);
     nodeSignals.ProcessMessages.disconnect(&ProcessMessages);
+    nodeSignals.ProcessConcurrentMessages.disconnect(&ProcessConcurrentMessages);
     nodeSignals.SendMessages.disconnect(&SendMessages);
     nodeSignals.InitializeNode.disconnect(&InitializeNode);
     nodeSignals.FinalizeNode.disconnect(&FinalizeNode);
@@ -1252,6 +1281,37 @@ CAmount GetMinRelayFee(const CTransaction& tx, unsigned int nBytes, bool fAllowF
     return nMinFee;
 }
 
+/* AMB START */
+/** 
+ * Returns streams the transaction publishes items to, each stream once
+ */
+static void GetTxStreams(const CTransaction& tx, mc_Script *lpScript, std::vector<uint160>& vStreams)
+{
+    for (unsigned int j = 0; j < tx.vout.size(); j++)
+    {
+        const CScript& script1 = tx.vout[j].scriptPubKey;        
+        CScript::const_iterator pc1 = script1.begin();
+
+        lpScript->Clear();
+        lpScript->SetScript((unsigned char*)(&pc1[0]),(size_t)(script1.end()-pc1),MC_SCR_TYPE_SCRIPTPUBKEY);
+        if( (lpScript->IsOpReturnScript() != 0 ) && (lpScript->GetNumElements() == 3) )
+        {
+            unsigned char short_txid[MC_AST_SHORT_TXID_SIZE];
+            lpScript->SetElement(0);
+            if(lpScript->GetEntity(short_txid) == 0)
+            {
+                uint160 stream_id=0;
+                memcpy(&stream_id,short_txid,MC_AST_SHORT_TXID_SIZE);
+                if(find(vStreams.begin(),vStreams.end(),stream_id) == vStreams.end())
+                {
+                    vStreams.push_back(stream_id);
+                }
+            }
+        }
+    }
+}
+/* AMB END */
+
 bool AcceptToMemoryPool(CTxMemPool& pool, CValidationState &state, const CTransaction &tx, bool fLimitFree,
                         bool* pfMissingInputs, bool fRejectInsaneFee,bool fAddToWallet)
 {
@@ -1433,9 +1493,13 @@ bool AcceptToMemoryPool(CTxMemPool& pool, CValidationState &state, const CTransa
                              REJECT_INSUFFICIENTFEE, "insufficient fee");
 
 
+        // AMB: Fee exemption is decided once here and reused by block assembly until ReplayMemPool
+        // sees a permission or transactionparams change
+        entry.SetFeeExempt(txsenderisminer(tx), GetFeeExemptionVersion());
+
         // Require that free transactions have sufficient priority to be mined in the next block.
         // AMB: Ignore this check if the sender is a miner
-        if (GetBoolArg("-relaypriority", true) && !txsenderisminer(tx) && nFees < ::minRelayTxFee.GetFee(nSize) && !AllowFree(view.GetPriority(tx, chainActive.Height() + 1))) {
+        if (GetBoolArg("-relaypriority", true) && !entry.IsFeeExempt() && nFees < ::minRelayTxFee.GetFee(nSize) && !AllowFree(view.GetPriority(tx, chainActive.Height() + 1))) {
             return state.DoS(0, false, REJECT_INSUFFICIENTFEE, "insufficient priority");
         }
 
@@ -1525,6 +1589,39 @@ bool AcceptToMemoryPool(CTxMemPool& pool, CValidationState &state, const CTransa
 /* MCHN END */        
         }
                 
+/* AMB START */
+        // Memory limit and per-stream quota are checked before the transaction changes permission, entity and wallet state
+        std::vector<uint256> vEvict;
+        uint64_t nMaxMempool = (uint64_t)GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000;
+        if (nMaxMempool)
+        {
+            std::vector<uint160> vStreams;
+            GetTxStreams(tx, mc_gState->m_TmpScript, vStreams);
+            entry.SetStreams(vStreams);
+            entry.AddUsageSize(vStreams.size() * sizeof(uint160));
+            
+            uint64_t nStreamQuota = nMaxMempool / 100 * GetArg("-mempoolstreamquota", DEFAULT_MEMPOOL_STREAM_QUOTA);
+            if (!entry.IsFeeExempt() && nStreamQuota)
+            {
+                for (unsigned int i = 0; i < vStreams.size(); i++)
+                {
+                    if (pool.GetStreamUsage(vStreams[i]) + entry.GetUsageSize() > nStreamQuota)
+                        return state.DoS(0, error("AcceptToMemoryPool: : stream quota exceeded %s", hash.ToString()),
+                                         REJECT_INSUFFICIENTFEE, "mempool stream quota exceeded");
+                }
+            }
+            
+            if (pool.DynamicMemoryUsage() + entry.GetUsageSize() > nMaxMempool)
+            {
+                double dMaxFeeRate = entry.IsFeeExempt() ? std::numeric_limits<double>::max() : entry.GetFeeRate();
+                int64_t nExpiryTime = GetTime() - GetArg("-mempoolexpiry", DEFAULT_MEMPOOL_EXPIRY) * 60 * 60;
+                if (!pool.SelectForEviction(nMaxMempool, entry.GetUsageSize(), dMaxFeeRate, nExpiryTime, tx, vEvict))
+                    return state.DoS(0, error("AcceptToMemoryPool: : mempool full %s", hash.ToString()),
+                                     REJECT_INSUFFICIENTFEE, "mempool full");
+            }
+        }
+/* AMB END */
+        
 /* MCHN START */
         
         uint32_t replay=0;
@@ -1564,6 +1661,7 @@ bool AcceptToMemoryPool(CTxMemPool& pool, CValidationState &state, const CTransa
         
         if(fAddToWallet)
         {
+            size_t wallet_usage=pwalletTxsMain->GetMempoolUsage();
             int err=pwalletTxsMain->AddTx(NULL,tx,-1,NULL,-1,0);
             if(err)
             {
@@ -1572,6 +1670,11 @@ bool AcceptToMemoryPool(CTxMemPool& pool, CValidationState &state, const CTransa
                                  error("AcceptToMemoryPool: : AcceptMultiChainTransaction failed %s : %s", hash.ToString(),reason),
                                  REJECT_INVALID, reason);            
             }
+            size_t wallet_usage_after=pwalletTxsMain->GetMempoolUsage();
+            if(wallet_usage_after > wallet_usage)
+            {
+                entry.AddUsageSize(wallet_usage_after-wallet_usage);
+            }
         }
         
         permissions_to=mc_gState->m_Permissions->m_MempoolPermissions->GetCount();
@@ -1580,6 +1683,14 @@ bool AcceptToMemoryPool(CTxMemPool& pool, CValidationState &state, const CTransa
 /* MCHN END */    
         // Store transaction in memory
         pool.addUnchecked(hash, entry);
+/* AMB START */
+        if (!vEvict.empty())
+        {
+            std::list<CTransaction> removed;
+            pool.Evict(vEvict, removed);
+            if(fDebug)LogPrint("mempool", "AcceptToMemoryPool: %u transactions evicted for %s, mempool usage %u\n", (unsigned int)removed.size(), hash.ToString(), pool.DynamicMemoryUsage());
+        }
+/* AMB END */
     }
 
     if(fAddToWallet)
@@ -1937,7 +2048,7 @@ bool CScriptCheck::operator()() {
 //    mc_DumpSize("sigScript",(unsigned char*)(&scriptSig.begin()[0]),scriptSig.end()-scriptSig.begin(),scriptSig.end()-scriptSig.begin());
 //    mc_DumpSize("scriptPubKey",(unsigned char*)(&scriptPubKey.begin()[0]),scriptPubKey.end()-scriptPubKey.begin(),scriptPubKey.end()-scriptPubKey.begin());
  */ 
-    if (!VerifyScript(scriptSig, scriptPubKey, nFlags, CachingTransactionSignatureChecker(ptxTo, nIn, cacheStore), &error)) {
+    if (!VerifyScript(scriptSig, scriptPubKey, nFlags, CachingTransactionSignatureChecker(ptxTo, nIn, cacheStore, sighashcache.get()), &error)) {
         return ::error("CScriptCheck(): %s:%d VerifySignature failed: %s", ptxTo->GetHash().ToString(), nIn, ScriptErrorString(error));
     }
     return true;
@@ -2050,13 +2161,19 @@ bool CheckInputs(const CTransaction& tx, CValidationState &state, const CCoinsVi
         // before the last block chain checkpoint. This is safe because block merkle hashes are
         // still computed and checked, and any change will be caught at the next checkpoint.
         if (fScriptChecks) {
+/* AMB START */
+            // Parts of signature hash shared by all inputs are computed once
+            boost::shared_ptr<const CSignatureHashCache> sighashcache;
+            if (tx.vin.size() >= SIGHASH_CACHE_MIN_INPUTS)
+                sighashcache.reset(new CSignatureHashCache(tx));
+/* AMB END */
             for (unsigned int i = 0; i < tx.vin.size(); i++) {
                 const COutPoint &prevout = tx.vin[i].prevout;
                 const CCoins* coins = inputs.AccessCoins(prevout.hash);
                 assert(coins);
 
                 // Verify signature
-                CScriptCheck check(*coins, tx, i, flags | vSendPermissionFlags[i], cacheStore);
+                CScriptCheck check(*coins, tx, i, flags | vSendPermissionFlags[i], cacheStore, sighashcache);
 //                if (pvChecks) {
                 if ( (pvChecks != NULL) && (vSendPermissionFlags[i] != 0) ) {
                     pvChecks->push_back(CScriptCheck());
@@ -2070,7 +2187,7 @@ bool CheckInputs(const CTransaction& tx, CValidationState &state, const CCoinsVi
                         // avoid splitting the network between upgraded and
                         // non-upgraded nodes.
                         CScriptCheck check(*coins, tx, i,
-                                flags & ~STANDARD_NOT_MANDATORY_VERIFY_FLAGS, cacheStore);
+                                flags & ~STANDARD_NOT_MANDATORY_VERIFY_FLAGS, cacheStore, sighashcache);
                         if (check())
                             return state.Invalid(false, REJECT_NONSTANDARD, strprintf("non-mandatory-script-verify-flag (%s)", ScriptErrorString(check.GetScriptError())));
                     }
@@ -2095,6 +2212,26 @@ bool CheckInputs(const CTransaction& tx, CValidationState &state, const CCoinsVi
 
 
 
+/* AMB START */
+/** 
+ * Returns stream index keys for stream items published in the block, one key per stream per transaction
+ */
+static void GetStreamIndexKeys(const CBlock& block, int nHeight, std::vector<CStreamIndexKey>& vKeys)
+{
+    mc_Script *lpScript=new mc_Script;
+    for (unsigned int i = 0; i < block.vtx.size(); i++)
+    {
+        std::vector<uint160> vStreams;
+        GetTxStreams(block.vtx[i], lpScript, vStreams);
+        for (unsigned int j = 0; j < vStreams.size(); j++)
+        {
+            vKeys.push_back(CStreamIndexKey((unsigned char*)&vStreams[j],nHeight,i));
+        }
+    }
+    delete lpScript;
+}
+/* AMB END */
+
 bool DisconnectBlock(CBlock& block, CValidationState& state, CBlockIndex* pindex, CCoinsViewCache& view, bool* pfClean)
 {
     assert(pindex->GetBlockHash() == view.GetBestBlock());
@@ -2207,6 +2344,126 @@ void static FlushBlockFile(bool fFinalize = false)
 
 bool FindUndoPos(CValidationState &state, int nFile, CDiskBlockPos &pos, unsigned int nAddSize);
 
+/* AMB START */
+void PinBlockFile(int nFile)
+{
+    if (nFile < 0)
+        return;
+
+    LOCK(cs_PinnedBlockFiles);
+    if (setPinnedBlockFiles.count(nFile))
+        return;
+    // Written synchronously, pin should be on disk before wallet row referencing the file
+    if (!pblocktree->WritePinnedBlockFile(nFile))
+        LogPrintf("PinBlockFile: cannot write pin for block file %05u\n", nFile);
+    setPinnedBlockFiles.insert(nFile);
+    if(fDebug)LogPrint("prune", "Block file %05u is referenced by wallet\n", nFile);
+}
+
+static bool IsBlockFilePinned(int nFile)
+{
+    LOCK(cs_PinnedBlockFiles);
+    return (nFile < nFirstPinTrackedFile) || (setPinnedBlockFiles.count(nFile) != 0);
+}
+
+int GetPruneKeepDepth()
+{
+    int nKeepDepth = std::max(nPruneDepth, MIN_PRUNE_DEPTH);
+    if (mc_gState->m_NetworkParams->IsProtocolMultichain())
+    {
+        int nMinerCount = mc_gState->m_Permissions->GetMinerCount() + 1;
+        // LastActiveMiners reads blocks in its window if the miner is not cached in block index
+        nKeepDepth = std::max(nKeepDepth, 6 * nMinerCount);
+        // Forks within lock-admin-mine-rounds can be accepted, disconnecting them rolls back permissions and assets
+        nKeepDepth = std::max(nKeepDepth, Params().LockAdminMineRounds() * nMinerCount);
+    }
+    return nKeepDepth;
+}
+
+int GetLastPrunedHeight()
+{
+    AssertLockHeld(cs_main);
+    if (!fHavePruned)
+        return -1;
+    for (CBlockIndex* pindex = chainActive.Tip(); pindex; pindex = pindex->pprev)
+        if (!(pindex->nStatus & BLOCK_HAVE_DATA))
+            return pindex->nHeight;
+    return -1;
+}
+
+/** Clears block data and undo of all blocks in the file, caller deletes the file after block index is flushed */
+static void PruneOneBlockFile(int nFile)
+{
+    for (BlockMap::iterator it = mapBlockIndex.begin(); it != mapBlockIndex.end(); ++it)
+    {
+        CBlockIndex* pindex = it->second;
+        if ((pindex->nFile == nFile) && (pindex->nStatus & (BLOCK_HAVE_DATA | BLOCK_HAVE_UNDO)))
+        {
+            pindex->nStatus &= ~(BLOCK_HAVE_DATA | BLOCK_HAVE_UNDO);
+            pindex->nFile = 0;
+            pindex->nDataPos = 0;
+            pindex->nUndoPos = 0;
+            setDirtyBlockIndex.insert(pindex);
+
+            // Pruned block should be downloaded again before its branch can be considered
+            std::pair<multimap<CBlockIndex*, CBlockIndex*>::iterator, multimap<CBlockIndex*, CBlockIndex*>::iterator> range = mapBlocksUnlinked.equal_range(pindex->pprev);
+            while (range.first != range.second)
+            {
+                multimap<CBlockIndex*, CBlockIndex*>::iterator itUnlinked = range.first;
+                range.first++;
+                if (itUnlinked->second == pindex)
+                    mapBlocksUnlinked.erase(itUnlinked);
+            }
+        }
+    }
+
+    vinfoBlockFile[nFile].SetNull();
+    setDirtyFileInfo.insert(nFile);
+}
+
+/** 
+ * Selects block files with all blocks below keep depth, not containing genesis block and not referenced by wallet.
+ * Block index entries of these files are cleared.
+ */
+static void FindFilesToPrune(set<int>& setFilesToPrune)
+{
+    LOCK2(cs_main, cs_LastBlockFile);
+    if (chainActive.Tip() == NULL)
+        return;
+
+    int nLastBlockWeCanPrune = chainActive.Height() - GetPruneKeepDepth();
+    if (nLastBlockWeCanPrune <= 0)
+        return;
+
+    for (int nFile = 0; nFile < nLastBlockFile; nFile++)
+    {
+        const CBlockFileInfo& info = vinfoBlockFile[nFile];
+        if ((info.nBlocks == 0) || (info.nHeightFirst == 0))
+            continue;
+        if ((int)info.nHeightLast > nLastBlockWeCanPrune)
+            continue;
+        if (IsBlockFilePinned(nFile))
+            continue;
+        PruneOneBlockFile(nFile);
+        setFilesToPrune.insert(nFile);
+    }
+
+    if (!setFilesToPrune.empty())
+        LogPrintf("Prune: %d block files below height %d selected, keep depth %d\n", setFilesToPrune.size(), nLastBlockWeCanPrune, GetPruneKeepDepth());
+}
+
+static void UnlinkPrunedFiles(const set<int>& setFilesToPrune)
+{
+    for (set<int>::const_iterator it = setFilesToPrune.begin(); it != setFilesToPrune.end(); ++it)
+    {
+        CDiskBlockPos pos(*it, 0);
+        boost::filesystem::remove(GetBlockPosFilename(pos, "blk"));
+        boost::filesystem::remove(GetBlockPosFilename(pos, "rev"));
+        if(fDebug)LogPrint("prune", "Prune: deleted blk/rev %05u\n", *it);
+    }
+}
+/* AMB END */
+
 static CCheckQueue<CScriptCheck> scriptcheckqueue(128);
 
 void ThreadScriptCheck() {
@@ -2574,6 +2831,23 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
         if (!pblocktree->WriteTxIndex(vPos))
             return state.Abort("Failed to write transaction index");
 
+/* AMB START */
+    if (fStreamIndex)
+    {
+        std::vector<CStreamIndexKey> vKeys;
+        GetStreamIndexKeys(block, pindex->nHeight, vKeys);
+        if (!vKeys.empty())
+        {
+            std::vector<std::pair<CStreamIndexKey, CDiskTxPos> > vStreamPos;
+            vStreamPos.reserve(vKeys.size());
+            for (unsigned int i = 0; i < vKeys.size(); i++)
+                vStreamPos.push_back(std::make_pair(vKeys[i], vPos[vKeys[i].nTx].second));
+            if (!pblocktree->WriteStreamIndex(vStreamPos))
+                return state.Abort("Failed to write stream index");
+        }
+    }
+/* AMB END */
+
 /* MCHN START */        
     if(fDebug)LogPrint("mchn","mchn: Committing permission changes for block %d...\n",mc_gState->m_Permissions->m_Block+1);
     if(mc_gState->m_Permissions->Commit(miner_address,&block_hash) != 0)
@@ -2627,8 +2901,25 @@ enum FlushStateMode {
 bool static FlushStateToDisk(CValidationState &state, FlushStateMode mode) {
     LOCK(cs_main);
     static int64_t nLastWrite = 0;
+/* AMB START */
+    set<int> setFilesToPrune;
+    bool fFlushForPrune = false;
+/* AMB END */
     try {
-    if ((mode == FLUSH_STATE_ALWAYS) ||
+/* AMB START */
+    if (fPruneMode && fCheckForPruning && !fReindex) {
+        FindFilesToPrune(setFilesToPrune);
+        fCheckForPruning = false;
+        if (!setFilesToPrune.empty()) {
+            fFlushForPrune = true;
+            if (!fHavePruned) {
+                pblocktree->WriteFlag("prunedblockfiles", true);
+                fHavePruned = true;
+            }
+        }
+    }
+/* AMB END */
+    if ((mode == FLUSH_STATE_ALWAYS) || fFlushForPrune ||
         ((mode == FLUSH_STATE_PERIODIC || mode == FLUSH_STATE_IF_NEEDED) && pcoinsTip->GetCacheSize() > nCoinCacheSize) ||
         (mode == FLUSH_STATE_PERIODIC && GetTimeMicros() > nLastWrite + DATABASE_WRITE_INTERVAL * 1000000)) {
         // Typical CCoins structures on disk are around 100 bytes in size.
@@ -2659,6 +2950,11 @@ bool static FlushStateToDisk(CValidationState &state, FlushStateMode mode) {
              setDirtyBlockIndex.erase(it++);
         }
         pblocktree->Sync();
+/* AMB START */
+        // Files are deleted only after block index no longer refers to them
+        if (fFlushForPrune)
+            UnlinkPrunedFiles(setFilesToPrune);
+/* AMB END */
         // Finally flush the chainstate (which may refer to block index entries).
         if (!pcoinsTip->Flush())
             return state.Abort("Failed to write to coin database");
@@ -2741,9 +3037,20 @@ bool static DisconnectTip(CValidationState &state) {
             return error("DisconnectTip() : DisconnectBlock %s failed", pindexDelete->GetBlockHash().ToString());
         assert(view.Flush());
     }
+/* AMB START */
+    if (fStreamIndex)
+    {
+        std::vector<CStreamIndexKey> vKeys;
+        GetStreamIndexKeys(block, pindexDelete->nHeight, vKeys);
+        if (!vKeys.empty() && !pblocktree->EraseStreamIndex(vKeys))
+            return state.Abort("Failed to erase stream index");
+    }
+/* AMB END */
     if(fDebug)LogPrint("bench", "- Disconnect block: %.2fms\n", (GetTimeMicros() - nStart) * 0.001);
-    // Write the chain state to disk, if necessary.
-    if (!FlushStateToDisk(state, FLUSH_STATE_ALWAYS))// MCHN was FLUSH_STATE_IF_NEEDED
+    // Write the chain state to disk.
+    // AMB: MultiChain ledgers are rolled back by height only, chainstate is flushed before they leave this branch,
+    // so after a crash they are never ahead of the chainstate on a different branch.
+    if (!FlushStateToDisk(state, FLUSH_STATE_ALWAYS))
         return false;
     
 /* MCHN START */    
@@ -2850,7 +3157,9 @@ bool static ConnectTip(CValidationState &state, CBlockIndex *pindexNew, CBlock *
     int64_t nTime4 = GetTimeMicros(); nTimeFlush += nTime4 - nTime3;
     if(fDebug)LogPrint("bench", "  - Flush: %.2fms [%.2fs]\n", (nTime4 - nTime3) * 0.001, nTimeFlush * 0.000001);
     // Write the chain state to disk, if necessary.
-    if (!FlushStateToDisk(state, FLUSH_STATE_ALWAYS))// MCHN was FLUSH_STATE_IF_NEEDED
+    // AMB: MultiChain ledgers committed in ConnectBlock may get ahead of the flushed chainstate,
+    // they are rolled back to the chainstate best block on startup, see LoadBlockIndexDB.
+    if (!FlushStateToDisk(state, FLUSH_STATE_IF_NEEDED))
         return false;
     int64_t nTime5 = GetTimeMicros(); nTimeChainState += nTime5 - nTime4;
     if(fDebug)LogPrint("bench", "  - Writing chainstate: %.2fms [%.2fs]\n", (nTime5 - nTime4) * 0.001, nTimeChainState * 0.000001);
@@ -3970,6 +4279,10 @@ bool FindBlockPos(CValidationState &state, CDiskBlockPos &pos, unsigned int nAdd
         while (vinfoBlockFile[nFile].nSize + nAddSize >= MAX_BLOCKFILE_SIZE) {
             LogPrintf("Leaving block file %i: %s\n", nFile, vinfoBlockFile[nFile].ToString());
             FlushBlockFile(true);
+/* AMB START */
+            if (fPruneMode)
+                fCheckForPruning = true;
+/* AMB END */
             nFile++;
             if (vinfoBlockFile.size() <= nFile) {
                 vinfoBlockFile.resize(nFile + 1);
@@ -4464,20 +4777,11 @@ bool AcceptBlock(CBlock& block, CValidationState& state, CBlockIndex** ppindex,
     // verify that the coinbase transaction includes part of the fee sent to the admin
     try
     {
-        double adminFeeRatio = StreamUtils::GetAdminFeeRatio();
-        std::string adminAddrStr = StreamUtils::GetAdminPublicKey();
+        CScript adminScript;
+        double adminFeeRatio = 0;
         // if not set, no need to do anything
-        if (adminFeeRatio > 0 && adminAddrStr.compare("0") != 0)
+        if (StreamUtils::GetAdminFeeParams(pindex->nHeight, adminScript, adminFeeRatio))
         {
-            // derive the admin address's expected script
-            // TODO: Refactor: Extract this and the corresponding similar code in miner.cpp into a util
-            std::vector<unsigned char> data(adminAddrStr.begin(), adminAddrStr.end());
-            CPubKey pubkey(data);
-            const unsigned char *pubkey_hash=(unsigned char *)Hash160(pubkey.begin(),pubkey.end()).begin();
-            CScript scriptPubKey = CScript() << OP_DUP << OP_HASH160 << std::vector<unsigned char>(pubkey_hash, pubkey_hash + 20) << OP_EQUALVERIFY << OP_CHECKSIG;
-
-            std::string adminScriptAsString = scriptPubKey.ToString();
-
             CAmount txFee = 0;
             CAmount adminFee = 0;
             BOOST_FOREACH(const CTransaction& tx, block.vtx)
@@ -4488,7 +4792,7 @@ bool AcceptBlock(CBlock& block, CValidationState& state, CBlockIndex** ppindex,
                     {
                         if (txOut.scriptPubKey.at(0) == OP_DUP && txOut.scriptPubKey.at(1) == OP_HASH160)
                         {
-                            if (txOut.scriptPubKey.ToString() == adminScriptAsString) 
+                            if (txOut.scriptPubKey == adminScript)
                             {
                                 adminFee = txOut.nValue;
                             }
@@ -4501,7 +4805,7 @@ bool AcceptBlock(CBlock& block, CValidationState& state, CBlockIndex** ppindex,
                     if (txFee > 0 && adminFee > 0)
                     {
                         CAmount sum = txFee + adminFee;
-                        CAmount expectedAdminFee = sum * adminFeeRatio;
+                        CAmount expectedAdminFee = StreamUtils::GetAdminFee(sum, adminFeeRatio);
                         // 0.00000001 -> 8 decimal places = AMTC precision
                         if (expectedAdminFee != adminFee) {
                             LogPrintf("txFee: %s\n", txFee);
@@ -4639,6 +4943,9 @@ void CBlockIndex::BuildSkip()
 
 bool ProcessNewBlock(CValidationState &state, CNode* pfrom, CBlock* pblock, CDiskBlockPos *dbp)
 {
+/* AMB START */
+    CDBDeferLogSync deferLogSync;                                               // Wallet log is synced after cs_main is released
+/* AMB END */
 /* MCHN START*/    
     {
         LOCK(cs_main);
@@ -4885,7 +5192,10 @@ bool static LoadBlockIndexDB()
     {
         CBlockIndex* pindex = item.second;
         pindex->nChainWork = (pindex->pprev ? pindex->pprev->nChainWork : 0) + GetBlockProof(*pindex);
-        if (pindex->nStatus & BLOCK_HAVE_DATA) {
+/* AMB START */
+        // nTx is kept when block is pruned, so pruned blocks still link their descendants
+        if (pindex->nTx > 0) {
+/* AMB END */
             if (pindex->pprev) {
                 if (pindex->pprev->nChainTx) {
                     pindex->nChainTx = pindex->pprev->nChainTx + pindex->nTx;
@@ -4950,6 +5260,29 @@ bool static LoadBlockIndexDB()
     // Check whether we have a transaction index
     pblocktree->ReadFlag("txindex", fTxIndex);
     LogPrintf("LoadBlockIndexDB(): transaction index %s\n", fTxIndex ? "enabled" : "disabled");
+/* AMB START */
+    pblocktree->ReadFlag("streamindex", fStreamIndex);
+    LogPrintf("LoadBlockIndexDB(): stream index %s\n", fStreamIndex ? "enabled" : "disabled");
+
+    // Load wallet block file pins, files written before pins were recorded are never pruned
+    {
+        LOCK(cs_PinnedBlockFiles);
+        setPinnedBlockFiles.clear();
+        for (int nFile = 0; nFile <= nLastBlockFile; nFile++) {
+            if (pblocktree->IsPinnedBlockFile(nFile))
+                setPinnedBlockFiles.insert(nFile);
+        }
+        if (!pblocktree->ReadFirstPinTrackedFile(nFirstPinTrackedFile)) {
+            nFirstPinTrackedFile = mapBlockIndex.empty() ? 0 : nLastBlockFile + 1;
+            pblocktree->WriteFirstPinTrackedFile(nFirstPinTrackedFile);
+        }
+    }
+    pblocktree->ReadFlag("prunedblockfiles", fHavePruned);
+    LogPrintf("LoadBlockIndexDB(): %d pinned block files, pins tracked from file %d%s\n", setPinnedBlockFiles.size(), nFirstPinTrackedFile,
+              fHavePruned ? ", some block files were pruned" : "");
+    if (fPruneMode)
+        fCheckForPruning = true;
+/* AMB END */
 
     // Load pointer to end of best chain
     BlockMap::iterator it = mapBlockIndex.find(pcoinsTip->GetBestBlock());
@@ -4971,6 +5304,24 @@ bool static LoadBlockIndexDB()
         corrupted=true;
         LogPrintf("mchn: Entities DB is behind current chain tip. Entities DB: %d, Chain tip: %d\n",mc_gState->m_Assets->m_Block,chainActive.Height());        
     }
+/* AMB START */
+    int block_verified=chainActive.Height();
+    if(mc_gState->m_Permissions->m_Block > chainActive.Height())
+    {
+        LogPrintf("mchn: Permission DB is ahead of chainstate after unclean shutdown. Permission DB: %d, Chain tip: %d\n",mc_gState->m_Permissions->m_Block,chainActive.Height());        
+    }
+    while( mc_gState->m_NetworkParams->IsProtocolMultichain() && 
+           (block_verified > 0) && (block_verified <= mc_gState->m_Permissions->m_Block) && 
+           (mc_gState->m_Permissions->VerifyBlockHash(block_verified,chainActive[block_verified]->GetBlockHash().begin()) == 0) )
+    {
+        block_verified--;
+    }
+    if(block_verified < chainActive.Height())
+    {
+        corrupted=true;
+        LogPrintf("mchn: Permission DB and chainstate are on different branches above height %d, Chain tip: %d\n",block_verified,chainActive.Height());                
+    }
+/* AMB END */
     if(mc_gState->m_Permissions->m_Block != mc_gState->m_Assets->m_Block)
     {
         corrupted=true;
@@ -5010,6 +5361,10 @@ bool static LoadBlockIndexDB()
                 }
             }
         }
+        if(block_verified < block_to_rollback)
+        {
+            block_to_rollback=block_verified;
+        }
         if(block_to_rollback < 0)
         {
             block_to_rollback=0;
@@ -5077,6 +5432,13 @@ bool CVerifyDB::VerifyDB(CCoinsView *coinsview, int nCheckLevel, int nCheckDepth
         uiInterface.ShowProgress(_("Verifying blocks..."), std::max(1, std::min(99, (int)(((double)(chainActive.Height() - pindex->nHeight)) / (double)nCheckDepth * (nCheckLevel >= 4 ? 50 : 100)))));
         if (pindex->nHeight < chainActive.Height()-nCheckDepth)
             break;
+/* AMB START */
+        if (fPruneMode && !(pindex->nStatus & BLOCK_HAVE_DATA)) {
+            // Blocks below this one were pruned too
+            LogPrintf("VerifyDB(): block verification stopped at height %d, pruned data\n", pindex->nHeight);
+            break;
+        }
+/* AMB END */
         CBlock block;
         // check level 0: read from disk
         if (!ReadBlockFromDisk(block, pindex))
@@ -5165,6 +5527,10 @@ bool InitBlockIndex() {
     fTxIndex = GetBoolArg("-txindex", true);
 /* MCHN END */    
     pblocktree->WriteFlag("txindex", fTxIndex);
+/* AMB START */
+    fStreamIndex = GetBoolArg("-streamindex", true);
+    pblocktree->WriteFlag("streamindex", fStreamIndex);
+/* AMB END */
     LogPrintf("Initializing databases...\n");
 
     // Only add the genesis block if not reindexing (in which case we reuse the one already on disk)
@@ -5401,8 +5767,6 @@ void static ProcessGetData(CNode* pfrom)
     
     vector<CInv> vNotFound;
 
-    LOCK(cs_main);
-
     while (it != pfrom->vRecvGetData.end()) {
         // Don't bother if send buffer is too full to respond anyway
         if (pfrom->nSendSize >= SendBufferSize())
@@ -5413,8 +5777,13 @@ void static ProcessGetData(CNode* pfrom)
             boost::this_thread::interruption_point();
             it++;
 
-            if (inv.type == MSG_BLOCK || inv.type == MSG_FILTERED_BLOCK)
+            if (inv.type == MSG_BLOCK || inv.type == MSG_FILTERED_BLOCK || inv.type == MSG_CMPCT_BLOCK)
             {
+/* AMB START */
+                // Transactions are served from relay memory and mempool, only blocks need cs_main,
+                // which allows getdata for transactions to be processed by message processing workers
+                LOCK(cs_main);
+/* AMB END */
                 bool send = false;
                 BlockMap::iterator mi = mapBlockIndex.find(inv.hash);
                 if (mi != mapBlockIndex.end())
@@ -5433,6 +5802,13 @@ void static ProcessGetData(CNode* pfrom)
                     } else {
                         send = true;
                     }
+/* AMB START */
+                    if (send && !(mi->second->nStatus & BLOCK_HAVE_DATA))
+                    {
+                        if(fDebug)LogPrint("prune", "ProcessGetData(): ignoring request for pruned block %s\n", inv.hash.ToString());
+                        send = false;
+                    }
+/* AMB END */
                 }
                 if (send)
                 {
@@ -5444,6 +5820,22 @@ void static ProcessGetData(CNode* pfrom)
                     if(fDebug)LogPrint("mcnet","mcnet: Sending block: %s (height %d), to peer=%d\n",inv.hash.ToString().c_str(),mi->second->nHeight,pfrom->id);            
                     if (inv.type == MSG_BLOCK)
                         pfrom->PushMessage("block", block);
+/* AMB START */
+                    else if (inv.type == MSG_CMPCT_BLOCK)
+                    {
+                        // Transactions of older blocks are unlikely to be in peer's mempool
+                        if ((*mi).second->nHeight >= chainActive.Height() - MAX_CMPCTBLOCK_DEPTH)
+                        {
+                            CBlockHeaderAndShortTxIDs cmpctblock(block);
+                            pfrom->PushMessage("cmpctblock", cmpctblock);
+                            compactBlockStats.nSent++;
+                        }
+                        else
+                        {
+                            pfrom->PushMessage("block", block);
+                        }
+                    }
+/* AMB END */
                     else // MSG_FILTERED_BLOCK)
                     {
                         LOCK(pfrom->cs_filter);
@@ -5509,7 +5901,7 @@ void static ProcessGetData(CNode* pfrom)
             // Track requests for our stuff.
             g_signals.Inventory(inv.hash);
 
-            if (inv.type == MSG_BLOCK || inv.type == MSG_FILTERED_BLOCK)
+            if (inv.type == MSG_BLOCK || inv.type == MSG_FILTERED_BLOCK || inv.type == MSG_CMPCT_BLOCK)
                 break;
         }
     }
@@ -5585,12 +5977,127 @@ void CompleteProcessVersion(CNode* pfrom)
             item.second.RelayTo(pfrom);
     }
 
+/* AMB START */
+    // Ask peer to send recent blocks as short transaction IDs, peers not supporting it ignore the message
+    if (GetBoolArg("-compactblocks", DEFAULT_COMPACT_BLOCKS))
+        pfrom->PushMessage("sendcmpct", false, COMPACT_BLOCKS_VERSION);
+/* AMB END */
+
     pfrom->fSuccessfullyConnected = true;
 }
 
 /* MCHN END */
 
 
+/* AMB START */
+
+void GetCompactBlockStats(CCompactBlockStats& stats)
+{
+    LOCK(cs_main);
+    stats = compactBlockStats;
+}
+
+// Requires cs_main. Unconfirmed wallet transactions, used when they are no longer in mempool
+static void GetCompactBlockExtraTxs(std::vector<CTransaction>& vExtra)
+{
+    vExtra.clear();
+    if(pwalletTxsMain && (mc_gState->m_WalletMode & MC_WMD_TXS))
+    {
+        vExtra.reserve(pwalletTxsMain->m_UnconfirmedSends.size());
+        for(map<uint256,CWalletTx>::const_iterator it = pwalletTxsMain->m_UnconfirmedSends.begin(); it != pwalletTxsMain->m_UnconfirmedSends.end(); ++it)
+        {
+            if(!mempool.exists(it->first))
+            {
+                vExtra.push_back(it->second);
+            }
+        }
+    }
+}
+
+// Requires cs_main.
+static void CompactBlockReconstructed(const PartiallyDownloadedBlock& partialBlock, size_t nRequested)
+{
+    if(nRequested)
+    {
+        compactBlockStats.nReconstructedRoundTrip++;
+    }
+    else
+    {
+        compactBlockStats.nReconstructed++;
+    }
+    compactBlockStats.nTxPrefilled += partialBlock.GetPrefilledCount();
+    compactBlockStats.nTxFromMempool += partialBlock.GetMempoolCount();
+    compactBlockStats.nTxFromWallet += partialBlock.GetExtraCount();
+    compactBlockStats.nTxRequested += nRequested;
+    compactBlockStats.nReconstructionTime += GetTimeMicros() - partialBlock.nTimeStart;
+}
+
+// Requires cs_main. Reconstruction failed, e.g. because of short ID collision, full block is requested instead
+static void CompactBlockFallback(CNode* pfrom, const uint256& hash)
+{
+    compactBlockStats.nFallback++;
+    vector<CInv> vInv(1, CInv(MSG_BLOCK, hash));
+    pfrom->PushMessage("getdata", vInv);
+}
+
+// Returns true if seed node has connect permission, sampled before received block is processed
+static bool SeedNodeCouldConnect()
+{
+    LOCK(cs_main);
+    CNode* seed_node=(CNode*)(mc_gState->m_pSeedNode);
+    if(seed_node)
+    {
+        return mc_gState->m_Permissions->CanConnect(NULL,seed_node->kAddrRemote.begin());
+    }
+    return false;
+}
+
+// Forgets seed node if it lost connect permission in the block just processed, see SeedNodeCouldConnect
+static void CheckSeedNodeConnectPermission(bool seed_could_connect)
+{
+    LOCK(cs_main);
+    CNode* seed_node=(CNode*)(mc_gState->m_pSeedNode);
+    if(seed_node)
+    {
+        if(seed_could_connect && !mc_gState->m_Permissions->CanConnect(NULL,seed_node->kAddrRemote.begin()))
+        {
+            if(vNodes.size() > 1)
+            {
+                LogPrintf("mchn: Seed node lost connect permission on block %d\n",mc_gState->m_Permissions->m_Block);
+                mc_RemoveFile(mc_gState->m_NetworkParams->Name(),"seed",".dat",MC_FOM_RELATIVE_TO_DATADIR);
+                mc_gState->m_pSeedNode=NULL;
+            }
+        }
+    }
+}
+
+// Should be called without cs_main, the same way full blocks received from peers are processed
+static void ProcessCompactBlock(CNode* pfrom, CBlock& block)
+{
+    CInv inv(MSG_BLOCK, block.GetHash());
+    pfrom->AddInventoryKnown(inv);
+
+    if(fDebug)LogPrint("mcblock","mchn-block: Reconstructed block:   %s,  peer=%d\n",inv.hash.ToString().c_str(),pfrom->id);
+
+    bool seed_could_connect=SeedNodeCouldConnect();
+
+    CValidationState state;
+    ProcessNewBlock(state, pfrom, &block);
+    int nDoS;
+    if (state.IsInvalid(nDoS)) {
+        pfrom->PushMessage("reject", string("block"), state.GetRejectCode(),
+                           state.GetRejectReason().substr(0, MAX_REJECT_MESSAGE_LENGTH), inv.hash);
+        if (nDoS > 0) {
+            LOCK(cs_main);
+            Misbehaving(pfrom->GetId(), nDoS);
+        }
+    }
+
+    CheckSeedNodeConnectPermission(seed_could_connect);
+}
+
+/* AMB END */
+
 bool static ProcessMessage(CNode* pfrom, string strCommand, CDataStream& vRecv, int64_t nTimeReceived)
 {
 /* MCHN START */
@@ -6022,7 +6529,15 @@ bool static ProcessMessage(CNode* pfrom, string strCommand, CDataStream& vRecv,
         }
 
         if (!vToFetch.empty() && !MultichainNode_IgnoreIncoming(pfrom))      // MCHN
+        {
+/* AMB START */
+            // Blocks announced near the tip are requested compact, their transactions are likely in our mempool
+            if (pfrom->fSupportsCompactBlocks && GetBoolArg("-compactblocks", DEFAULT_COMPACT_BLOCKS))
+                BOOST_FOREACH(CInv& inv, vToFetch)
+                    inv.type = MSG_CMPCT_BLOCK;
+/* AMB END */
             pfrom->PushMessage("getdata", vToFetch);
+        }
     }
 
 
@@ -6358,16 +6873,7 @@ bool static ProcessMessage(CNode* pfrom, string strCommand, CDataStream& vRecv,
         CBlock block;
         vRecv >> block;
 /* MCHN START */        
-        CNode* seed_node;
-        bool seed_could_connect=false;
-        {
-            LOCK(cs_main);
-            seed_node=(CNode*)(mc_gState->m_pSeedNode);
-            if(seed_node)
-            {
-                seed_could_connect=mc_gState->m_Permissions->CanConnect(NULL,seed_node->kAddrRemote.begin());
-            }            
-        }
+        bool seed_could_connect=SeedNodeCouldConnect();
 /* MCHN END */        
 
         CInv inv(MSG_BLOCK, block.GetHash());
@@ -6398,23 +6904,7 @@ bool static ProcessMessage(CNode* pfrom, string strCommand, CDataStream& vRecv,
 
 /* MCHN START */        
         
-        {
-            LOCK(cs_main);
-            seed_node=(CNode*)(mc_gState->m_pSeedNode);
-            if(seed_node)
-            {
-                LOCK(cs_main);
-                if(seed_could_connect && !mc_gState->m_Permissions->CanConnect(NULL,seed_node->kAddrRemote.begin()))
-                {
-                    if(vNodes.size() > 1)
-                    {
-                        LogPrintf("mchn: Seed node lost connect permission on block %d\n",mc_gState->m_Permissions->m_Block);
-                        mc_RemoveFile(mc_gState->m_NetworkParams->Name(),"seed",".dat",MC_FOM_RELATIVE_TO_DATADIR);
-                        mc_gState->m_pSeedNode=NULL;
-                    }
-                }
-            }
-        }
+        CheckSeedNodeConnectPermission(seed_could_connect);
         
         double end_time=mc_TimeNowAsDouble();
         if(siPos>=0)
@@ -6467,6 +6957,173 @@ bool static ProcessMessage(CNode* pfrom, string strCommand, CDataStream& vRecv,
 /* MCHN END */        
     }
 
+/* AMB START */
+    else if (strCommand == "sendcmpct")
+    {
+        bool fAnnounceUsingCMPCTBLOCK = false;
+        uint64_t nCMPCTBLOCKVersion = 0;
+        vRecv >> fAnnounceUsingCMPCTBLOCK >> nCMPCTBLOCKVersion;
+        // Only low-bandwidth mode is supported: blocks are announced by inv and requested as MSG_CMPCT_BLOCK
+        if (nCMPCTBLOCKVersion == COMPACT_BLOCKS_VERSION)
+        {
+            pfrom->fSupportsCompactBlocks = true;
+            if(fDebug)LogPrint("cmpctblock", "Peer %d supports compact blocks\n", pfrom->id);
+        }
+    }
+
+
+    else if (strCommand == "cmpctblock" && !fImporting && !fReindex && MultichainNode_AcceptData(pfrom))
+    {
+        CBlockHeaderAndShortTxIDs cmpctblock;
+        vRecv >> cmpctblock;
+
+        uint256 hash = cmpctblock.header.GetHash();
+        if(fDebug)LogPrint("cmpctblock", "received cmpctblock %s (%u txs) peer=%d\n", hash.ToString(), cmpctblock.BlockTxCount(), pfrom->id);
+
+        if(MultichainNode_IgnoreIncoming(pfrom))
+        {
+            if(fDebug)LogPrint("net", "ignored cmpctblock %s peer=%d\n", hash.ToString(), pfrom->id);
+            pfrom->AskFor(CInv(MSG_BLOCK, hash));
+            return true;
+        }
+
+        CBlock block;
+        bool fBlockReconstructed = false;
+        {
+            LOCK(cs_main);
+            compactBlockStats.nReceived++;
+
+            BlockMap::iterator mi = mapBlockIndex.find(hash);
+            if (mi != mapBlockIndex.end() && (mi->second->nStatus & BLOCK_HAVE_DATA))
+            {
+                MarkBlockAsReceived(hash);
+                return true;
+            }
+            if (mapBlockIndex.find(cmpctblock.header.hashPrevBlock) == mapBlockIndex.end())
+            {
+                // Doesn't connect to anything we know, sync headers first
+                pfrom->PushMessage("getheaders", chainActive.GetLocator(pindexBestHeader), hash);
+                return true;
+            }
+
+            boost::shared_ptr<PartiallyDownloadedBlock> partialBlock(new PartiallyDownloadedBlock(&mempool));
+            partialBlock->nTimeStart = GetTimeMicros();
+            vector<CTransaction> vExtra;
+            GetCompactBlockExtraTxs(vExtra);
+            ReadStatus status = partialBlock->InitData(cmpctblock, vExtra);
+            if (status == READ_STATUS_INVALID)
+            {
+                Misbehaving(pfrom->GetId(), 100);
+                return error("Peer %d sent us invalid compact block", pfrom->id);
+            }
+            if (status == READ_STATUS_FAILED)
+            {
+                CompactBlockFallback(pfrom, hash);
+                return true;
+            }
+
+            BlockTransactionsRequest req;
+            partialBlock->GetMissingIndexes(req.indexes);
+            if (req.indexes.empty())
+            {
+                vector<CTransaction> vDummy;
+                status = partialBlock->FillBlock(block, vDummy);
+                if (status != READ_STATUS_OK)
+                {
+                    CompactBlockFallback(pfrom, hash);
+                    return true;
+                }
+                CompactBlockReconstructed(*partialBlock, 0);
+                fBlockReconstructed = true;
+            }
+            else
+            {
+                req.blockhash = hash;
+                State(pfrom->GetId())->partialBlock = partialBlock;
+                pfrom->PushMessage("getblocktxn", req);
+                if(fDebug)LogPrint("cmpctblock", "requesting %u missing txs of block %s from peer=%d\n", req.indexes.size(), hash.ToString(), pfrom->id);
+            }
+        }
+
+        if (fBlockReconstructed)
+            ProcessCompactBlock(pfrom, block);
+    }
+
+
+    else if (strCommand == "getblocktxn" && MultichainNode_RespondToGetData(pfrom))
+    {
+        BlockTransactionsRequest req;
+        vRecv >> req;
+
+        LOCK(cs_main);
+
+        BlockMap::iterator mi = mapBlockIndex.find(req.blockhash);
+        if (mi == mapBlockIndex.end() || !(mi->second->nStatus & BLOCK_HAVE_DATA))
+        {
+            LogPrintf("Peer %d sent us a getblocktxn for a block we don't have\n", pfrom->id);
+            return true;
+        }
+
+        CBlock block;
+        if (!ReadBlockFromDisk(block, mi->second))
+            assert(!"cannot load block from disk");
+
+        if (mi->second->nHeight < chainActive.Height() - MAX_CMPCTBLOCK_DEPTH)
+        {
+            pfrom->PushMessage("block", block);
+            return true;
+        }
+
+        BlockTransactions resp(req);
+        for (size_t i = 0; i < req.indexes.size(); i++)
+        {
+            if (req.indexes[i] >= block.vtx.size())
+            {
+                Misbehaving(pfrom->GetId(), 100);
+                return error("Peer %d sent us a getblocktxn with out-of-bounds tx indices", pfrom->id);
+            }
+            resp.txn[i] = block.vtx[req.indexes[i]];
+        }
+        pfrom->PushMessage("blocktxn", resp);
+    }
+
+
+    else if (strCommand == "blocktxn" && !fImporting && !fReindex && MultichainNode_AcceptData(pfrom))
+    {
+        BlockTransactions resp;
+        vRecv >> resp;
+
+        CBlock block;
+        {
+            LOCK(cs_main);
+
+            CNodeState *nodestate = State(pfrom->GetId());
+            boost::shared_ptr<PartiallyDownloadedBlock> partialBlock = nodestate->partialBlock;
+            if (!partialBlock || partialBlock->header.GetHash() != resp.blockhash)
+            {
+                if(fDebug)LogPrint("net", "Peer %d sent us block transactions for block we weren't expecting\n", pfrom->id);
+                return true;
+            }
+            nodestate->partialBlock.reset();
+
+            ReadStatus status = partialBlock->FillBlock(block, resp.txn);
+            if (status == READ_STATUS_INVALID)
+            {
+                Misbehaving(pfrom->GetId(), 100);
+                return error("Peer %d sent us invalid compact block/non-matching block transactions", pfrom->id);
+            }
+            if (status == READ_STATUS_FAILED)
+            {
+                CompactBlockFallback(pfrom, resp.blockhash);
+                return true;
+            }
+            CompactBlockReconstructed(*partialBlock, resp.txn.size());
+        }
+
+        ProcessCompactBlock(pfrom, block);
+    }
+/* AMB END */
+
 
     else if (strCommand == "getaddr")
     {
@@ -6929,6 +7586,114 @@ bool ProcessMessages(CNode* pfrom)
 }
 
 
+/* AMB START */
+
+/**
+ * Returns true if message can be processed without cs_main.
+ * getaddr and addr are excluded - vAddrToSend and setAddrKnown are written by ThreadMessageHandler without lock
+ */
+bool static IsConcurrentMessage(const string& strCommand, const CDataStream& vRecv)
+{
+    if (strCommand == "ping" || strCommand == "pong")
+        return true;
+
+    if (strCommand == "getdata")
+    {
+        // Blocks (and Misbehaving() for oversized requests) need cs_main
+        vector<CInv> vInv;
+        CDataStream ss(vRecv);
+        try {
+            ss >> vInv;
+        } catch (std::exception& e) {
+            return false;
+        }
+        if (vInv.size() > MAX_INV_SZ)
+            return false;
+        BOOST_FOREACH(const CInv& inv, vInv)
+            if (inv.type == MSG_BLOCK || inv.type == MSG_FILTERED_BLOCK || inv.type == MSG_CMPCT_BLOCK)
+                return false;
+        return true;
+    }
+
+    return false;
+}
+
+// requires LOCK(cs_vRecvMsg) and LOCK(cs_vSend)
+// Processes leading messages in the queue which do not require cs_main, all other messages
+// (and messages failing validity checks) are left for ProcessMessages
+bool ProcessConcurrentMessages(CNode* pfrom)
+{
+    // this maintains the order of responses
+    if (!pfrom->vRecvGetData.empty())
+        return true;
+
+    if((mc_gState->m_NetworkParams->m_Status != MC_PRM_STATUS_VALID) || !pfrom->fParameterSetVerified)
+        return true;
+
+    std::deque<CNetMessage>::iterator it = pfrom->vRecvMsg.begin();
+    while (!pfrom->fDisconnect && it != pfrom->vRecvMsg.end() && pfrom->vRecvGetData.empty())
+    {
+        if (pfrom->nSendSize >= SendBufferSize())
+            break;
+
+        CNetMessage& msg = *it;
+        if (!msg.complete())
+            break;
+
+        if (memcmp(msg.hdr.pchMessageStart, Params().MessageStart(), MESSAGE_START_SIZE) != 0)
+            break;
+        if (!msg.hdr.IsValid(false))
+            break;
+
+        string strCommand = msg.hdr.GetCommand();
+        CDataStream& vRecv = msg.vRecv;
+        if (!IsConcurrentMessage(strCommand, vRecv))
+            break;
+
+        uint256 hash = Hash(vRecv.begin(), vRecv.begin() + msg.hdr.nMessageSize);
+        unsigned int nChecksum = 0;
+        memcpy(&nChecksum, &hash, sizeof(nChecksum));
+        if (nChecksum != msg.hdr.nChecksum)
+            break;
+
+        it++;
+
+        bool fRet = false;
+        try
+        {
+            if(pfrom->fDisconnect || !MultichainNode_DisconnectRemote(pfrom))
+            {
+                fRet = ProcessMessage(pfrom, strCommand, vRecv, msg.nTime);
+            }
+            boost::this_thread::interruption_point();
+        }
+        catch (std::ios_base::failure& e)
+        {
+            pfrom->PushMessage("reject", strCommand, REJECT_MALFORMED, string("error parsing message"));
+            LogPrintf("ProcessConcurrentMessages(%s, %u bytes) : Exception '%s' caught\n", SanitizeString(strCommand), msg.hdr.nMessageSize, e.what());
+        }
+        catch (boost::thread_interrupted) {
+            throw;
+        }
+        catch (std::exception& e) {
+            PrintExceptionContinue(&e, "ProcessConcurrentMessages()");
+        } catch (...) {
+            PrintExceptionContinue(NULL, "ProcessConcurrentMessages()");
+        }
+
+        if (!fRet)
+            LogPrintf("ProcessMessage(%s, %u bytes) FAILED peer=%d\n", SanitizeString(strCommand), msg.hdr.nMessageSize, pfrom->id);
+    }
+
+    // In case the connection got shut down, its receive buffer was wiped
+    if (!pfrom->fDisconnect)
+        pfrom->vRecvMsg.erase(pfrom->vRecvMsg.begin(), it);
+
+    return true;
+}
+
+/* AMB END */
+
 bool SendMessages(CNode* pto, bool fSendTrickle)
 {
     {
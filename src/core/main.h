@@ -37,6 +37,7 @@
 #include <utility>
 #include <vector>
 
+#include <boost/shared_ptr.hpp>
 #include <boost/unordered_map.hpp>
 
 class CBlockIndex;
@@ -69,6 +70,14 @@ static const unsigned int MAX_TX_SIGOPS = MAX_BLOCK_SIGOPS/5;
 /* MCHN START */
 //static const unsigned int DEFAULT_MAX_ORPHAN_TRANSACTIONS = 1000;
 static const unsigned int DEFAULT_MAX_ORPHAN_TRANSACTIONS = 50000;
+/* AMB START */
+/** Default for -maxmempool, maximum estimated memory usage of mempool in megabytes, 0 - unlimited */
+static const unsigned int DEFAULT_MAX_MEMPOOL_SIZE = 300;
+/** Default for -mempoolexpiry, hours after which transactions are evicted first when mempool is full */
+static const unsigned int DEFAULT_MEMPOOL_EXPIRY = 72;
+/** Default for -mempoolstreamquota, percent of -maxmempool items of one stream may use */
+static const unsigned int DEFAULT_MEMPOOL_STREAM_QUOTA = 25;
+/* AMB END */
 static const unsigned int DEFAULT_MAX_SUCCESSORS_FROM_ONE_NODE = 10;
 /* MCHN END */
 extern int MAX_OP_RETURN_SHOWN;
@@ -101,6 +110,10 @@ static const unsigned int MAX_HEADERS_RESULTS = 2000;
 static const unsigned int BLOCK_DOWNLOAD_WINDOW = 1024;
 /** Time to wait (in seconds) between writing blockchain state to disk. */
 static const unsigned int DATABASE_WRITE_INTERVAL = 3600;
+/* AMB START */
+/** Minimal -prunedepth, blocks at this depth are always kept on disk */
+static const int MIN_PRUNE_DEPTH = 288;
+/* AMB END */
 /** Maximum length of reject messages. */
 static const unsigned int MAX_REJECT_MESSAGE_LENGTH = 111;
 
@@ -134,6 +147,15 @@ extern bool fImporting;
 extern bool fReindex;
 extern int nScriptCheckThreads;
 extern bool fTxIndex;
+/* AMB START */
+extern bool fStreamIndex;
+/** Block and undo files below -prunedepth are deleted */
+extern bool fPruneMode;
+/** -prunedepth, 0 if pruning is disabled */
+extern int nPruneDepth;
+/** At least one block file was deleted */
+extern bool fHavePruned;
+/* AMB END */
 extern bool fIsBareMultisigStd;
 extern unsigned int nCoinCacheSize;
 extern CFeeRate minRelayTxFee;
@@ -182,6 +204,14 @@ void UnregisterNodeSignals(CNodeSignals& nodeSignals);
 bool ProcessNewBlock(CValidationState &state, CNode* pfrom, CBlock* pblock, CDiskBlockPos *dbp = NULL);
 /** Check whether enough disk space is available for an incoming block */
 bool CheckDiskSpace(uint64_t nAdditionalBytes = 0);
+/* AMB START */
+/** Marks block file as referenced by shortened wallet rows, it is never pruned */
+void PinBlockFile(int nFile);
+/** Depth below which block files can be pruned, includes miner and rollback windows */
+int GetPruneKeepDepth();
+/** Height of the highest block in active chain without data on disk, -1 if no blocks were pruned. Requires cs_main */
+int GetLastPrunedHeight();
+/* AMB END */
 /** Open a block file (blk?????.dat) */
 FILE* OpenBlockFile(const CDiskBlockPos &pos, bool fReadOnly = false);
 /** Open an undo file (rev?????.dat) */
@@ -198,6 +228,28 @@ bool LoadBlockIndex();
 void UnloadBlockIndex();
 /** Process protocol messages received from a given node */
 bool ProcessMessages(CNode* pfrom);
+/** Compact block relay counters */
+struct CCompactBlockStats
+{
+    uint64_t nSent;                     // "cmpctblock" messages sent
+    uint64_t nReceived;                 // "cmpctblock" messages received
+    uint64_t nReconstructed;            // blocks reconstructed without round trip
+    uint64_t nReconstructedRoundTrip;   // blocks reconstructed after "getblocktxn"
+    uint64_t nFallback;                 // full blocks requested because reconstruction failed
+    uint64_t nTxPrefilled;
+    uint64_t nTxFromMempool;
+    uint64_t nTxFromWallet;
+    uint64_t nTxRequested;
+    int64_t nReconstructionTime;        // total for reconstructed blocks, in microseconds
+
+    CCompactBlockStats() : nSent(0), nReceived(0), nReconstructed(0), nReconstructedRoundTrip(0), nFallback(0),
+                           nTxPrefilled(0), nTxFromMempool(0), nTxFromWallet(0), nTxRequested(0), nReconstructionTime(0) {}
+};
+void GetCompactBlockStats(CCompactBlockStats& stats);
+/* AMB START */
+/** Process protocol messages which do not require cs_main, called by message processing workers */
+bool ProcessConcurrentMessages(CNode* pfrom);
+/* AMB END */
 /** Send queued protocol messages to be sent to a give node */
 bool SendMessages(CNode* pto, bool fSendTrickle);
 /** Run an instance of the script checking thread */
@@ -352,12 +404,14 @@ private:
     unsigned int nFlags;
     bool cacheStore;
     ScriptError error;
+    boost::shared_ptr<const CSignatureHashCache> sighashcache;                  // Shared by all checks of the transaction, may be empty
 
 public:
     CScriptCheck(): ptxTo(0), nIn(0), nFlags(0), cacheStore(false), error(SCRIPT_ERR_UNKNOWN_ERROR) {}
-    CScriptCheck(const CCoins& txFromIn, const CTransaction& txToIn, unsigned int nInIn, unsigned int nFlagsIn, bool cacheIn) :
+    CScriptCheck(const CCoins& txFromIn, const CTransaction& txToIn, unsigned int nInIn, unsigned int nFlagsIn, bool cacheIn,
+                 const boost::shared_ptr<const CSignatureHashCache>& sighashcacheIn = boost::shared_ptr<const CSignatureHashCache>()) :
         scriptPubKey(txFromIn.vout[txToIn.vin[nInIn].prevout.n].scriptPubKey),
-        ptxTo(&txToIn), nIn(nInIn), nFlags(nFlagsIn), cacheStore(cacheIn), error(SCRIPT_ERR_UNKNOWN_ERROR) { }
+        ptxTo(&txToIn), nIn(nInIn), nFlags(nFlagsIn), cacheStore(cacheIn), error(SCRIPT_ERR_UNKNOWN_ERROR), sighashcache(sighashcacheIn) { }
 
     bool operator()();
 
@@ -368,6 +422,7 @@ public:
         std::swap(nFlags, check.nFlags);
         std::swap(cacheStore, check.cacheStore);
         std::swap(error, check.error);
+        sighashcache.swap(check.sighashcache);
     }
 
     ScriptError GetScriptError() const { return error; }
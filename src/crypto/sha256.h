@@ -7,6 +7,7 @@
 
 #include <stdint.h>
 #include <stdlib.h>
+#include <string>
 
 /** A hasher class for SHA-256. */
 class CSHA256
@@ -25,4 +26,23 @@ public:
     CSHA256& Reset();
 };
 
+/**
+ * Detect the best SHA-256 implementation supported by the CPU and select it.
+ * Must be called before any threads are started.
+ * Returns the description of the selected implementation.
+ */
+std::string SHA256AutoDetect();
+
+/**
+ * Select the SHA-256 implementation by name ("standard", "sse4.1", "avx2" or "shani").
+ * Returns false if it is not compiled in or not supported by the CPU.
+ */
+bool SHA256Select(const std::string& name);
+
+/**
+ * Compute double-SHA-256 of multiple 64-byte blobs.
+ * output: blocks*32 byte buffer, input: blocks*64 byte buffer.
+ */
+void SHA256D64(unsigned char* output, const unsigned char* input, size_t blocks);
+
 #endif // BITCOIN_CRYPTO_SHA256_H
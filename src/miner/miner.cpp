@@ -92,6 +92,82 @@ public:
     }
 };
 
+/* AMB START */
+//
+// Transactions selected for the next block are kept between CreateNewBlock calls.
+// Transactions accepted to the mempool since the previous call are appended to them,
+// the template is rebuilt from scratch only when the tip changes or transactions
+// leave the mempool (block, conflict, replay) and hashList positions are no longer valid.
+//
+class CBlockTemplateCache
+{
+public:
+    bool fValid;
+    uint256 hashPrevBlock;
+    CCoinsViewCache *pcoinsBase;
+    unsigned int nBlockMaxSize;
+    unsigned int nRemovedGeneration;
+    int nFeeExemptionVersion;                                                   // Fee exemptions of template transactions were decided against this version
+    int nHashListPos;                                                           // mempool hashList rows already processed
+    bool fPreservedMempoolOrder;
+    
+    CCoinsViewCache *pview;                                                     // pcoinsTip with template transactions applied
+    std::vector<CTransaction> vtx;
+    std::vector<CAmount> vTxFees;
+    std::vector<int64_t> vTxSigOps;
+    uint64_t nBlockSize;
+    uint64_t nBlockTx;
+    int nBlockSigOps;
+    CAmount nFees;
+
+    CBlockTemplateCache()
+    {
+        pview=NULL;
+        fValid=false;
+    }
+    
+    ~CBlockTemplateCache()
+    {
+        delete pview;
+    }
+    
+    bool IsValidFor(const CBlockIndex* pindexPrev,unsigned int nMaxSize,unsigned int nGeneration,int nExemptionVersion) const
+    {
+        return fValid && 
+               (pview != NULL) &&
+               (pcoinsBase == pcoinsTip) &&
+               (hashPrevBlock == pindexPrev->GetBlockHash()) &&
+               (nBlockMaxSize == nMaxSize) &&
+               (nRemovedGeneration == nGeneration) &&
+               (nFeeExemptionVersion == nExemptionVersion) &&
+               (nHashListPos <= mempool.hashList->m_Count);
+    }
+    
+    void Reset(const CBlockIndex* pindexPrev,unsigned int nMaxSize,unsigned int nGeneration,int nExemptionVersion)
+    {
+        delete pview;
+        pview=new CCoinsViewCache(pcoinsTip);
+        pcoinsBase=pcoinsTip;
+        hashPrevBlock=pindexPrev->GetBlockHash();
+        nBlockMaxSize=nMaxSize;
+        nRemovedGeneration=nGeneration;
+        nFeeExemptionVersion=nExemptionVersion;
+        nHashListPos=0;
+        fPreservedMempoolOrder=true;
+        vtx.clear();
+        vTxFees.clear();
+        vTxSigOps.clear();
+        nBlockSize=1000;
+        nBlockTx=0;
+        nBlockSigOps=100;
+        nFees=0;
+        fValid=false;
+    }
+};
+
+static CBlockTemplateCache blockTemplateCache;                                  // Protected by cs_main and mempool.cs
+/* AMB END */
+
 bool UpdateTime(CBlockHeader* pblock, const CBlockIndex* pindexPrev)
 {
 /* MCHN START */    
@@ -330,7 +406,25 @@ CBlockTemplate* CreateNewBlock(const CScript& scriptPubKeyIn,CWallet *pwallet,CP
         {
             *ppPrev=pindexPrev;
         }
-        CCoinsViewCache view(pcoinsTip);
+/* AMB START */        
+        int64_t nTimeStart = GetTimeMicros();
+        // Permissions, authority streams and wallet scripts may have changed since the last block,
+        // cached exemptions of older version are recomputed below
+        UpdateFeeExemptionVersion();
+        int nExemptionVersion=GetFeeExemptionVersion();
+        bool fIncremental=GetBoolArg("-incrementalblocktemplate",true) && 
+                          blockTemplateCache.IsValidFor(pindexPrev,nBlockMaxSize,mempool.GetRemovedGeneration(),nExemptionVersion);
+        if(!fIncremental)
+        {
+            mempool.defragmentHashList();    
+            blockTemplateCache.Reset(pindexPrev,nBlockMaxSize,mempool.GetRemovedGeneration(),nExemptionVersion);
+        }
+        // Marked valid again only if this call completes
+        blockTemplateCache.fValid=false;
+        fPreservedMempoolOrder=blockTemplateCache.fPreservedMempoolOrder;
+        int nStartPos=blockTemplateCache.nHashListPos;
+        CCoinsViewCache& view = *blockTemplateCache.pview;
+/* AMB END */        
 
         // Priority order to process transactions
         list<COrphan> vOrphan; // list memory doesn't move
@@ -353,13 +447,14 @@ CBlockTemplate* CreateNewBlock(const CScript& scriptPubKeyIn,CWallet *pwallet,CP
             
         double orderPriority=mempool.mapTx.size();
         
-        mempool.defragmentHashList();    
-        for(int pos=0;pos<mempool.hashList->m_Count;pos++)
+        for(int pos=nStartPos;pos<mempool.hashList->m_Count;pos++)
         {
             uint256 hash;
             hash=*(uint256*)mempool.hashList->GetRow(pos);
             
-            if(!mempool.exists(hash))
+            // mempool.cs is held, entry is looked up once instead of exists() followed by operator[]
+            CTxMemPoolMap::iterator mi = mempool.mapTx.find(hash);
+            if(mi == mempool.mapTx.end())
             {
                 LogPrint("mchn","mchn-miner: Tx not found in the mempool: %s\n",hash.GetHex().c_str());
                 fPreservedMempoolOrder=false;
@@ -372,7 +467,7 @@ CBlockTemplate* CreateNewBlock(const CScript& scriptPubKeyIn,CWallet *pwallet,CP
                 continue;                
             }
             
-            const CTransaction& tx = mempool.mapTx[hash].GetTx();
+            const CTransaction& tx = mi->second.GetTx();
 /* MCHN END */        
             
             if (tx.IsCoinBase() || !IsFinalTx(tx, nHeight))
@@ -475,9 +570,10 @@ CBlockTemplate* CreateNewBlock(const CScript& scriptPubKeyIn,CWallet *pwallet,CP
         }
 
         // Collect transactions into block
-        uint64_t nBlockSize = 1000;
-        uint64_t nBlockTx = 0;
-        int nBlockSigOps = 100;
+        uint64_t nBlockSize = blockTemplateCache.nBlockSize;
+        uint64_t nBlockTx = blockTemplateCache.nBlockTx;
+        int nBlockSigOps = blockTemplateCache.nBlockSigOps;
+        nFees = blockTemplateCache.nFees;
 //        bool fSortedByFee = (nBlockPrioritySize <= 0);
 
 /* MCHN START */            
@@ -485,6 +581,9 @@ CBlockTemplate* CreateNewBlock(const CScript& scriptPubKeyIn,CWallet *pwallet,CP
 //        TxPriorityCompare comparer(fSortedByFee);
         bool overblocksize_logged=false;
 /* MCHN END */            
+/* AMB START */
+        bool fFeeRequired = StreamUtils::GetMinimumRelayTxFee() > 0;
+/* AMB END */            
         std::make_heap(vecPriority.begin(), vecPriority.end(), comparer);
 
         while (!vecPriority.empty())
@@ -541,8 +640,25 @@ CBlockTemplate* CreateNewBlock(const CScript& scriptPubKeyIn,CWallet *pwallet,CP
                 continue;
             }
 
-            CAmount nTxFees = view.GetValueIn(tx)-tx.GetValueOut();
-            if (StreamUtils::GetMinimumRelayTxFee() > 0 && !IsMinerTx(tx) && nTxFees <= 0) {
+            // AMB: Fee was computed on admission to the mempool, exemption is recomputed if it is outdated
+            CAmount nTxFees;
+            bool fFeeExempt;
+            CTxMemPoolMap::iterator mit = mempool.mapTx.find(hash);
+            if (mit != mempool.mapTx.end())
+            {
+                nTxFees = mit->second.GetFee();
+                if (mit->second.FeeExemptVersion() != nExemptionVersion)
+                {
+                    mit->second.SetFeeExempt(IsMinerTx(tx),nExemptionVersion);
+                }
+                fFeeExempt = mit->second.IsFeeExempt();
+            }
+            else
+            {
+                nTxFees = view.GetValueIn(tx)-tx.GetValueOut();
+                fFeeExempt = IsMinerTx(tx);
+            }
+            if (fFeeRequired && !fFeeExempt && nTxFees <= 0) {
                 LogPrint("mchn","mchn-miner: Rejected tx %s: Should have nonzero tx fee.\n",tx.GetHash().GetHex().c_str());
                 continue;
             }
@@ -575,9 +691,9 @@ CBlockTemplate* CreateNewBlock(const CScript& scriptPubKeyIn,CWallet *pwallet,CP
             UpdateCoins(tx, state, view, txundo, nHeight);
 
             // Added
-            pblock->vtx.push_back(tx);
-            pblocktemplate->vTxFees.push_back(nTxFees);
-            pblocktemplate->vTxSigOps.push_back(nTxSigOps);
+            blockTemplateCache.vtx.push_back(tx);
+            blockTemplateCache.vTxFees.push_back(nTxFees);
+            blockTemplateCache.vTxSigOps.push_back(nTxSigOps);
             nBlockSize += nTxSize;
             ++nBlockTx;
             nBlockSigOps += nTxSigOps;
@@ -607,6 +723,23 @@ CBlockTemplate* CreateNewBlock(const CScript& scriptPubKeyIn,CWallet *pwallet,CP
             }
         }
 
+/* AMB START */        
+        blockTemplateCache.nHashListPos=mempool.hashList->m_Count;
+        blockTemplateCache.fPreservedMempoolOrder=fPreservedMempoolOrder;
+        blockTemplateCache.nBlockSize=nBlockSize;
+        blockTemplateCache.nBlockTx=nBlockTx;
+        blockTemplateCache.nBlockSigOps=nBlockSigOps;
+        blockTemplateCache.nFees=nFees;
+        blockTemplateCache.fValid=true;
+        
+        pblock->vtx.insert(pblock->vtx.end(),blockTemplateCache.vtx.begin(),blockTemplateCache.vtx.end());
+        pblocktemplate->vTxFees.insert(pblocktemplate->vTxFees.end(),blockTemplateCache.vTxFees.begin(),blockTemplateCache.vTxFees.end());
+        pblocktemplate->vTxSigOps.insert(pblocktemplate->vTxSigOps.end(),blockTemplateCache.vTxSigOps.begin(),blockTemplateCache.vTxSigOps.end());
+        
+        if(fDebug)LogPrint("mchn","mchn-miner: Block template %s: %d new mempool rows, %d txs, %.2fms\n",
+                fIncremental ? "extended" : "rebuilt",mempool.hashList->m_Count-nStartPos,(int)nBlockTx,0.001 * (GetTimeMicros() - nTimeStart));
+/* AMB END */        
+
         nLastBlockTx = nBlockTx;
         nLastBlockSize = nBlockSize;
 
@@ -621,20 +754,14 @@ CBlockTemplate* CreateNewBlock(const CScript& scriptPubKeyIn,CWallet *pwallet,CP
         CAmount nAdminFee = 0;
         try 
         {
-            adminFeeRatio = StreamUtils::GetAdminFeeRatio();
-            std::string adminAddrStr = StreamUtils::GetAdminPublicKey();
-            if (adminFeeRatio > 0 && adminAddrStr.compare("0") != 0)
+            CScript scriptPubKey;
+            if (StreamUtils::GetAdminFeeParams(nHeight, scriptPubKey, adminFeeRatio))
             {
                 // there is an adminFeeRatio defined, let's send part of the fee to the admin address!
-                std::vector<unsigned char> data(adminAddrStr.begin(), adminAddrStr.end());
-                CPubKey pubkey(data);
-                const unsigned char *pubkey_hash=(unsigned char *)Hash160(pubkey.begin(),pubkey.end()).begin();
-                CScript scriptPubKey = CScript() << OP_DUP << OP_HASH160 << std::vector<unsigned char>(pubkey_hash, pubkey_hash + 20) << OP_EQUALVERIFY << OP_CHECKSIG;
-
                 // create a new transaction output to send the partial fee to the admin
                 CTxOut txOutAdmin;
                 txOutAdmin.scriptPubKey = scriptPubKey;
-                nAdminFee = GetBlockValue(nHeight, nFees) * (adminFeeRatio);
+                nAdminFee = StreamUtils::GetAdminFee(GetBlockValue(nHeight, nFees), adminFeeRatio);
                 txOutAdmin.nValue = nAdminFee;
                 txNew.vout.push_back(txOutAdmin);
             }
@@ -712,7 +839,12 @@ CBlockTemplate* CreateNewBlock(const CScript& scriptPubKeyIn,CWallet *pwallet,CP
             
         CValidationState state;
         if (!TestBlockValidity(state, *pblock, pindexPrev, false, false))
+        {
+/* AMB START */            
+            blockTemplateCache.fValid=false;
+/* AMB END */            
             throw std::runtime_error("CreateNewBlock() : TestBlockValidity failed");
+        }
             
 /* MCHN START */    
         }
@@ -1272,7 +1404,7 @@ void static BitcoinMiner(CWallet *pwallet)
     
     if(Params().Interval() <= 0)
     {
-        min_bits=(int)mc_gState->m_NetworkParams->GetInt64Param("powminimumbits");
+        min_bits=(int)mc_gState->m_NetworkParams->GetInt64Param(MC_PRM_ID_POW_MINIMUM_BITS);
         if(min_bits < 16)
         {
             success_and_mask = success_and_mask << (16 - min_bits);
@@ -599,8 +599,9 @@ void CNode::copyStats(CNodeStats &stats)
 #undef X
 
 // requires LOCK(cs_vRecvMsg)
-bool CNode::ReceiveMsgBytes(const char *pch, unsigned int nBytes)
+bool CNode::ReceiveMsgBytes(const char *pch, unsigned int nBytes, bool& fComplete)
 {
+    fComplete = false;
     while (nBytes > 0) {
 
         // get current incomplete message, or create a new one
@@ -626,6 +627,7 @@ bool CNode::ReceiveMsgBytes(const char *pch, unsigned int nBytes)
         if (msg.complete())
         {
             msg.nTime = GetTimeMicros();
+            fComplete = true;
             if(fDebug)LogPrint("mcnet","mcnet: complete message: %s, peer=%d\n", msg.hdr.GetCommand(),id);
         }
     }
@@ -633,6 +635,38 @@ bool CNode::ReceiveMsgBytes(const char *pch, unsigned int nBytes)
     return true;
 }
 
+/* AMB START */
+// requires LOCK(cs_vRecvMsg)
+char *CNode::GetDirectRecvBuffer(unsigned int nMinSpace, unsigned int& nSpace)
+{
+    if (vRecvMsg.empty())
+        return NULL;
+
+    CNetMessage& msg = vRecvMsg.back();
+    if (!msg.in_data || msg.complete())
+        return NULL;
+
+    if (msg.hdr.nMessageSize - msg.nDataPos < nMinSpace)
+        return NULL;
+
+    return msg.prepareData(nSpace);
+}
+
+// requires LOCK(cs_vRecvMsg)
+void CNode::DirectRecvBytes(unsigned int nBytes, bool& fComplete)
+{
+    CNetMessage& msg = vRecvMsg.back();
+    msg.dataReceived(nBytes);
+
+    fComplete = msg.complete();
+    if (fComplete)
+    {
+        msg.nTime = GetTimeMicros();
+        if(fDebug)LogPrint("mcnet","mcnet: complete message: %s, peer=%d\n", msg.hdr.GetCommand(),id);
+    }
+}
+/* AMB END */
+
 int CNetMessage::readHeader(const char *pch, unsigned int nBytes)
 {
     // copy data to temporary parsing buffer
@@ -687,6 +721,19 @@ int CNetMessage::readData(const char *pch, unsigned int nBytes)
     return nCopy;
 }
 
+/* AMB START */
+char *CNetMessage::prepareData(unsigned int& nSpace)
+{
+    // Same allocation limit as in readData - up to 256 KiB ahead of received data
+    unsigned int nSize = std::min(hdr.nMessageSize, nDataPos + 256 * 1024);
+    if (vRecv.size() < nSize)
+        vRecv.resize(nSize);
+
+    nSpace = nSize - nDataPos;
+    return &vRecv[nDataPos];
+}
+/* AMB END */
+
 
 
 
@@ -744,6 +791,141 @@ void SocketSendData(CNode *pnode)
 
 static list<CNode*> vNodesDisconnected;
 
+/* AMB START */
+// Message handler wakeup and the queue of peers for message processing workers
+static boost::mutex mutexMsgProc;
+static boost::condition_variable condMsgHand;
+static boost::condition_variable condMsgProc;
+static bool fMsgHandWake = false;
+static deque<CNode*> vMsgProcQueue;
+static int nMsgProcThreads = 0;
+
+void WakeMessageHandler()
+{
+    {
+        boost::lock_guard<boost::mutex> lock(mutexMsgProc);
+        fMsgHandWake = true;
+    }
+    condMsgHand.notify_one();
+}
+
+// Called by socket handler thread when a complete message is received from the peer
+static void QueueMessageProcessing(CNode *pnode)
+{
+    {
+        boost::lock_guard<boost::mutex> lock(mutexMsgProc);
+        fMsgHandWake = true;
+        if (nMsgProcThreads > 0 && !pnode->fMsgProcQueued)
+        {
+            pnode->fMsgProcQueued = true;
+            {
+                LOCK(cs_vNodes);
+                pnode->AddRef();
+            }
+            vMsgProcQueue.push_back(pnode);
+            condMsgProc.notify_one();
+        }
+    }
+    condMsgHand.notify_one();
+}
+
+#ifdef USE_EPOLL
+static int hEpoll = -1;
+static const int MAX_EPOLL_EVENTS = 256;
+
+// Listen sockets are level-triggered, peer sockets are edge-triggered and
+// serviced until recv()/send() would block (see fSocketRecvReady/fSocketSendReady).
+static bool EpollRegister(SOCKET hSocket, uint32_t nEvents, void *ptr)
+{
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = nEvents;
+    event.data.ptr = ptr;
+    if (epoll_ctl(hEpoll, EPOLL_CTL_ADD, hSocket, &event) != 0)
+    {
+        LogPrintf("epoll_ctl error %s\n", NetworkErrorString(WSAGetLastError()));
+        return false;
+    }
+    return true;
+}
+#endif
+
+// requires LOCK(cs_vRecvMsg)
+// Returns true if some data was received and socket may have more
+static bool SocketRecvData(CNode *pnode)
+{
+    // typical socket buffer is 8K-64K
+    char pchBuf[0x10000];
+    
+    // Body of large message is received directly into its buffer, without copying from pchBuf.
+    // Smaller remainders go through pchBuf, so one recv can also return the following messages.
+    unsigned int nSpace;
+    char *pchDirect = pnode->GetDirectRecvBuffer(sizeof(pchBuf), nSpace);
+    
+    int nBytes;
+    if (pchDirect)
+        nBytes = recv(pnode->hSocket, pchDirect, nSpace, MSG_DONTWAIT);
+    else
+        nBytes = recv(pnode->hSocket, pchBuf, sizeof(pchBuf), MSG_DONTWAIT);
+    if (nBytes > 0)
+    {
+        bool fComplete;
+        if (pchDirect)
+        {
+            pnode->DirectRecvBytes(nBytes, fComplete);
+            if (fComplete)
+            {
+                QueueMessageProcessing(pnode);
+            }
+        }
+        else if (!pnode->ReceiveMsgBytes(pchBuf, nBytes, fComplete))
+        {
+            if(fDebug)LogPrint("net","receive error\n");
+            pnode->CloseSocketDisconnect();
+        }
+        else if (fComplete)
+        {
+            QueueMessageProcessing(pnode);
+        }
+        pnode->nLastRecv = GetTime();
+        pnode->nRecvBytes += nBytes;
+        pnode->RecordBytesRecv(nBytes);
+        return pnode->hSocket != INVALID_SOCKET;
+    }
+    else if (nBytes == 0)
+    {
+        // socket closed gracefully
+        if (!pnode->fDisconnect)
+        {
+            if(fDebug)LogPrint("net", "socket closed\n");
+        }
+        else
+        {
+            if(fDebug)LogPrint("net","socket closed, disconnect flag is set\n");
+        }
+        pnode->CloseSocketDisconnect();
+    }
+    else if (nBytes < 0)
+    {
+        // error
+        int nErr = WSAGetLastError();
+        if (nErr != WSAEWOULDBLOCK && nErr != WSAEMSGSIZE && nErr != WSAEINTR && nErr != WSAEINPROGRESS)
+        {
+            if (!pnode->fDisconnect)
+                LogPrintf("socket recv error %s\n", NetworkErrorString(nErr));
+            else
+                LogPrintf("socket recv error %s, disconnect flag is set\n", NetworkErrorString(nErr));
+            pnode->CloseSocketDisconnect();
+        }
+        else if (nErr == WSAEINTR)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+/* AMB END */
+
 void ThreadSocketHandler()
 {
     unsigned int nPrevNodeCount = 0;
@@ -815,6 +997,78 @@ void ThreadSocketHandler()
             uiInterface.NotifyNumConnectionsChanged(nPrevNodeCount);
         }
 
+/* AMB START */
+#ifdef USE_EPOLL
+        //
+        // Register new sockets and wait for readiness events
+        //
+        if (hEpoll < 0)
+        {
+            hEpoll = epoll_create1(EPOLL_CLOEXEC);
+            if (hEpoll < 0)
+                throw runtime_error(strprintf("epoll_create1 failed: %s", NetworkErrorString(WSAGetLastError())));
+            BOOST_FOREACH(ListenSocket& hListenSocket, vhListenSocket)
+                if (hListenSocket.socket != INVALID_SOCKET)
+                    EpollRegister(hListenSocket.socket, EPOLLIN, &hListenSocket);
+        }
+
+        {
+            LOCK(cs_vNodes);
+            BOOST_FOREACH(CNode* pnode, vNodes)
+            {
+                if (pnode->fSocketRegistered || pnode->hSocket == INVALID_SOCKET)
+                    continue;
+                pnode->fSocketRegistered = true;
+                if (!EpollRegister(pnode->hSocket, EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET, pnode))
+                {
+                    pnode->CloseSocketDisconnect();
+                    continue;
+                }
+                // Data may have arrived before registration, edge will not be reported for it
+                pnode->fSocketRecvReady = true;
+                pnode->fSocketSendReady = true;
+            }
+        }
+
+        struct epoll_event events[MAX_EPOLL_EVENTS];
+        int nEvents = epoll_wait(hEpoll, events, MAX_EPOLL_EVENTS, 50); // frequency to poll pnode->vSend
+        boost::this_thread::interruption_point();
+
+        if (nEvents < 0)
+        {
+            int nErr = WSAGetLastError();
+            if (nErr != WSAEINTR)
+            {
+                LogPrintf("socket epoll_wait error %s\n", NetworkErrorString(nErr));
+                MilliSleep(50);
+            }
+            nEvents = 0;
+        }
+
+        set<SOCKET> setListenReady;
+        for (int i = 0; i < nEvents; i++)
+        {
+            bool fListen = false;
+            BOOST_FOREACH(ListenSocket& hListenSocket, vhListenSocket)
+            {
+                if (events[i].data.ptr == &hListenSocket)
+                {
+                    setListenReady.insert(hListenSocket.socket);
+                    fListen = true;
+                }
+            }
+            if (fListen)
+                continue;
+
+            // Nodes are deleted only by this thread, after their socket is closed
+            CNode* pnode = (CNode*)events[i].data.ptr;
+            if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+                pnode->fSocketRecvReady = true;
+            if (events[i].events & (EPOLLOUT | EPOLLHUP | EPOLLERR))
+                pnode->fSocketSendReady = true;
+        }
+#else
+/* AMB END */
         //
         // Find which sockets have data to receive
         //
@@ -897,12 +1151,24 @@ void ThreadSocketHandler()
             MilliSleep(timeout.tv_usec/1000);
         }
 
+/* AMB START */
+#endif
+/* AMB END */
+
         //
         // Accept new connections
         //
         BOOST_FOREACH(const ListenSocket& hListenSocket, vhListenSocket)
         {
+/* AMB START */
+#ifdef USE_EPOLL
+            if (hListenSocket.socket != INVALID_SOCKET && setListenReady.count(hListenSocket.socket))
+#else
+/* AMB END */
             if (hListenSocket.socket != INVALID_SOCKET && FD_ISSET(hListenSocket.socket, &fdsetRecv))
+/* AMB START */
+#endif
+/* AMB END */
             {
                 struct sockaddr_storage sockaddr;
                 socklen_t len = sizeof(sockaddr);
@@ -972,71 +1238,60 @@ void ThreadSocketHandler()
             //
             if (pnode->hSocket == INVALID_SOCKET)
                 continue;
-            if (FD_ISSET(pnode->hSocket, &fdsetRecv) || FD_ISSET(pnode->hSocket, &fdsetError))
+/* AMB START */
+#ifdef USE_EPOLL
+            // Drain the socket until it would block, the receive buffer is full
+            // (it is resumed on the next pass once messages are processed) or lock is busy.
+            if (pnode->fSocketRecvReady)
             {
                 TRY_LOCK(pnode->cs_vRecvMsg, lockRecv);
                 if (lockRecv)
                 {
-                    {
-                        // typical socket buffer is 8K-64K
-                        char pchBuf[0x10000];
-                        int nBytes = recv(pnode->hSocket, pchBuf, sizeof(pchBuf), MSG_DONTWAIT);
-                        if (nBytes > 0)
-                        {
-                            if (!pnode->ReceiveMsgBytes(pchBuf, nBytes))
-                            {
-/* MCHN START */                    
-                                if(fDebug)LogPrint("net","receive error\n");
-/* MCHN END */                    
-                                pnode->CloseSocketDisconnect();
-                            }
-                            pnode->nLastRecv = GetTime();
-                            pnode->nRecvBytes += nBytes;
-                            pnode->RecordBytesRecv(nBytes);
-                        }
-                        else if (nBytes == 0)
-                        {
-                            // socket closed gracefully
-                            if (!pnode->fDisconnect)
-                            {
-                                if(fDebug)LogPrint("net", "socket closed\n");
-                            }
-                            else
-                            {
-                                if(fDebug)LogPrint("net","socket closed, disconnect flag is set\n");
-                            }
-                            pnode->CloseSocketDisconnect();
-                        }
-                        else if (nBytes < 0)
-                        {
-                            // error
-                            int nErr = WSAGetLastError();
-                            if (nErr != WSAEWOULDBLOCK && nErr != WSAEMSGSIZE && nErr != WSAEINTR && nErr != WSAEINPROGRESS)
-                            {
-                                if (!pnode->fDisconnect)
-                                    LogPrintf("socket recv error %s\n", NetworkErrorString(nErr));
-/* MCHN START */                    
-                                else
-                                    LogPrintf("socket recv error %s, disconnect flag is set\n", NetworkErrorString(nErr));
-/* MCHN END */                    
-                                pnode->CloseSocketDisconnect();
-                            }
-                        }
-                    }
+                    while (pnode->fSocketRecvReady && pnode->GetTotalRecvSize() <= ReceiveFloodSize())
+                        pnode->fSocketRecvReady = SocketRecvData(pnode);
                 }
             }
+#else
+/* AMB END */
+            if (FD_ISSET(pnode->hSocket, &fdsetRecv) || FD_ISSET(pnode->hSocket, &fdsetError))
+            {
+                TRY_LOCK(pnode->cs_vRecvMsg, lockRecv);
+                if (lockRecv)
+                    SocketRecvData(pnode);
+            }
+/* AMB START */
+#endif
+/* AMB END */
 
             //
             // Send
             //
             if (pnode->hSocket == INVALID_SOCKET)
                 continue;
+/* AMB START */
+#ifdef USE_EPOLL
+            if (pnode->fSocketSendReady)
+            {
+                TRY_LOCK(pnode->cs_vSend, lockSend);
+                if (lockSend && !pnode->vSendMsg.empty())
+                {
+                    SocketSendData(pnode);
+                    // Partial write means the socket buffer is full, wait for EPOLLOUT edge
+                    if (!pnode->vSendMsg.empty())
+                        pnode->fSocketSendReady = false;
+                }
+            }
+#else
+/* AMB END */
             if (FD_ISSET(pnode->hSocket, &fdsetSend))
             {
                 TRY_LOCK(pnode->cs_vSend, lockSend);
                 if (lockSend)
                     SocketSendData(pnode);
             }
+/* AMB START */
+#endif
+/* AMB END */
 
             //
             // Inactivity checking
@@ -1685,10 +1940,69 @@ void ThreadMessageHandler()
                 pnode->Release();
         }
 
-        if (fSleep)
-            MilliSleep(100);
+/* AMB START */
+        // Woken by socket handler as soon as complete message is received
+        {
+            boost::unique_lock<boost::mutex> lock(mutexMsgProc);
+            if (fSleep && !fMsgHandWake)
+                condMsgHand.timed_wait(lock, boost::posix_time::milliseconds(100));
+            fMsgHandWake = false;
+        }
+        boost::this_thread::interruption_point();
+/* AMB END */
+    }
+}
+
+/* AMB START */
+/**
+ * Message processing worker. Handles peers queued by socket handler concurrently with
+ * ThreadMessageHandler, but only messages which do not require cs_main (see ProcessConcurrentMessages).
+ * Holding both cs_vRecvMsg and cs_vSend keeps per-peer state accessed by one thread at a time.
+ */
+void ThreadMessageProcessor()
+{
+    while (true)
+    {
+        CNode* pnode = NULL;
+        {
+            boost::unique_lock<boost::mutex> lock(mutexMsgProc);
+            while (vMsgProcQueue.empty())
+                condMsgProc.wait(lock);
+            pnode = vMsgProcQueue.front();
+            vMsgProcQueue.pop_front();
+            pnode->fMsgProcQueued = false;
+        }
+
+        bool fRemaining = false;
+        if (!pnode->fDisconnect)
+        {
+            TRY_LOCK(pnode->cs_vRecvMsg, lockRecv);
+            if (lockRecv)
+            {
+                TRY_LOCK(pnode->cs_vSend, lockSend);
+                if (lockSend)
+                {
+                    if (!g_signals.ProcessConcurrentMessages(pnode))
+                    {
+                        if(fDebug)LogPrint("net","socket closed because of error in message processing\n");
+                        pnode->CloseSocketDisconnect();
+                    }
+                }
+                fRemaining = !pnode->vRecvMsg.empty() && pnode->vRecvMsg.front().complete();
+            }
+        }
+
+        if (fRemaining)
+            WakeMessageHandler();
+
+        {
+            LOCK(cs_vNodes);
+            pnode->Release();
+        }
+        boost::this_thread::interruption_point();
     }
 }
+/* AMB END */
 
 
 
@@ -1890,6 +2204,13 @@ void StartNode(boost::thread_group& threadGroup)
     // Process messages
     threadGroup.create_thread(boost::bind(&TraceThread<void (*)()>, "msghand", &ThreadMessageHandler));
 
+/* AMB START */
+    // Process messages not requiring cs_main
+    nMsgProcThreads = max((int)GetArg("-msgprocthreads", DEFAULT_MSGPROC_THREADS), 0);
+    for (int i = 0; i < nMsgProcThreads; i++)
+        threadGroup.create_thread(boost::bind(&TraceThread<void (*)()>, "msgproc", &ThreadMessageProcessor));
+/* AMB END */
+
     // Dump network addresses
     threadGroup.create_thread(boost::bind(&LoopForever<void (*)()>, "dumpaddr", &DumpAddresses, DUMP_ADDRESSES_INTERVAL * 1000));
 }
@@ -1942,6 +2263,13 @@ public:
         semOutbound = NULL;
         delete pnodeLocalHost;
         pnodeLocalHost = NULL;
+/* AMB START */
+#ifdef USE_EPOLL
+        if (hEpoll >= 0)
+            close(hEpoll);
+        hEpoll = -1;
+#endif
+/* AMB END */
 
 #ifdef WIN32
         // Shutdown Windows Sockets
@@ -2180,6 +2508,12 @@ CNode::CNode(SOCKET hSocketIn, CAddress addrIn, std::string addrNameIn, bool fIn
     fNetworkNode = false;
     fSuccessfullyConnected = false;
     fDisconnect = false;
+/* AMB START */
+    fSocketRegistered = false;
+    fSocketRecvReady = false;
+    fSocketSendReady = false;
+    fMsgProcQueued = false;
+/* AMB END */
     nRefCount = 0;
     nSendSize = 0;
     nSendOffset = 0;
@@ -2199,6 +2533,7 @@ CNode::CNode(SOCKET hSocketIn, CAddress addrIn, std::string addrNameIn, bool fIn
     fVerackackReceived=false;
     fVerackackSent=false;
     fParameterSetVerified=false;    
+    fSupportsCompactBlocks=false;
     fSyncedOnce=false;
     fCanConnectLocal=false;
     fCanConnectRemote=false;
@@ -61,6 +61,10 @@ static const bool DEFAULT_UPNP = false;
 #endif
 /** The maximum number of entries in mapAskFor */
 static const size_t MAPASKFOR_MAX_SZ = MAX_INV_SZ;
+/* AMB START */
+/** -msgprocthreads default, workers processing messages which do not require cs_main */
+static const int DEFAULT_MSGPROC_THREADS = 2;
+/* AMB END */
 
 unsigned int ReceiveFloodSize();
 unsigned int SendBufferSize();
@@ -79,6 +83,9 @@ bool BindListenPort(const CService &bindAddr, std::string& strError, bool fWhite
 void StartNode(boost::thread_group& threadGroup);
 bool StopNode();
 void SocketSendData(CNode *pnode);
+/* AMB START */
+void WakeMessageHandler();
+/* AMB END */
 int mc_QuerySeed(boost::thread_group& threadGroup,const char *seedAddr);
 
 
@@ -89,6 +96,9 @@ struct CNodeSignals
 {
     boost::signals2::signal<int ()> GetHeight;
     boost::signals2::signal<bool (CNode*)> ProcessMessages;
+/* AMB START */
+    boost::signals2::signal<bool (CNode*)> ProcessConcurrentMessages;
+/* AMB END */
     boost::signals2::signal<bool (CNode*, bool)> SendMessages;
     boost::signals2::signal<void (NodeId, const CNode*)> InitializeNode;
     boost::signals2::signal<void (NodeId)> FinalizeNode;
@@ -218,6 +228,13 @@ public:
 
     int readHeader(const char *pch, unsigned int nBytes);
     int readData(const char *pch, unsigned int nBytes);
+/* AMB START */
+    char *prepareData(unsigned int& nSpace);       // buffer for data received directly from socket, followed by dataReceived
+    void dataReceived(unsigned int nBytes)
+    {
+        nDataPos += nBytes;
+    }
+/* AMB END */
 };
 
 
@@ -263,6 +280,14 @@ public:
     bool fNetworkNode;
     bool fSuccessfullyConnected;
     bool fDisconnect;
+/* AMB START */
+    // Socket readiness as reported by edge-triggered epoll, used by socket handler thread only
+    bool fSocketRegistered;
+    bool fSocketRecvReady;
+    bool fSocketSendReady;
+    // Queued for message processing workers, protected by message queue mutex
+    bool fMsgProcQueued;
+/* AMB END */
     // We use fRelayTxes for two purposes -
     // a) it allows us to not relay tx invs before receiving the peer's version message
     // b) the peer may tell us in their version message that we should not relay tx invs
@@ -284,6 +309,7 @@ public:
     bool fVerackackReceived;
     bool fVerackackSent;
     bool fParameterSetVerified;
+    bool fSupportsCompactBlocks;                                                // peer sent "sendcmpct"
     bool fSyncedOnce;
     bool fLastIgnoreIncoming;
     bool fCanConnectRemote;
@@ -371,7 +397,14 @@ public:
     }
 
     // requires LOCK(cs_vRecvMsg)
-    bool ReceiveMsgBytes(const char *pch, unsigned int nBytes);
+    bool ReceiveMsgBytes(const char *pch, unsigned int nBytes, bool& fComplete);
+/* AMB START */
+    // requires LOCK(cs_vRecvMsg)
+    // Returns buffer of partially received message if at least nMinSpace bytes of its data are missing, NULL otherwise
+    char *GetDirectRecvBuffer(unsigned int nMinSpace, unsigned int& nSpace);
+    // requires LOCK(cs_vRecvMsg)
+    void DirectRecvBytes(unsigned int nBytes, bool& fComplete);
+/* AMB END */
 
     // requires LOCK(cs_vRecvMsg)
     void SetRecvVersion(int nVersionIn)
@@ -593,6 +593,16 @@ void mc_Permissions::LogString(const char *message)
 {
     FILE *fHan;
     
+/* AMB START */
+    if(mc_gLogStringFunc)
+    {
+        if(mc_gLogStringFunc(m_LogFileName,message) == 0)
+        {
+            return;
+        }
+    }
+/* AMB END */
+    
     fHan=fopen(m_LogFileName,"a");
     if(fHan == NULL)
     {
@@ -1257,7 +1267,7 @@ int mc_Permissions::CanIssue(const void* lpEntity,const void* lpAddress)
 //    if(lpEntity == NULL)
     if(mc_IsNullEntity(lpEntity))
     {
-        if(mc_gState->m_NetworkParams->GetInt64Param("anyonecanissue"))
+        if(mc_gState->m_NetworkParams->GetInt64Param(MC_PRM_ID_ANYONE_CAN_ISSUE))
         {
             return MC_PTP_ISSUE;
         }
@@ -1277,7 +1287,7 @@ int mc_Permissions::CanIssue(const void* lpEntity,const void* lpAddress)
 
 int mc_Permissions::IsSetupPeriod()
 {
-    if(m_Block+1<mc_gState->m_NetworkParams->GetInt64Param("setupfirstblocks"))
+    if(m_Block+1<mc_gState->m_NetworkParams->GetInt64Param(MC_PRM_ID_SETUP_FIRST_BLOCKS))
     {
         return 1;
     }
@@ -1294,7 +1304,7 @@ int mc_Permissions::GetActiveMinerCount()
     int diversity;
     if(!IsSetupPeriod())
     {
-        diversity=(int)mc_gState->m_NetworkParams->GetInt64Param("miningdiversity");
+        diversity=(int)mc_gState->m_NetworkParams->GetInt64Param(MC_PRM_ID_MINING_DIVERSITY);
         if(diversity > 0)
         {
             diversity=(int)((miner_count*diversity-1)/MC_PRM_DECIMAL_GRANULARITY);
@@ -1591,9 +1601,9 @@ int mc_Permissions::IsBarredByDiversity(uint32_t block,uint32_t last,int miner_c
     int diversity;
     if(miner_count)
     {
-        if(block >= mc_gState->m_NetworkParams->GetInt64Param("setupfirstblocks"))
+        if(block >= mc_gState->m_NetworkParams->GetInt64Param(MC_PRM_ID_SETUP_FIRST_BLOCKS))
         {                        
-            diversity=(int)mc_gState->m_NetworkParams->GetInt64Param("miningdiversity");
+            diversity=(int)mc_gState->m_NetworkParams->GetInt64Param(MC_PRM_ID_MINING_DIVERSITY);
             if(diversity > 0)
             {
                 diversity=(int)((miner_count*diversity-1)/MC_PRM_DECIMAL_GRANULARITY);
@@ -2188,23 +2198,23 @@ int mc_Permissions::AdminConsensus(const void* lpEntity,uint32_t type)
                 consensus=0;
                 if(type == MC_PTP_ADMIN)
                 {
-                    consensus=mc_gState->m_NetworkParams->GetInt64Param("adminconsensusadmin");
+                    consensus=mc_gState->m_NetworkParams->GetInt64Param(MC_PRM_ID_ADMIN_CONSENSUS_ADMIN);
                 }
                 if(type == MC_PTP_MINE)
                 {
-                    consensus=mc_gState->m_NetworkParams->GetInt64Param("adminconsensusmine");
+                    consensus=mc_gState->m_NetworkParams->GetInt64Param(MC_PRM_ID_ADMIN_CONSENSUS_MINE);
                 }
                 if(type == MC_PTP_ACTIVATE)
                 {
-                    consensus=mc_gState->m_NetworkParams->GetInt64Param("adminconsensusactivate");
+                    consensus=mc_gState->m_NetworkParams->GetInt64Param(MC_PRM_ID_ADMIN_CONSENSUS_ACTIVATE);
                 }
                 if(type == MC_PTP_ISSUE)
                 {
-                    consensus=mc_gState->m_NetworkParams->GetInt64Param("adminconsensusissue");
+                    consensus=mc_gState->m_NetworkParams->GetInt64Param(MC_PRM_ID_ADMIN_CONSENSUS_ISSUE);
                 }
                 if(type == MC_PTP_CREATE)
                 {
-                    consensus=mc_gState->m_NetworkParams->GetInt64Param("adminconsensuscreate");
+                    consensus=mc_gState->m_NetworkParams->GetInt64Param(MC_PRM_ID_ADMIN_CONSENSUS_CREATE);
                 }
 
                 if(consensus==0)
@@ -2226,7 +2236,7 @@ int mc_Permissions::AdminConsensus(const void* lpEntity,uint32_t type)
                     return 1;
                 }
 
-                consensus=mc_gState->m_NetworkParams->GetInt64Param("adminconsensusupgrade");
+                consensus=mc_gState->m_NetworkParams->GetInt64Param(MC_PRM_ID_ADMIN_CONSENSUS_UPGRADE);
                 if(consensus==0)
                 {
                     return 1;
@@ -3824,7 +3834,7 @@ int mc_Permissions::StoreBlockInfoInternal(const void* lpMiner,const void* lpHas
         return MC_ERR_NOERROR;
     }
     
-    if(mc_gState->m_NetworkParams->GetInt64Param("supportminerprecheck") == 0)                                
+    if(mc_gState->m_NetworkParams->GetInt64Param(MC_PRM_ID_SUPPORT_MINER_PRECHECK) == 0)                                
     {
         return MC_ERR_NOERROR;        
     }    
@@ -6,6 +6,7 @@
 
 #include "primitives/block.h"
 
+#include "crypto/sha256.h"
 #include "structs/hash.h"
 #include "utils/tinyformat.h"
 #include "utils/utilstrencodings.h"
@@ -79,8 +80,14 @@ uint256 CBlock::BuildMerkleTree(bool* fMutated) const
     }
     int j = 0;
     bool mutated = false;
+    std::vector<unsigned char> vPairs;
+    std::vector<unsigned char> vHashes;
     for (int nSize = vtx.size(); nSize > 1; nSize = (nSize + 1) / 2)
     {
+        // Collect the 64-byte concatenated pairs of the level and hash them together
+        int nPairs = (nSize + 1) / 2;
+        vPairs.resize(nPairs * 64);
+        vHashes.resize(nPairs * 32);
         for (int i = 0; i < nSize; i += 2)
         {
             int i2 = std::min(i+1, nSize-1);
@@ -88,8 +95,15 @@ uint256 CBlock::BuildMerkleTree(bool* fMutated) const
                 // Two identical hashes at the end of the list at a particular level.
                 mutated = true;
             }
-            vMerkleTree.push_back(Hash(BEGIN(vMerkleTree[j+i]),  END(vMerkleTree[j+i]),
-                                       BEGIN(vMerkleTree[j+i2]), END(vMerkleTree[j+i2])));
+            memcpy(&vPairs[i * 32], BEGIN(vMerkleTree[j+i]), 32);
+            memcpy(&vPairs[i * 32 + 32], BEGIN(vMerkleTree[j+i2]), 32);
+        }
+        SHA256D64(&vHashes[0], &vPairs[0], nPairs);
+        for (int i = 0; i < nPairs; i++)
+        {
+            uint256 hash;
+            memcpy(BEGIN(hash), &vHashes[i * 32], 32);
+            vMerkleTree.push_back(hash);
         }
         j += nSize;
     }
@@ -0,0 +1,215 @@
+// Copyright (c) 2018 Apsaras Group Ltd
+// Amberchain code distributed under the GPLv3 license, see COPYING file.
+
+#include "protocol/blockencodings.h"
+
+#include "chain/txmempool.h"
+#include "crypto/common.h"
+#include "crypto/sha256.h"
+#include "structs/hash.h"
+#include "utils/random.h"
+#include "utils/streams.h"
+#include "utils/util.h"
+
+#include <boost/foreach.hpp>
+#include <boost/unordered_map.hpp>
+
+using namespace std;
+
+CBlockHeaderAndShortTxIDs::CBlockHeaderAndShortTxIDs(const CBlock& block) :
+        nonce(GetRand(std::numeric_limits<uint64_t>::max())),
+        shorttxids(block.vtx.empty() ? 0 : block.vtx.size() - 1), prefilledtxn(1), header(block.GetBlockHeader())
+{
+    FillShortTxIDSelector();
+    // The coinbase carries the block signature and is never in the mempool
+    prefilledtxn[0].index = 0;
+    if (!block.vtx.empty())
+        prefilledtxn[0].tx = block.vtx[0];
+    for (size_t i = 1; i < block.vtx.size(); i++)
+        shorttxids[i - 1] = GetShortID(block.vtx[i].GetHash());
+}
+
+void CBlockHeaderAndShortTxIDs::FillShortTxIDSelector() const
+{
+    CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
+    stream << header << nonce;
+    CSHA256 hasher;
+    hasher.Write((unsigned char*)&(*stream.begin()), stream.end() - stream.begin());
+    uint256 shorttxidhash;
+    hasher.Finalize(shorttxidhash.begin());
+    shorttxidk0 = ReadLE64(shorttxidhash.begin());
+    shorttxidk1 = ReadLE64(shorttxidhash.begin() + 8);
+}
+
+uint64_t CBlockHeaderAndShortTxIDs::GetShortID(const uint256& txhash) const
+{
+    return SipHashUint256(shorttxidk0, shorttxidk1, txhash) & 0xffffffffffffULL;
+}
+
+ReadStatus PartiallyDownloadedBlock::InitData(const CBlockHeaderAndShortTxIDs& cmpctblock, const std::vector<CTransaction>& extra_txn)
+{
+    if (cmpctblock.header.IsNull() || (cmpctblock.shorttxids.empty() && cmpctblock.prefilledtxn.empty()))
+        return READ_STATUS_INVALID;
+    if (cmpctblock.shorttxids.size() + cmpctblock.prefilledtxn.size() > MAX_BLOCK_SIZE / 60)
+        return READ_STATUS_INVALID;
+
+    assert(header.IsNull() && txn_available.empty());
+    header = cmpctblock.header;
+    txn_available.resize(cmpctblock.BlockTxCount());
+    have_available.resize(cmpctblock.BlockTxCount(), false);
+
+    int32_t lastprefilledindex = -1;
+    for (size_t i = 0; i < cmpctblock.prefilledtxn.size(); i++)
+    {
+        if (cmpctblock.prefilledtxn[i].tx.IsNull())
+            return READ_STATUS_INVALID;
+
+        // index is a uint32_t, so can't overflow int64_t
+        int64_t nIndex = (int64_t)cmpctblock.prefilledtxn[i].index + lastprefilledindex + 1;
+        if (nIndex > std::numeric_limits<int32_t>::max())
+            return READ_STATUS_INVALID;
+        lastprefilledindex = (int32_t)nIndex;
+        if ((uint32_t)lastprefilledindex > cmpctblock.shorttxids.size() + i)
+        {
+            // If we are inserting a tx at an index greater than our full list of shorttxids
+            // plus the number of prefilled txn we've inserted, then we have txn for which we
+            // have neither a prefilled txn or a shorttxid!
+            return READ_STATUS_INVALID;
+        }
+        txn_available[lastprefilledindex] = cmpctblock.prefilledtxn[i].tx;
+        have_available[lastprefilledindex] = true;
+    }
+    prefilled_count = cmpctblock.prefilledtxn.size();
+
+    // Calculate map of short IDs -> positions and check mempool to see what we have (or don't)
+    boost::unordered_map<uint64_t, uint32_t> shorttxids;
+    shorttxids.rehash(cmpctblock.shorttxids.size());
+    uint32_t index_offset = 0;
+    for (size_t i = 0; i < cmpctblock.shorttxids.size(); i++)
+    {
+        while (have_available[i + index_offset])
+            index_offset++;
+        if (!shorttxids.insert(make_pair(cmpctblock.shorttxids[i], i + index_offset)).second)
+        {
+            // Short ID collision within the block, we cannot tell which transaction is which
+            return READ_STATUS_FAILED;
+        }
+    }
+
+    // Transactions matched by more than one candidate are dropped and requested explicitly
+    vector<bool> have_collision(txn_available.size(), false);
+
+    if (pool)
+    {
+        LOCK(pool->cs);
+        for (CTxMemPoolMap::const_iterator it = pool->mapTx.begin(); it != pool->mapTx.end(); ++it)
+        {
+            uint64_t shortid = cmpctblock.GetShortID(it->first);
+            boost::unordered_map<uint64_t, uint32_t>::iterator idit = shorttxids.find(shortid);
+            if (idit == shorttxids.end() || have_collision[idit->second])
+                continue;
+            if (!have_available[idit->second])
+            {
+                txn_available[idit->second] = it->second.GetTx();
+                have_available[idit->second] = true;
+                mempool_count++;
+            }
+            else
+            {
+                have_available[idit->second] = false;
+                have_collision[idit->second] = true;
+                mempool_count--;
+            }
+            if (mempool_count == shorttxids.size())
+                break;
+        }
+    }
+
+    // Slots filled from extra_txn, so collisions below decrement the counter which filled the slot
+    vector<bool> have_extra(txn_available.size(), false);
+    for (size_t i = 0; i < extra_txn.size() && mempool_count + extra_count < shorttxids.size(); i++)
+    {
+        uint256 hash = extra_txn[i].GetHash();
+        boost::unordered_map<uint64_t, uint32_t>::iterator idit = shorttxids.find(cmpctblock.GetShortID(hash));
+        if (idit == shorttxids.end() || have_collision[idit->second])
+            continue;
+        if (!have_available[idit->second])
+        {
+            txn_available[idit->second] = extra_txn[i];
+            have_available[idit->second] = true;
+            have_extra[idit->second] = true;
+            extra_count++;
+        }
+        else if (txn_available[idit->second].GetHash() != hash)
+        {
+            // Same short ID as a transaction found in mempool or earlier in the list
+            have_available[idit->second] = false;
+            have_collision[idit->second] = true;
+            if (have_extra[idit->second])
+                extra_count--;
+            else
+                mempool_count--;
+        }
+    }
+
+    if(fDebug)LogPrint("cmpctblock", "Initialized PartiallyDownloadedBlock for block %s using a cmpctblock of size %lu\n",
+            cmpctblock.header.GetHash().ToString(), GetSerializeSize(cmpctblock, SER_NETWORK, PROTOCOL_VERSION));
+
+    return READ_STATUS_OK;
+}
+
+bool PartiallyDownloadedBlock::IsTxAvailable(size_t index) const
+{
+    assert(!header.IsNull());
+    assert(index < txn_available.size());
+    return have_available[index];
+}
+
+void PartiallyDownloadedBlock::GetMissingIndexes(std::vector<uint32_t>& indexes) const
+{
+    indexes.clear();
+    for (size_t i = 0; i < have_available.size(); i++)
+        if (!have_available[i])
+            indexes.push_back(i);
+}
+
+ReadStatus PartiallyDownloadedBlock::FillBlock(CBlock& block, const std::vector<CTransaction>& vtx_missing)
+{
+    assert(!header.IsNull());
+    block = CBlock(header);
+    block.vtx.resize(txn_available.size());
+
+    size_t tx_missing_offset = 0;
+    for (size_t i = 0; i < txn_available.size(); i++)
+    {
+        if (!have_available[i])
+        {
+            if (vtx_missing.size() <= tx_missing_offset)
+                return READ_STATUS_INVALID;
+            block.vtx[i] = vtx_missing[tx_missing_offset++];
+        }
+        else
+        {
+            block.vtx[i] = txn_available[i];
+        }
+    }
+
+    // Make sure we can't call FillBlock again.
+    header.SetNull();
+    txn_available.clear();
+    have_available.clear();
+
+    if (vtx_missing.size() != tx_missing_offset)
+        return READ_STATUS_INVALID;
+
+    // Short ID collision with a transaction not in the block gives wrong merkle root,
+    // the block itself may be valid, so it is downloaded in full instead of being rejected
+    bool mutated;
+    if (block.BuildMerkleTree(&mutated) != block.hashMerkleRoot || mutated)
+        return READ_STATUS_FAILED;
+
+    if(fDebug)LogPrint("cmpctblock", "Successfully reconstructed block %s with %lu txn prefilled, %lu txn from mempool, %lu txn from wallet and %lu txn requested\n",
+            block.GetHash().ToString(), prefilled_count, mempool_count, extra_count, vtx_missing.size());
+
+    return READ_STATUS_OK;
+}
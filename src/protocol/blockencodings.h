@@ -0,0 +1,204 @@
+// Copyright (c) 2018 Apsaras Group Ltd
+// Amberchain code distributed under the GPLv3 license, see COPYING file.
+
+#ifndef AMBER_BLOCKENCODINGS_H
+#define AMBER_BLOCKENCODINGS_H
+
+#include "primitives/block.h"
+
+#include <limits>
+#include <vector>
+
+class CTxMemPool;
+
+/** Compact block protocol version sent in "sendcmpct" */
+static const uint64_t COMPACT_BLOCKS_VERSION = 1;
+/** Blocks deeper than this are always sent in full in response to compact block requests */
+static const int MAX_CMPCTBLOCK_DEPTH = 10;
+/** -compactblocks default */
+static const bool DEFAULT_COMPACT_BLOCKS = true;
+
+/** Request for transactions missing after compact block reconstruction ("getblocktxn") */
+class BlockTransactionsRequest
+{
+public:
+    // A BlockTransactionsRequest message
+    uint256 blockhash;
+    std::vector<uint32_t> indexes;
+
+    template<typename Stream>
+    void Serialize(Stream& s, int nType, int nVersion) const
+    {
+        ::Serialize(s, blockhash, nType, nVersion);
+        WriteCompactSize(s, indexes.size());
+        // Indexes are differentially encoded: each one is written as offset from the previous one plus one
+        for (size_t i = 0; i < indexes.size(); i++)
+            WriteCompactSize(s, indexes[i] - (i == 0 ? 0 : (indexes[i - 1] + 1)));
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s, int nType, int nVersion)
+    {
+        ::Unserialize(s, blockhash, nType, nVersion);
+        uint64_t nCount = ReadCompactSize(s);
+        indexes.clear();
+        uint64_t nOffset = 0;
+        for (uint64_t i = 0; i < nCount; i++)
+        {
+            uint64_t nIndex = ReadCompactSize(s) + nOffset;
+            if (nIndex > std::numeric_limits<uint32_t>::max())
+                throw std::ios_base::failure("index overflowed 32 bits");
+            indexes.push_back((uint32_t)nIndex);
+            nOffset = nIndex + 1;
+        }
+    }
+
+    unsigned int GetSerializeSize(int nType, int nVersion) const
+    {
+        CSizeComputer s(nType, nVersion);
+        Serialize(s, nType, nVersion);
+        return s.size();
+    }
+};
+
+/** Transactions sent in response to "getblocktxn" ("blocktxn") */
+class BlockTransactions
+{
+public:
+    // A BlockTransactions message
+    uint256 blockhash;
+    std::vector<CTransaction> txn;
+
+    BlockTransactions() {}
+    BlockTransactions(const BlockTransactionsRequest& req) : blockhash(req.blockhash), txn(req.indexes.size()) {}
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion) {
+        READWRITE(blockhash);
+        READWRITE(txn);
+    }
+};
+
+/** Transaction sent in full within a compact block, the coinbase is always prefilled */
+struct PrefilledTransaction
+{
+    // Offset from the previous prefilled transaction index plus one, as on the wire
+    uint32_t index;
+    CTransaction tx;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion) {
+        READWRITE(VARINT(index));
+        READWRITE(tx);
+    }
+};
+
+typedef enum ReadStatus_t
+{
+    READ_STATUS_OK,
+    READ_STATUS_INVALID,    // Invalid object, peer is sending bogus data
+    READ_STATUS_FAILED,     // Failed to process object (e.g. short ID collision), full block should be requested
+} ReadStatus;
+
+/** Block header with 6-byte short transaction IDs ("cmpctblock") */
+class CBlockHeaderAndShortTxIDs
+{
+private:
+    mutable uint64_t shorttxidk0, shorttxidk1;
+    uint64_t nonce;
+
+    void FillShortTxIDSelector() const;
+
+    friend class PartiallyDownloadedBlock;
+
+protected:
+    std::vector<uint64_t> shorttxids;
+    std::vector<PrefilledTransaction> prefilledtxn;
+
+public:
+    CBlockHeader header;
+
+    CBlockHeaderAndShortTxIDs() : shorttxidk0(0), shorttxidk1(0), nonce(0) {}
+    CBlockHeaderAndShortTxIDs(const CBlock& block);
+
+    uint64_t GetShortID(const uint256& txhash) const;
+
+    size_t BlockTxCount() const { return shorttxids.size() + prefilledtxn.size(); }
+    size_t PrefilledTxCount() const { return prefilledtxn.size(); }
+
+    template<typename Stream>
+    void Serialize(Stream& s, int nType, int nVersion) const
+    {
+        ::Serialize(s, header, nType, nVersion);
+        ::Serialize(s, nonce, nType, nVersion);
+        WriteCompactSize(s, shorttxids.size());
+        for (size_t i = 0; i < shorttxids.size(); i++)
+        {
+            uint32_t lsb = shorttxids[i] & 0xffffffff;
+            uint16_t msb = (shorttxids[i] >> 32) & 0xffff;
+            ::Serialize(s, lsb, nType, nVersion);
+            ::Serialize(s, msb, nType, nVersion);
+        }
+        ::Serialize(s, prefilledtxn, nType, nVersion);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s, int nType, int nVersion)
+    {
+        ::Unserialize(s, header, nType, nVersion);
+        ::Unserialize(s, nonce, nType, nVersion);
+        uint64_t nCount = ReadCompactSize(s);
+        shorttxids.clear();
+        // Vector grows with data actually received, count is not trusted for allocation
+        for (uint64_t i = 0; i < nCount; i++)
+        {
+            uint32_t lsb;
+            uint16_t msb;
+            ::Unserialize(s, lsb, nType, nVersion);
+            ::Unserialize(s, msb, nType, nVersion);
+            shorttxids.push_back((uint64_t(msb) << 32) | uint64_t(lsb));
+        }
+        ::Unserialize(s, prefilledtxn, nType, nVersion);
+        FillShortTxIDSelector();
+    }
+
+    unsigned int GetSerializeSize(int nType, int nVersion) const
+    {
+        CSizeComputer s(nType, nVersion);
+        Serialize(s, nType, nVersion);
+        return s.size();
+    }
+};
+
+/** Block being reconstructed from compact block and transactions we already have */
+class PartiallyDownloadedBlock
+{
+protected:
+    std::vector<CTransaction> txn_available;
+    std::vector<bool> have_available;
+    size_t prefilled_count, mempool_count, extra_count;
+    const CTxMemPool* pool;
+
+public:
+    CBlockHeader header;
+    // Time reconstruction started, in microseconds
+    int64_t nTimeStart;
+
+    PartiallyDownloadedBlock(const CTxMemPool* poolIn) : prefilled_count(0), mempool_count(0), extra_count(0), pool(poolIn), nTimeStart(0) {}
+
+    // extra_txn is a list of extra transactions to look at, e.g. unconfirmed wallet transactions
+    ReadStatus InitData(const CBlockHeaderAndShortTxIDs& cmpctblock, const std::vector<CTransaction>& extra_txn);
+    bool IsTxAvailable(size_t index) const;
+    void GetMissingIndexes(std::vector<uint32_t>& indexes) const;
+    ReadStatus FillBlock(CBlock& block, const std::vector<CTransaction>& vtx_missing);
+
+    size_t GetPrefilledCount() const { return prefilled_count; }
+    size_t GetMempoolCount() const { return mempool_count; }
+    size_t GetExtraCount() const { return extra_count; }
+};
+
+#endif // AMBER_BLOCKENCODINGS_H
@@ -29,19 +29,29 @@ bool AcceptAssetTransfers(const CTransaction& tx, const CCoinsViewCache &inputs,
 bool AcceptAssetGenesis(const CTransaction &tx,int offset,bool accept,string& reason);
 bool AcceptPermissionsAndCheckForDust(const CTransaction &tx,bool accept,string& reason);
 bool IsTxBanned(uint256 txid);
+bool IsMinerTx(const CTransaction& tx);
+int GetFeeExemptionVersion();
+bool UpdateFeeExemptionVersion();
 
 
 bool ReplayMemPool(CTxMemPool& pool, int from,bool accept)
 {
     int pos;
     uint256 hash;
+    vector<bool> vExists;
+    set<uint256> setRemoved;
+    
+/* AMB START */
+// Existence of all rows is checked under single lock, transactions removed by this replay are tracked locally    
+    pool.existsHashList(from,vExists);
+/* AMB END */
     
     if(mc_gState->m_NetworkParams->IsProtocolMultichain() == 0)
     {
-        for(pos=from;pos<pool.hashList->m_Count;pos++)
+        for(pos=from;pos<from+(int)vExists.size();pos++)
         {
             hash=*(uint256*)pool.hashList->GetRow(pos);
-            if(pool.exists(hash))
+            if(vExists[pos-from] && (setRemoved.count(hash) == 0))
             {
                 if(IsTxBanned(hash))
                 {
@@ -52,6 +62,10 @@ bool ReplayMemPool(CTxMemPool& pool, int from,bool accept)
                     removed_type="banned";                                    
                     LogPrintf("mchn: Tx %s removed from the mempool (%s), reason: %s\n",tx.GetHash().ToString().c_str(),removed_type.c_str(),reason.c_str());
                     pool.remove(tx, removed, true, "replay");                    
+                    BOOST_FOREACH(const CTransaction& txRemoved, removed)
+                    {
+                        setRemoved.insert(txRemoved.GetHash());
+                    }
                 }
             }
         }
@@ -63,10 +77,10 @@ bool ReplayMemPool(CTxMemPool& pool, int from,bool accept)
     LogPrint("mchn", "mchn: Replaying memory pool (%d new transactions, total %d)\n",total_txs-from,total_txs);
     mc_gState->m_Permissions->MempoolPermissionsCopy();
     
-    for(pos=from;pos<pool.hashList->m_Count;pos++)
+    for(pos=from;pos<from+(int)vExists.size();pos++)
     {
         hash=*(uint256*)pool.hashList->GetRow(pos);
-        if(pool.exists(hash))
+        if(vExists[pos-from] && (setRemoved.count(hash) == 0))
         {
             const CTxMemPoolEntry entry=pool.mapTx[hash];
             const CTransaction& tx = entry.GetTx();            
@@ -156,6 +170,23 @@ bool ReplayMemPool(CTxMemPool& pool, int from,bool accept)
                     pool.remove(tx, removed, true, "replay");                                        
                 }
             }
+            BOOST_FOREACH(const CTransaction& txRemoved, removed)
+            {
+                setRemoved.insert(txRemoved.GetHash());
+            }
+        }
+    }
+    
+    if(UpdateFeeExemptionVersion())
+    {
+        int version=GetFeeExemptionVersion();
+        LOCK(pool.cs);
+        for(CTxMemPoolMap::iterator it=pool.mapTx.begin();it!=pool.mapTx.end();++it)
+        {
+            if(it->second.FeeExemptVersion() != version)
+            {
+                it->second.SetFeeExempt(IsMinerTx(it->second.GetTx()),version);
+            }
         }
     }
     
@@ -332,7 +363,7 @@ bool VerifyBlockMiner(CBlock *block_in,CBlockIndex* pindexNew)
 {
     if( (mc_gState->m_NetworkParams->IsProtocolMultichain() == 0) ||
         (mc_gState->m_Features->CachedInputScript() == 0) ||
-        (mc_gState->m_NetworkParams->GetInt64Param("supportminerprecheck") == 0) ||
+        (mc_gState->m_NetworkParams->GetInt64Param(MC_PRM_ID_SUPPORT_MINER_PRECHECK) == 0) ||
         (MCP_ANYONE_CAN_MINE) )                               
     {
         pindexNew->fPassedMinerPrecheck=true;
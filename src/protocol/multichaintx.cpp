@@ -798,7 +798,7 @@ bool AcceptMultiChainTransaction(const CTransaction& tx,
     fCheckCachedScript=false;
     if(mc_gState->m_Features->CachedInputScript())
     {
-        if(mc_gState->m_NetworkParams->GetInt64Param("supportminerprecheck"))                                
+        if(mc_gState->m_NetworkParams->GetInt64Param(MC_PRM_ID_SUPPORT_MINER_PRECHECK))                                
         {
             fCheckCachedScript=true;
         }        
@@ -19,7 +19,8 @@ static const char* ppszTypeName[] =
     "ERROR",
     "tx",
     "block",
-    "filtered block"
+    "filtered block",
+    "cmpctblock"                                                                // AMB
 };
 
 CMessageHeader::CMessageHeader()
@@ -148,6 +148,10 @@ enum {
     // Nodes may always request a MSG_FILTERED_BLOCK in a getdata, however,
     // MSG_FILTERED_BLOCK should not appear in any invs except as a part of getdata.
     MSG_FILTERED_BLOCK,
+/* AMB START */
+    // Requested in getdata only, answered with "cmpctblock" (or "block" for older blocks)
+    MSG_CMPCT_BLOCK,
+/* AMB END */
 };
 
 #endif // BITCOIN_PROTOCOL_H
@@ -8,6 +8,7 @@
 #include "core/main.h"
 #include "rpc/rpcserver.h"
 #include "rpc/rpcserver.h"
+#include "script/sigcache.h"
 #include "utils/sync.h"
 #include "utils/util.h"
 
@@ -375,6 +376,10 @@ Value listblocks(const Array& params, bool fHelp)
         CBlock block;
         if(verbose)
         {
+/* AMB START */
+            if (fHavePruned && !(chainActive[heights[i]]->nStatus & BLOCK_HAVE_DATA))
+                throw JSONRPCError(RPC_INTERNAL_ERROR, strprintf("Block %d was pruned", heights[i]));
+/* AMB END */
             if(!ReadBlockFromDisk(block, chainActive[heights[i]]))
                 throw JSONRPCError(RPC_INTERNAL_ERROR, "Can't read block from disk");
         }
@@ -434,6 +439,10 @@ Value getblock(const Array& params, bool fHelp)
     CBlock block;
     CBlockIndex* pblockindex = mapBlockIndex[hash];
 
+/* AMB START */
+    if (fHavePruned && !(pblockindex->nStatus & BLOCK_HAVE_DATA) && (pblockindex->nTx > 0))
+        throw JSONRPCError(RPC_INTERNAL_ERROR, "Block was pruned");
+/* AMB END */
     if(!ReadBlockFromDisk(block, pblockindex))
         throw JSONRPCError(RPC_INTERNAL_ERROR, "Can't read block from disk");
 
@@ -600,6 +609,11 @@ Value getblockchaininfo(const Array& params, bool fHelp)
     obj.push_back(Pair("difficulty",            (double)GetDifficulty()));
     obj.push_back(Pair("verificationprogress",  Checkpoints::GuessVerificationProgress(chainActive.Tip())));
     obj.push_back(Pair("chainwork",             chainActive.Tip()->nChainWork.GetHex()));
+/* AMB START */
+    obj.push_back(Pair("pruned",                fHavePruned));
+    if (fPruneMode)
+        obj.push_back(Pair("prunedepth",        GetPruneKeepDepth()));
+/* AMB END */
     return obj;
 }
 
@@ -686,8 +700,19 @@ Value getmempoolinfo(const Array& params, bool fHelp)
     Object ret;
     ret.push_back(Pair("size", (int64_t) mempool.size()));
     ret.push_back(Pair("bytes", (int64_t) mempool.GetTotalTxSize()));
+    ret.push_back(Pair("usage", (int64_t) mempool.DynamicMemoryUsage()));
+    ret.push_back(Pair("maxmempool", (int64_t) GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000));
 //    ret.push_back(Pair("orphan", OrphanPoolSize()));
 
+    int64_t nSigCacheEntries, nSigCacheCapacity, nSigCacheLookups, nSigCacheHits;
+    GetSignatureCacheStats(nSigCacheEntries, nSigCacheCapacity, nSigCacheLookups, nSigCacheHits);
+    Object sigcache;
+    sigcache.push_back(Pair("entries", nSigCacheEntries));
+    sigcache.push_back(Pair("capacity", nSigCacheCapacity));
+    sigcache.push_back(Pair("lookups", nSigCacheLookups));
+    sigcache.push_back(Pair("hits", nSigCacheHits));
+    ret.push_back(Pair("sigcache", sigcache));
+
     return ret;
 }
 
@@ -250,6 +250,7 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "createrawtransaction", 2 },
     { "createrawsendfrom", 1 },
     { "createrawsendfrom", 2 },
+    { "purchaseservice", 1 },
     { "signrawtransaction", 1 },
     { "signrawtransaction", 2 },
     { "sendrawtransaction", 1 },
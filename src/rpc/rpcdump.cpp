@@ -92,6 +92,8 @@ Value importprivkey(const Array& params, bool fHelp)
     bool fRescan = true;
     if (params.size() > 2)
         fRescan = params[2].get_bool();
+    if (fRescan)
+        EnsureRescanPossible(chainActive.Genesis());
 
     
     bool fNewFound=false;
@@ -193,6 +195,8 @@ Value importaddress(const Array& params, bool fHelp)
     bool fRescan = true;
     if (params.size() > 2)
         fRescan = params[2].get_bool();
+    if (fRescan)
+        EnsureRescanPossible(chainActive.Genesis());
 
     bool fNewFound=false;
     vector<string> inputStrings=ParseStringList(params[0]);
@@ -301,6 +305,7 @@ Value importwallet(const Array& params, bool fHelp)
         throw runtime_error("Help message not found\n");
 
     EnsureWalletIsUnlocked();
+    EnsureRescanPossible(chainActive.Genesis());
 
     ifstream file;
     file.open(params[0].get_str().c_str(), std::ios::in | std::ios::ate);
@@ -97,7 +97,9 @@ void mc_InitRPCHelpMap01()
             "  \"bestblockhash\": \"...\",           (string) the hash of the currently best block\n"
             "  \"difficulty\": xxxxxx,             (numeric) the current difficulty\n"
             "  \"verificationprogress\": xxxx,     (numeric) estimate of verification progress [0..1]\n"
-            "  \"chainwork\": \"xxxx\"               (string) total amount of work in active chain, in hexadecimal\n"
+            "  \"chainwork\": \"xxxx\",              (string) total amount of work in active chain, in hexadecimal\n"
+            "  \"pruned\": true|false,             (boolean) some block files were deleted by -prunedepth\n"
+            "  \"prunedepth\": xxxxxx              (numeric) blocks deeper than this are pruned, only if -prunedepth is set\n"
             "}\n"
             "\nExamples:\n"
             + HelpExampleCli("getblockchaininfo", "")
@@ -173,6 +175,14 @@ void mc_InitRPCHelpMap01()
             "{\n"
             "  \"size\": xxxxx                     (numeric) Current tx count\n"
             "  \"bytes\": xxxxx                    (numeric) Sum of all tx sizes\n"
+            "  \"usage\": xxxxx                    (numeric) Estimated memory usage of the pool, including wallet rows\n"
+            "  \"maxmempool\": xxxxx               (numeric) Maximal memory usage of the pool, 0 - unlimited\n"
+            "  \"sigcache\": {                     (object) Signature cache statistics\n"
+            "    \"entries\": xxxxx                (numeric) Cached valid signatures\n"
+            "    \"capacity\": xxxxx               (numeric) Maximal number of cached signatures\n"
+            "    \"lookups\": xxxxx                (numeric) Cache lookups since startup\n"
+            "    \"hits\": xxxxx                   (numeric) Successful cache lookups since startup\n"
+            "  }\n"
             "}\n"
             "\nExamples:\n"
             + HelpExampleCli("getmempoolinfo", "")
@@ -717,7 +727,20 @@ void mc_InitRPCHelpMap04()
             "    \"score\": xxx                         (numeric) relative score\n"
             "  }\n"
             "  ,...\n"
-            "  ]\n"
+            "  ],\n"
+            "  \"compactblocks\": {                    (object) compact block relay statistics\n"
+            "    \"enabled\": true|false,               (boolean) compact blocks are requested from peers supporting them\n"
+            "    \"sent\": xxx,                         (numeric) compact blocks sent\n"
+            "    \"received\": xxx,                     (numeric) compact blocks received\n"
+            "    \"reconstructed\": xxx,                (numeric) blocks reconstructed from mempool without round trip\n"
+            "    \"reconstructedroundtrip\": xxx,       (numeric) blocks reconstructed after requesting missing transactions\n"
+            "    \"fallback\": xxx,                     (numeric) blocks downloaded in full after failed reconstruction\n"
+            "    \"txfrommempool\": xxx,                (numeric) transactions found in mempool\n"
+            "    \"txfromwallet\": xxx,                 (numeric) transactions found in unconfirmed wallet transactions\n"
+            "    \"txrequested\": xxx,                  (numeric) transactions requested from peers\n"
+            "    \"hitrate\": x.xxx,                    (numeric) share of non-prefilled transactions found locally\n"
+            "    \"avgreconstructms\": x.xxx            (numeric) average reconstruction time, in milliseconds\n"
+            "  }\n"
             "}\n"
             "\nExamples:\n"
             + HelpExampleCli("getnetworkinfo", "")
@@ -2028,6 +2051,14 @@ void mc_InitRPCHelpMap09()
             "  \"keypoolsize\": xxxx,              (numeric) how many new keys are pre-generated\n"
             "  \"unlocked_until\": ttt,            (numeric) the timestamp in seconds since epoch (midnight Jan 1 1970 GMT)\n"
             "                                              that the wallet is unlocked for transfers, or 0 if the wallet is locked\n"
+            "  \"groupcommit\": {                  (object) wallet database log flushes since startup, only if -walletgroupcommit is on\n"
+            "    \"syncs\": xxxx,                   (numeric) number of log flushes\n"
+            "    \"writes\": xxxx,                  (numeric) number of writes made durable by these flushes\n"
+            "    \"avgbatch\": x.xxx,               (numeric) average number of writes per flush\n"
+            "    \"maxbatch\": xxxx,                (numeric) largest number of writes in one flush\n"
+            "    \"avglatency\": x.xxx,             (numeric) average flush time, in milliseconds\n"
+            "    \"maxlatency\": x.xxx              (numeric) longest flush time, in milliseconds\n"
+            "  }\n"
             "}\n"
             "\nExamples:\n"
             + HelpExampleCli("getwalletinfo", "")
@@ -2267,6 +2298,7 @@ void mc_InitRPCHelpMap10()
             "2. \"label\"                          (string, optional, default=\"\") An optional label\n"
             "3. rescan                           (boolean, optional, default=true) Rescan the wallet for transactions\n"
             "\nNote: This call can take minutes to complete if rescan is true.\n"
+            "      Rescan is refused if some blocks were pruned by -prunedepth.\n"
             "\nResult:\n"
             "\nExamples:\n"
             "\nImport an address with rescan\n"
@@ -2287,6 +2319,7 @@ void mc_InitRPCHelpMap10()
             "2. \"label\"                          (string, optional, default=\"\") An optional label\n"
             "3. rescan                           (boolean, optional, default=true) Rescan the wallet for transactions\n"
             "\nNote: This call can take minutes to complete if rescan is true.\n"
+            "      Rescan is refused if some blocks were pruned by -prunedepth.\n"
             "\nResult:\n"
             "\nExamples:\n"
             "\nDump a private key\n"
@@ -3508,7 +3541,10 @@ void mc_InitRPCHelpMap15()
             " or\n"
             "1. entity-identifier(s)             (array, optional) A json array of stream or asset identifiers \n"                
             "2. rescan                           (boolean, optional, default=true) Rescan the wallet for transactions\n"
-            "\nNote: This call can take minutes to complete if rescan is true.\n"
+            "\nNote: If rescan is true, rescan runs in background unless -backgroundrescan=0 is set,\n"
+            "      progress is reported in \"rescanprogress\" field of liststreams until the stream is synchronized.\n"
+            "      With -streamindex, when only streams are subscribed, only blocks with items of these streams are processed.\n"
+            "      Rescan is refused if some blocks were pruned by -prunedepth.\n"
             "\nResult:\n"
             "\nExamples:\n"
             "\nSubscribe to the stream with rescan\n"
@@ -4154,6 +4190,36 @@ void mc_InitRPCHelpMap17()
         "\nExample:\n"
         + HelpExampleCli("purchaseconsumableservice", "1M72Sfpbz1BPpXFHz9m3CdqATR44Jvaydd 5d06edd7a0dbd0d83478c25fbf30cf3f07ceac45d9ced1591f6bd982fb878647 servicename 1000 5 1AN7chsRuUyEtQGgZEDJs3eNBrAapzY2Ab'' '' 0")
     ));
+    mapHelpStrings.insert(std::make_pair("purchaseservice",
+        "purchaseservice \"from-address\" purchase|[purchase,...]\n"
+        "\nPurchases one or several services in one call: looks up the service, resolves escrow address, sends the payment\n"
+        "(non-consumable services only), records the purchase in purchasestatus stream, signs and broadcasts the transaction.\n"
+        "All purchases are validated before the first transaction is sent. Details of derived escrow multisig address are\n"
+        "published to multisigs stream after the first purchase paying to it is sent.\n"
+        "\nArguments:\n"
+        "1. \"from-address\"                (string, required) Address, must be address of service buyer\n"
+        "2. purchase                      (object or array of objects, required) Purchase or list of purchases\n"
+        "    {\n"
+        "      \"servicetxid\":\"txid\",        (string, required) Transaction ID of the service being purchased\n"
+        "      \"amount\":x,                  (numeric or string, required) The total amount that the buyer has to pay\n"
+        "      \"quantity\":n,                (numeric or string, optional) Quantity of consumable service, required for consumable service,\n"
+        "                                     number of instances for non-consumable service, default 1\n"
+        "      \"servicename\":\"name\",        (string, optional) Name of the service, default - name in service details\n"
+        "      \"consumable\":true|false,     (boolean, optional) Default - true if service has asset holder\n"
+        "      \"escrowaddress\":\"address\",   (string, optional) Escrow address, default for non-consumable service -\n"
+        "                                     buyer escrow address if service has expiration period\n"
+        "      \"badgenotescreator\":\"notes\", (string, optional) Badge notes that is encrypted for the badge creator\n"
+        "      \"badgenotesseller\":\"notes\",  (string, optional) Badge notes that is encrypted for the badge seller\n"
+        "      \"conversion_rate\":x          (numeric or string, optional) Conversion rate at the time of purchase, default 1\n"
+        "    }\n"
+        "\nResult:\n"
+        "\"transactionid\"                  (string) For single purchase, the transaction id\n"
+        "[\"transactionid\"|{\"code\":n,\"message\":\"error\"},...]  (array) For list of purchases, transaction id or error of every purchase\n"
+        "\nExamples:\n"
+        + HelpExampleCli("purchaseservice", "1M72Sfpbz1BPpXFHz9m3CdqATR44Jvaydd '{\"servicetxid\":\"5d06edd7a0dbd0d83478c25fbf30cf3f07ceac45d9ced1591f6bd982fb878647\",\"amount\":1000}'")
+        + HelpExampleCli("purchaseservice", "1M72Sfpbz1BPpXFHz9m3CdqATR44Jvaydd '[{\"servicetxid\":\"5d06edd7a0dbd0d83478c25fbf30cf3f07ceac45d9ced1591f6bd982fb878647\",\"amount\":1000,\"quantity\":5}]'")
+        + HelpExampleRpc("purchaseservice", "\"1M72Sfpbz1BPpXFHz9m3CdqATR44Jvaydd\", {\"servicetxid\":\"5d06edd7a0dbd0d83478c25fbf30cf3f07ceac45d9ced1591f6bd982fb878647\",\"amount\":1000}")
+    ));
     mapHelpStrings.insert(std::make_pair("updatepurchasestatus",
         "updatepurchasestatus\n"
         "\nWrites the purchase status to the purchase status stream.\n"
@@ -210,6 +210,7 @@ static const CRPCCommand vRPCCommands[] =
     { "wallet",             "delistservice",          &delistservice,          false,     false,      true },
     { "wallet",             "purchasenonconsumableservice", &purchasenonconsumableservice,  false,  false,  true },
     { "wallet",             "purchaseconsumableservice",    &purchaseconsumableservice,     false,  false,  true },
+    { "wallet",             "purchaseservice",        &purchaseservice,        false,     false,      true },
     { "wallet",             "delistservice",          &delistservice,          false,     false,      true },
     { "wallet",             "logactivity",            &logactivity,            false,     false,      true },
     { "wallet",             "sharetxn",               &sharetxn,               false,     false,      true },
@@ -10,6 +10,7 @@
 #include "net/net.h"
 #include "net/netbase.h"
 #include "protocol/netprotocol.h"
+#include "protocol/blockencodings.h"
 #include "utils/sync.h"
 #include "utils/timedata.h"
 #include "utils/util.h"
@@ -338,5 +339,24 @@ Value getnetworkinfo(const Array& params, bool fHelp)
         }
     }
     obj.push_back(Pair("localaddresses", localAddresses));
+/* AMB START */
+    CCompactBlockStats cmpctStats;
+    GetCompactBlockStats(cmpctStats);
+    Object cmpct;
+    uint64_t nTxFound = cmpctStats.nTxFromMempool + cmpctStats.nTxFromWallet;
+    uint64_t nBlocks = cmpctStats.nReconstructed + cmpctStats.nReconstructedRoundTrip;
+    cmpct.push_back(Pair("enabled", GetBoolArg("-compactblocks", DEFAULT_COMPACT_BLOCKS)));
+    cmpct.push_back(Pair("sent", (int64_t)cmpctStats.nSent));
+    cmpct.push_back(Pair("received", (int64_t)cmpctStats.nReceived));
+    cmpct.push_back(Pair("reconstructed", (int64_t)cmpctStats.nReconstructed));
+    cmpct.push_back(Pair("reconstructedroundtrip", (int64_t)cmpctStats.nReconstructedRoundTrip));
+    cmpct.push_back(Pair("fallback", (int64_t)cmpctStats.nFallback));
+    cmpct.push_back(Pair("txfrommempool", (int64_t)cmpctStats.nTxFromMempool));
+    cmpct.push_back(Pair("txfromwallet", (int64_t)cmpctStats.nTxFromWallet));
+    cmpct.push_back(Pair("txrequested", (int64_t)cmpctStats.nTxRequested));
+    cmpct.push_back(Pair("hitrate", (nTxFound + cmpctStats.nTxRequested) ? (double)nTxFound / (nTxFound + cmpctStats.nTxRequested) : 0.));
+    cmpct.push_back(Pair("avgreconstructms", nBlocks ? 0.001 * cmpctStats.nReconstructionTime / nBlocks : 0.));
+    obj.push_back(Pair("compactblocks", cmpct));
+/* AMB END */
     return obj;
 }
@@ -1222,7 +1222,7 @@ Value appendrawtransaction(const Array& params, bool fHelp)
     {
         if(mc_gState->m_Features->CachedInputScript())
         {
-            if(mc_gState->m_NetworkParams->GetInt64Param("supportminerprecheck"))                                
+            if(mc_gState->m_NetworkParams->GetInt64Param(MC_PRM_ID_SUPPORT_MINER_PRECHECK))                                
             {
                 fCachedInputScriptRequired=true;
             }
@@ -1389,7 +1389,7 @@ Value createrawtransaction(const Array& params, bool fHelp)
     {
         if(mc_gState->m_Features->CachedInputScript())
         {
-            if(mc_gState->m_NetworkParams->GetInt64Param("supportminerprecheck"))                                
+            if(mc_gState->m_NetworkParams->GetInt64Param(MC_PRM_ID_SUPPORT_MINER_PRECHECK))                                
             {
                 fCachedInputScriptRequired=true;
             }
@@ -1881,6 +1881,11 @@ Value signrawtransaction(const Array& params, bool fHelp)
     bool fHashSingle = ((nHashType & ~SIGHASH_ANYONECANPAY) == SIGHASH_SINGLE);
 
     // Sign what we can:
+/* AMB START */
+    vector<CScript> vPrevPubKeys(mergedTx.vin.size());
+    vector<CScript> vFromPubKeys(mergedTx.vin.size());
+    vector<bool> vAvailable(mergedTx.vin.size(), false);
+    vector<bool> vSigned;
     for (unsigned int i = 0; i < mergedTx.vin.size(); i++) {
         CTxIn& txin = mergedTx.vin[i];
         const CCoins* coins = view.AccessCoins(txin.prevout.hash);
@@ -1888,20 +1893,33 @@ Value signrawtransaction(const Array& params, bool fHelp)
             fComplete = false;
             continue;
         }
-        const CScript& prevPubKey = coins->vout[txin.prevout.n].scriptPubKey;
+        vAvailable[i] = true;
+        vPrevPubKeys[i] = coins->vout[txin.prevout.n].scriptPubKey;
 
         txin.scriptSig.clear();
         // Only sign SIGHASH_SINGLE if there's a corresponding output:
         if (!fHashSingle || (i < mergedTx.vout.size()))
-            SignSignature(keystore, prevPubKey, mergedTx, i, nHashType);
+            vFromPubKeys[i] = vPrevPubKeys[i];
+    }
+    SignSignatures(keystore, vFromPubKeys, mergedTx, vSigned, nHashType);
+
+    // Signature hash doesn't depend on scriptSigs, so it is computed once for merging and verification
+    const CTransaction txConst(mergedTx);
+    CSignatureHashCache sighashcache(txConst);
+    for (unsigned int i = 0; i < mergedTx.vin.size(); i++) {
+        if (!vAvailable[i])
+            continue;
+        CTxIn& txin = mergedTx.vin[i];
+        const CScript& prevPubKey = vPrevPubKeys[i];
 
         // ... and merge in other signatures:
         BOOST_FOREACH(const CMutableTransaction& txv, txVariants) {
-            txin.scriptSig = CombineSignatures(prevPubKey, mergedTx, i, txin.scriptSig, txv.vin[i].scriptSig);
+            txin.scriptSig = CombineSignatures(prevPubKey, txConst, i, txin.scriptSig, txv.vin[i].scriptSig, &sighashcache);
         }
-        if (!VerifyScript(txin.scriptSig, prevPubKey, STANDARD_SCRIPT_VERIFY_FLAGS | SCRIPT_VERIFY_SKIP_SEND_PERMISSION_CHECK, MutableTransactionSignatureChecker(&mergedTx, i)))
+        if (!VerifyScript(txin.scriptSig, prevPubKey, STANDARD_SCRIPT_VERIFY_FLAGS | SCRIPT_VERIFY_SKIP_SEND_PERMISSION_CHECK, TransactionSignatureChecker(&txConst, i, &sighashcache)))
             fComplete = false;
     }
+/* AMB END */
 
     Object result;
     result.push_back(Pair("hex", EncodeHexTx(mergedTx)));
@@ -47,6 +47,34 @@ static boost::thread_group* rpc_worker_group = NULL;
 static boost::asio::io_service::work *rpc_dummy_work = NULL;
 static std::vector<CSubNet> rpc_allow_subnets; //!< List of subnets to allow RPC connections from
 static std::vector< boost::shared_ptr<ip::tcp::acceptor> > rpc_acceptors;
+//! Worker pool for read-only elements of JSON-RPC batch requests
+static asio::io_service* rpc_batch_io_service = NULL;
+static asio::io_service::work *rpc_batch_work = NULL;
+static boost::thread_group* rpc_batch_group = NULL;
+static set<string> setBatchReadOnlyCommands;
+
+/**
+ * Commands which do not change node, chain or wallet state and may be executed concurrently within
+ * batch request. Commands requiring cs_main/cs_wallet still take them in CRPCTable::execute.
+ * Commands which may create keys or publish transactions (getnewaddress, getescrowmultisigaddress, ...) are not listed.
+ */
+static const char *vBatchReadOnlyCommands[] =
+{
+    "help",
+    "getinfo", "getblockchaininfo", "getblockchainparams", "getruntimeparams",
+    "getbestblockhash", "getblockcount", "getblockhash", "getblock", "getchaintips", "getdifficulty", "listblocks",
+    "getmempoolinfo", "getrawmempool", "getrawtransaction", "gettxout", "gettxoutdata",
+    "decoderawtransaction", "decodescript", "validateaddress",
+    "getconnectioncount", "getpeerinfo", "getaddednodeinfo", "getnettotals", "getnetworkinfo",
+    "estimatefee", "estimatepriority",
+    "liststreams", "getstreamitem", "liststreamitems", "liststreamkeys", "liststreamkeyitems",
+    "liststreampublishers", "liststreampublisheritems", "liststreamblockitems",
+    "listassets", "getassettransaction", "listassettransactions", "listpermissions",
+    "getaddresses", "listaddresses", "getservice", "listservice",
+    "getbalance", "getassetbalances", "gettotalbalances", "getmultibalances", "getaddressbalances", "listunspent",
+    "gettransaction", "listtransactions", "getwallettransaction", "listwallettransactions",
+    "getaddresstransaction", "listaddresstransactions",
+};
 
 string JSONRPCRequestForLog(const string& strMethod, const Array& params, const Value& id)
 {
@@ -817,9 +845,40 @@ void StartRPCThreads()
     for (int i = 0; i < GetArg("-rpcthreads", 4); i++)
         rpc_worker_group->create_thread(boost::bind(&asio::io_service::run, rpc_io_service));
     
+    StartRPCBatchThreads(GetArg("-rpcbatchthreads", 4));
+    
     fRPCRunning = true;
 }
 
+void StartRPCBatchThreads(int nThreads)
+{
+    if( (nThreads <= 0) || (rpc_batch_io_service != NULL) )
+        return;
+    
+    setBatchReadOnlyCommands.clear();
+    for (unsigned int i = 0; i < sizeof(vBatchReadOnlyCommands) / sizeof(vBatchReadOnlyCommands[0]); i++)
+        setBatchReadOnlyCommands.insert(vBatchReadOnlyCommands[i]);
+    
+    rpc_batch_io_service = new asio::io_service();
+    rpc_batch_work = new asio::io_service::work(*rpc_batch_io_service);
+    rpc_batch_group = new boost::thread_group();
+    for (int i = 0; i < nThreads; i++)
+        rpc_batch_group->create_thread(boost::bind(&asio::io_service::run, rpc_batch_io_service));
+}
+
+void StopRPCBatchThreads()
+{
+    if (rpc_batch_io_service == NULL)
+        return;
+    
+    delete rpc_batch_work; rpc_batch_work = NULL;
+    rpc_batch_io_service->stop();
+    if (rpc_batch_group != NULL)
+        rpc_batch_group->join_all();
+    delete rpc_batch_group; rpc_batch_group = NULL;
+    delete rpc_batch_io_service; rpc_batch_io_service = NULL;
+}
+
 void StartDummyRPCThread()
 {
     if(rpc_io_service == NULL)
@@ -863,6 +922,7 @@ void StopRPCThreads()
     cvBlockChange.notify_all();
     if (rpc_worker_group != NULL)
         rpc_worker_group->join_all();
+    StopRPCBatchThreads();
     delete rpc_dummy_work; rpc_dummy_work = NULL;
     delete rpc_worker_group; rpc_worker_group = NULL;
     delete rpc_ssl_context; rpc_ssl_context = NULL;
@@ -1001,11 +1061,115 @@ static Object JSONRPCExecOne(const Value& req)
     return rpc_result;
 }
 
-static string JSONRPCExecBatch(const Array& vReq)
+/**
+ * Run of consecutive read-only elements of a batch request.
+ * Elements are claimed one at a time by the requesting thread and by the batch
+ * worker pool, results are stored at the element's position in the batch.
+ */
+class CRPCBatchRun
+{
+public:
+    const Array *lpReq;
+    vector<Object> vResult;
+    unsigned int nNext;
+    unsigned int nEnd;
+    unsigned int nDone;
+    boost::mutex mutex;
+    boost::condition_variable cond;
+
+    CRPCBatchRun(const Array& vReq,unsigned int nBegin,unsigned int nEndIn)
+    {
+        lpReq=&vReq;
+        vResult.resize(nEndIn-nBegin);
+        nNext=nBegin;
+        nEnd=nEndIn;
+        nDone=0;
+    }
+    
+    void Run()
+    {
+        unsigned int nBegin=nEnd-vResult.size();
+        while(true)
+        {
+            unsigned int reqIdx;
+            {
+                boost::unique_lock<boost::mutex> lock(mutex);
+                if(nNext >= nEnd)
+                    return;
+                reqIdx=nNext++;
+            }
+            
+            Object result=JSONRPCExecOne((*lpReq)[reqIdx]);
+            
+            {
+                boost::unique_lock<boost::mutex> lock(mutex);
+                vResult[reqIdx-nBegin]=result;
+                nDone++;
+                if(nDone == vResult.size())
+                    cond.notify_all();
+            }
+        }
+    }
+    
+    void Wait()
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        while(nDone < vResult.size())
+            cond.wait(lock);
+    }
+};
+
+static void RPCBatchRunHandler(boost::shared_ptr<CRPCBatchRun> run)
+{
+    run->Run();
+}
+
+static bool JSONRPCIsReadOnly(const Value& req)
+{
+    if (req.type() != obj_type)
+        return false;
+    
+    Value valMethod = find_value(req.get_obj(), "method");
+    if (valMethod.type() != str_type)
+        return false;
+    
+    return setBatchReadOnlyCommands.count(valMethod.get_str()) != 0;
+}
+
+string JSONRPCExecBatch(const Array& vReq)
 {
     Array ret;
-    for (unsigned int reqIdx = 0; reqIdx < vReq.size(); reqIdx++)
-        ret.push_back(JSONRPCExecOne(vReq[reqIdx]));
+    unsigned int reqIdx = 0;
+    while (reqIdx < vReq.size())
+    {
+        unsigned int reqEnd = reqIdx;
+        if ( (rpc_batch_io_service != NULL) && !LogAcceptCategory("walletcompare") )         // walletcompare switches wallet mode temporarily
+            while ( (reqEnd < vReq.size()) && JSONRPCIsReadOnly(vReq[reqEnd]) )
+                reqEnd++;
+        
+        if (reqEnd - reqIdx < 2)
+        {
+            // Commands which may change state are executed in batch order
+            ret.push_back(JSONRPCExecOne(vReq[reqIdx]));
+            reqIdx++;
+            continue;
+        }
+        
+        // Read-only commands between them are executed concurrently, this thread takes part in the run,
+        // so the batch completes even if all pool workers are busy
+        boost::shared_ptr<CRPCBatchRun> run(new CRPCBatchRun(vReq,reqIdx,reqEnd));
+        unsigned int nHelpers = reqEnd - reqIdx - 1;
+        if (nHelpers > rpc_batch_group->size())
+            nHelpers = rpc_batch_group->size();
+        for (unsigned int i = 0; i < nHelpers; i++)
+            rpc_batch_io_service->post(boost::bind(RPCBatchRunHandler, run));
+        run->Run();
+        run->Wait();
+        
+        for (unsigned int i = 0; i < run->vResult.size(); i++)
+            ret.push_back(run->vResult[i]);
+        reqIdx = reqEnd;
+    }
 
     return write_string(Value(ret), false) + "\n";
 }
@@ -1192,6 +1356,11 @@ json_spirit::Value CRPCTable::execute(const std::string &strMethod, const json_s
         }
         
         Value result;
+/* AMB START */
+#ifdef ENABLE_WALLET
+        CDBDeferLogSync deferLogSync;                                           // Wallet log is synced after locks below are released
+#endif
+/* AMB END */
         {
             if (pcmd->threadSafe)
                 result = pcmd->actor(params, false);
@@ -48,6 +48,11 @@ void StartDummyRPCThread();
 void StopRPCThreads();
 /** Query whether RPC is running */
 bool IsRPCRunning();
+/** Start/stop worker pool executing read-only elements of JSON-RPC batch requests, 0 - sequential execution */
+void StartRPCBatchThreads(int nThreads);
+void StopRPCBatchThreads();
+/** Execute JSON-RPC batch request, returns serialized array of replies */
+std::string JSONRPCExecBatch(const json_spirit::Array& vReq);
 
 /** 
  * Set the RPC warmup status.  When this is done, all RPC calls will error out
@@ -158,6 +163,7 @@ extern std::string HelpExampleCli(std::string methodname, std::string args);
 extern std::string HelpExampleRpc(std::string methodname, std::string args);
 
 extern void EnsureWalletIsUnlocked();
+extern void EnsureRescanPossible(const CBlockIndex* pindexStart);
 
 extern json_spirit::Value help(const json_spirit::Array& params, bool fHelp); 
 extern json_spirit::Value stop(const json_spirit::Array& params, bool fHelp); 
@@ -228,6 +234,7 @@ extern json_spirit::Value updateservice(const json_spirit::Array& params, bool f
 extern json_spirit::Value delistservice(const json_spirit::Array& params, bool fHelp);
 extern json_spirit::Value purchasenonconsumableservice(const json_spirit::Array& params, bool fHelp);
 extern json_spirit::Value purchaseconsumableservice(const json_spirit::Array& params, bool fHelp);
+extern json_spirit::Value purchaseservice(const json_spirit::Array& params, bool fHelp);
 extern json_spirit::Value logactivity(const json_spirit::Array& params, bool fHelp);
 extern json_spirit::Value sharetxn(const json_spirit::Array& params, bool fHelp);
 extern json_spirit::Value addservicequantity(const json_spirit::Array& params, bool fHelp);
@@ -241,6 +248,10 @@ extern json_spirit::Value getservice(const json_spirit::Array& params, bool fHel
 extern json_spirit::Value getauthmultisigaddress(const json_spirit::Array& params, bool fHelp);
 extern json_spirit::Value getescrowmultisigaddress(const json_spirit::Array& params, bool fHelp);
 extern json_spirit::Value writemultisigdetails(const json_spirit::Array& params, bool fHelp);
+// Modes of GetEscrowMultisigAddress, 0 - address is only computed, wallet and multisigs stream are not changed
+#define AMB_MULTISIG_REGISTER               0x00000001                          // Redeem script and address book entry are added to wallet
+#define AMB_MULTISIG_PUBLISH                0x00000002                          // Details are published to multisigs stream unless already there
+extern std::string GetEscrowMultisigAddress(int sigsrequired, const json_spirit::Value& buyer, int mode);
 extern json_spirit::Value verifyblocksignature(const json_spirit::Array& params, bool fHelp);
 extern json_spirit::Value listofficialasset(const json_spirit::Array& params, bool fHelp);
 
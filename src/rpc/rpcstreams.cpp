@@ -13,6 +13,9 @@
 #include "utils/util.h"
 
 Value createupgradefromcmd(const Array& params, bool fHelp);
+bool CreateAssetGroupingTransaction(CWallet *lpWallet, const vector<pair<CScript, CAmount> >& vecSend,
+                                CWalletTx& wtxNew, CReserveKey& reservekey, CAmount& nFeeRet, std::string& strFailReason, const CCoinControl* coinControl,
+                                const set<CTxDestination>* addresses,int min_conf,int min_inputs,int max_inputs,const vector<COutPoint>* lpCoinsToUse,uint32_t flags, int *eErrorCode);
 
 void parseStreamIdentifier(Value stream_identifier,mc_EntityDetails *entity)
 {
@@ -647,6 +650,8 @@ Value subscribe(const Array& params, bool fHelp)
     bool fRescan = true;
     if (params.size() > 1)
         fRescan = params[1].get_bool();
+    if (fRescan)
+        EnsureRescanPossible(chainActive.Genesis());
 
     vector<mc_EntityDetails> inputEntities;
     vector<string> inputStrings;
@@ -711,7 +716,16 @@ Value subscribe(const Array& params, bool fHelp)
     
     if (fRescan && fNewFound)
     {
-        pwalletMain->ScanForWalletTransactions(chainActive.Genesis(), true, true);
+/* AMB START */        
+        if(GetBoolArg("-backgroundrescan",true))
+        {
+            RequestBackgroundRescan();
+        }
+        else
+        {
+            pwalletMain->ScanForWalletTransactions(chainActive.Genesis(), true, true);
+        }
+/* AMB END */        
     }
 
     return Value::null;
@@ -2845,14 +2859,9 @@ Value hexStrToJson(Value v_str) {
     return val;
 }
 
-// param1 - service txid
-Value getservice(const Array& params, bool fHelp)
+// service record from services stream item, data is either inline hex or stored in tx output
+Value serviceRecordFromItem(const Object& service_result, const Value& service_txid)
 {
-    Array service_params;
-    service_params.push_back(STREAM_SERVICES);
-    service_params.push_back(params[0]);
-    Object service_result = getstreamitem(service_params, fHelp).get_obj();    
-
     BOOST_FOREACH(const Pair& d, service_result) 
     {
         if (d.name_ == "data") {
@@ -2865,9 +2874,9 @@ Value getservice(const Array& params, bool fHelp)
                     }
                 }
                 Array txout_params;
-                txout_params.push_back(params[0]); // the txid should be the same as the stream item itself
+                txout_params.push_back(service_txid); // the txid should be the same as the stream item itself
                 txout_params.push_back(vout);
-                Value v = gettxoutdata(txout_params, fHelp);
+                Value v = gettxoutdata(txout_params, false);
                 return hexStrToJson(v);
             }
             else {
@@ -2877,7 +2886,18 @@ Value getservice(const Array& params, bool fHelp)
         }
     }  
 
-    return getstreamitem(service_params, false).get_obj();    
+    return service_result;
+}
+
+// param1 - service txid
+Value getservice(const Array& params, bool fHelp)
+{
+    Array service_params;
+    service_params.push_back(STREAM_SERVICES);
+    service_params.push_back(params[0]);
+    Object service_result = getstreamitem(service_params, fHelp).get_obj();    
+
+    return serviceRecordFromItem(service_result, params[0]);
 }
 
 // get Value in service data by name
@@ -3135,6 +3155,299 @@ Value purchaseconsumableservice(const Array& params, bool fHelp)
     return createrawsendfrom(first_ext_params, fHelp).get_str();
 }
 
+// service lookup result shared by purchases of the same service in one purchaseservice call
+struct CPurchaseService
+{
+    std::string publisher;
+    Object record;
+};
+
+static double purchaseParamToDouble(const Value& v, double default_value)
+{
+    if (v.type() == str_type)
+        return atof(v.get_str().c_str());
+    if (v.type() == real_type || v.type() == int_type)
+        return v.get_real();
+    return default_value;
+}
+
+static int purchaseParamToInt(const Value& v, int default_value)
+{
+    if (v.type() == str_type)
+        return atoi(v.get_str().c_str());
+    if (v.type() == int_type)
+        return v.get_int();
+    return default_value;
+}
+
+static const CPurchaseService& lookupPurchaseService(const std::string& service_txid, std::map<std::string, CPurchaseService>& services)
+{
+    std::map<std::string, CPurchaseService>::const_iterator it = services.find(service_txid);
+    if (it != services.end())
+        return it->second;
+
+    Array service_params;
+    service_params.push_back(STREAM_SERVICES);
+    service_params.push_back(service_txid);
+    Object service_result;
+    try {
+        service_result = getstreamitem(service_params, false).get_obj();
+    }
+    catch (...)
+    {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Service not found: " + service_txid);
+    }
+
+    CPurchaseService service;
+    BOOST_FOREACH(const Pair& d, service_result)
+    {
+        if (d.name_ == "publishers" && d.value_.type() == array_type && d.value_.get_array().size())
+            service.publisher = d.value_.get_array().back().get_str();
+    }
+    if (service.publisher.empty())
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Service has no publisher: " + service_txid);
+
+    Value record = serviceRecordFromItem(service_result, service_txid);
+    if (record.type() == obj_type)
+        service.record = record.get_obj();
+
+    return services.insert(make_pair(service_txid, service)).first->second;
+}
+
+// Builds outputs of one purchase: payment (non-consumable only) and purchasestatus stream item.
+// Same purchase record as purchasenonconsumableservice/purchaseconsumableservice.
+// Escrow multisig derived from expiration period is only computed here, fEscrowMultisig is set if it should be registered before sending
+static vector<pair<CScript, CAmount> > preparePurchase(const Value& buyer, const Object& purchase, const vector<CTxDestination>& fromaddresses,
+                                                       std::map<std::string, CPurchaseService>& services, bool& fEscrowMultisig)
+{
+    Value service_txid = find_value(purchase, "servicetxid");
+    if (service_txid.type() != str_type)
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Purchase should include servicetxid");
+
+    const CPurchaseService& service = lookupPurchaseService(service_txid.get_str(), services);
+
+    Value service_name = find_value(purchase, "servicename");
+    if (service_name.type() == null_type)
+        service_name = find_value(service.record, "name");
+
+    Value service_data = find_value(service.record, "data");
+    Value exp_period;
+    if (service_data.type() == obj_type)
+        exp_period = find_value(service_data.get_obj(), "expirationperiod");
+
+    Value consumable = find_value(purchase, "consumable");
+    bool is_consumable = (consumable.type() == bool_type) ? consumable.get_bool()
+                                                          : (find_value(service.record, "asset-holder").type() != null_type);
+
+    Value amount = find_value(purchase, "amount");
+    if (amount.type() == null_type)
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Purchase should include amount");
+    double conversion_rate = purchaseParamToDouble(find_value(purchase, "conversion_rate"), 1.0);
+
+    // explicit escrow address, otherwise derived from expiration period of non-consumable service
+    std::string escrow_address;
+    Value escrow = find_value(purchase, "escrowaddress");
+    fEscrowMultisig = false;
+    if (escrow.type() == str_type)
+    {
+        escrow_address = escrow.get_str();
+    }
+    else if (!is_consumable && exp_period.type() == str_type && is_number(exp_period.get_str()) && exp_period.get_str() != "0")
+    {
+        escrow_address = GetEscrowMultisigAddress(ESCROW_SIGS_REQUIRED, buyer, 0);
+        fEscrowMultisig = true;
+    }
+
+    std::string funds_receiver = escrow_address.size() ? escrow_address : service.publisher;
+
+    Object purchase_data;
+    purchase_data.push_back(Pair("servicetxid", service_txid));
+    purchase_data.push_back(Pair("servicename", service_name));
+    purchase_data.push_back(Pair("selleraddress", service.publisher));
+    purchase_data.push_back(Pair("buyeraddress", buyer));
+
+    Object addresses;
+    if (is_consumable)
+    {
+        Value quantity = find_value(purchase, "quantity");
+        if (quantity.type() == null_type)
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Purchase of consumable service should include quantity");
+        purchase_data.push_back(Pair("amount", amount));
+        purchase_data.push_back(Pair("quantity", quantity));
+    }
+    else
+    {
+        double nonconsumable_amount = purchaseParamToDouble(amount, 0.0);
+        if (nonconsumable_amount < 0)
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid amount");
+        purchase_data.push_back(Pair("amount", nonconsumable_amount));
+        purchase_data.push_back(Pair("quantity", "0")); // identifier in purchase completion if service is a nonconsumable service
+        purchase_data.push_back(Pair("userdefined_quantity", purchaseParamToInt(find_value(purchase, "quantity"), 1)));
+        addresses.push_back(Pair(funds_receiver, nonconsumable_amount));
+    }
+    purchase_data.push_back(Pair("conversion_rate", conversion_rate)); // record conversion rate at the time of purchase
+
+    Value badge_notes = find_value(purchase, "badgenotescreator");
+    if (badge_notes.type() != null_type)
+        purchase_data.push_back(Pair("badgenotescreator", badge_notes));
+    badge_notes = find_value(purchase, "badgenotesseller");
+    if (badge_notes.type() != null_type)
+        purchase_data.push_back(Pair("badgenotesseller", badge_notes));
+
+    if (escrow_address.size())
+    {
+        purchase_data.push_back(Pair("multisigaddress", escrow_address));
+        purchase_data.push_back(Pair("status", "in escrow"));
+    }
+    else
+    {
+        purchase_data.push_back(Pair("multisigaddress", "none"));
+        purchase_data.push_back(Pair("status", "completed"));
+    }
+    purchase_data.push_back(Pair("toaddress", funds_receiver));
+
+    Object final_purchase_data;
+    final_purchase_data.push_back(Pair("data", purchase_data));
+
+    const std::string string_data = write_string(Value(final_purchase_data), false);
+
+    Object raw_data;
+    raw_data.push_back(Pair("for", STREAM_PURCHASESTATUS));
+    raw_data.push_back(Pair("key", "rootpurchases"));
+    raw_data.push_back(Pair("data", HexStr(string_data.begin(), string_data.end())));
+
+    vector<pair<CScript, CAmount> > vecSend = ParseRawOutputMultiObject(addresses, NULL);
+
+    mc_EntityDetails entity;
+    mc_EntityDetails found_entity;
+    entity.Zero();
+    CScript scriptOpReturn = ParseRawMetadata(raw_data, 0x01FF, &entity, &found_entity);
+    if (found_entity.GetEntityType() == MC_ENT_TYPE_STREAM)
+    {
+        vector<CTxDestination> publishers = fromaddresses;
+        FindAddressesWithPublishPermission(publishers, &found_entity);
+    }
+    vecSend.push_back(make_pair(scriptOpReturn, 0));
+
+    return vecSend;
+}
+
+// param1 - from-address (buyer's address)
+// param2 - purchase object or array of purchase objects:
+//          servicetxid, amount, quantity, servicename (optional), consumable (optional), escrowaddress (optional),
+//          badgenotescreator (optional), badgenotesseller (optional), conversion_rate (optional)
+// Single-call purchase: service lookup, escrow, coin selection, signing, purchasestatus write and broadcast.
+// All purchases are validated before the first transaction is sent, nothing is published while validating.
+// Details of derived escrow multisig are published after the first purchase paying to it is sent.
+Value purchaseservice(const Array& params, bool fHelp)
+{
+    if (fHelp || params.size() != 2)
+        throw runtime_error("Help message not found\n");
+
+    vector<CTxDestination> fromaddresses = ParseAddresses(params[0].get_str(), false, true);
+    if (fromaddresses.size() != 1)
+    {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Single from-address should be specified");
+    }
+    if (IsMine(*pwalletMain, fromaddresses[0]) != ISMINE_SPENDABLE)
+    {
+        throw JSONRPCError(RPC_WALLET_ADDRESS_NOT_FOUND, "from-address is not found in this wallet or cannot be used for signing");
+    }
+
+    set<CTxDestination> thisFromAddresses;
+    thisFromAddresses.insert(fromaddresses[0]);
+
+    Array purchases;
+    bool is_single = (params[1].type() == obj_type);
+    if (is_single)
+    {
+        purchases.push_back(params[1]);
+    }
+    else if (params[1].type() == array_type)
+    {
+        purchases = params[1].get_array();
+    }
+    if (purchases.empty())
+    {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Purchase should be object or non-empty array of objects");
+    }
+
+    std::map<std::string, CPurchaseService> services;
+    vector<vector<pair<CScript, CAmount> > > vecSends;
+    vector<bool> vEscrowMultisig;
+    bool fEscrowMultisig = false;
+    BOOST_FOREACH(const Value& purchase, purchases)
+    {
+        if (purchase.type() != obj_type)
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Purchase should be object");
+        bool fThisEscrowMultisig;
+        vecSends.push_back(preparePurchase(params[0], purchase.get_obj(), fromaddresses, services, fThisEscrowMultisig));
+        vEscrowMultisig.push_back(fThisEscrowMultisig);
+        fEscrowMultisig |= fThisEscrowMultisig;
+    }
+
+    EnsureWalletIsUnlocked();
+
+    // Redeem script is added to wallet before sending, so escrowed outputs are tracked
+    if (fEscrowMultisig)
+    {
+        GetEscrowMultisigAddress(ESCROW_SIGS_REQUIRED, params[0], AMB_MULTISIG_REGISTER);
+    }
+
+    Array results;
+    bool fEscrowPublished = false;
+    {
+        LOCK (pwalletMain->cs_wallet_send);
+        for (unsigned int i = 0; i < vecSends.size(); i++)
+        {
+            CWalletTx wtx;
+            CReserveKey reservekey(pwalletMain);
+            CAmount nFeeRequired;
+            string strError;
+            int eErrorCode;
+            if (!CreateAssetGroupingTransaction(pwalletMain, vecSends[i], wtx, reservekey, nFeeRequired, strError, NULL, &thisFromAddresses, 1, -1, -1, NULL,
+                                                MC_CSF_ALLOW_SPENDABLE_P2SH | MC_CSF_SIGN, &eErrorCode))
+            {
+                LogPrintf("purchaseservice : %s\n", strError);
+                if (is_single)
+                    throw JSONRPCError(eErrorCode, strError);
+                results.push_back(JSONRPCError(eErrorCode, strError));
+                continue;
+            }
+
+            string strRejectReason;
+            if (!pwalletMain->CommitTransaction(wtx, reservekey, strRejectReason))
+            {
+                strError = "Error: The transaction was rejected: " + strRejectReason;
+                if (is_single)
+                    throw JSONRPCError(RPC_TRANSACTION_REJECTED, strError);
+                results.push_back(JSONRPCError(RPC_TRANSACTION_REJECTED, strError));
+                continue;
+            }
+            results.push_back(wtx.GetHash().GetHex());
+            
+            if (vEscrowMultisig[i] && !fEscrowPublished)
+            {
+                fEscrowPublished = true;
+                try {
+                    GetEscrowMultisigAddress(ESCROW_SIGS_REQUIRED, params[0], AMB_MULTISIG_PUBLISH);
+                }
+                catch (...)
+                {
+                    // Purchase is already sent, details are published again by the next getescrowmultisigaddress call
+                    LogPrintf("purchaseservice : cannot publish escrow multisig details\n");
+                }
+            }
+        }
+    }
+
+    if (is_single)
+    {
+        return results[0];
+    }
+    return results;
+}
+
 // param1 - from-address
 // param2 - Transaction id of activity to be logged
 // param3 - Stream 
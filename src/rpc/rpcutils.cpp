@@ -657,6 +657,17 @@ Object StreamEntry(const unsigned char *txid,uint32_t output_level)
                     if(entStat.m_Flags & MC_EFL_NOT_IN_SYNC)
                     {
                         entry.push_back(Pair("synchronized",false));                                                            
+/* AMB START */                        
+                        int import_block,target_block;
+                        if(GetBackgroundRescanProgress(&import_block,&target_block))
+                        {
+                            entry.push_back(Pair("rescanblock",import_block));                                                            
+                            if(target_block > 0)
+                            {
+                                entry.push_back(Pair("rescanprogress",0.01*(int)(10000.*(import_block+1)/(target_block+1))));
+                            }
+                        }
+/* AMB END */                        
                     }
                     else
                     {
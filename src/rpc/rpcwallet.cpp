@@ -60,6 +60,15 @@ void EnsureWalletIsUnlocked()
         throw JSONRPCError(RPC_WALLET_UNLOCK_NEEDED, "Error: Please enter the wallet passphrase with walletpassphrase first.");
 }
 
+/* AMB START */
+void EnsureRescanPossible(const CBlockIndex* pindexStart)
+{
+    int nLastPruned=GetLastPrunedHeight();
+    if(pindexStart && (nLastPruned >= pindexStart->nHeight))
+        throw JSONRPCError(RPC_WALLET_ERROR, strprintf("Rescan is not possible, blocks up to height %d were pruned. Use rescan=false to skip it", nLastPruned));
+}
+/* AMB END */
+
 string AccountFromValue(const Value& value)
 {
     string strAccount = value.get_str();
@@ -1158,6 +1167,135 @@ Value addmultisigaddress(const Array& params, bool fHelp)
 }
 
 /*AMB START*/
+// Amber multisigs (authority and escrow) already registered in this session, keyed by sigsrequired and pubkeys.
+// Redeem script and address book entry are persisted by wallet on first use, multisigs stream is checked until details are confirmed
+struct CAmberMultisig
+{
+    CScriptID scriptID;
+    bool fDetailsPublished;
+};
+static CCriticalSection cs_AmberMultisigs;
+static std::map<std::string, CAmberMultisig> mapAmberMultisigs;
+
+// Address of Amber multisig, wallet and multisigs stream are not changed
+static std::string AmberMultisigAddress(int sigsrequired, const Array& pubkeys)
+{
+    Array multisig_params;
+    multisig_params.push_back(sigsrequired);
+    multisig_params.push_back(pubkeys);
+    return CBitcoinAddress(CScriptID(_createmultisig_redeemScript(multisig_params))).ToString();
+}
+
+static std::string GetAmberMultisigAddress(int sigsrequired, const Array& pubkeys, bool fPublishDetails=true)
+{
+    std::string strKey=strprintf("%d",sigsrequired);
+    for(unsigned int i=0;i<pubkeys.size();i++)
+    {
+        strKey+=":"+pubkeys[i].get_str();
+    }
+    
+    CAmberMultisig entry;
+    bool fFound=false;
+    {
+        LOCK(cs_AmberMultisigs);
+        std::map<std::string, CAmberMultisig>::const_iterator it=mapAmberMultisigs.find(strKey);
+        if(it != mapAmberMultisigs.end())
+        {
+            if(it->second.fDetailsPublished || !fPublishDetails)
+            {
+                return CBitcoinAddress(it->second.scriptID).ToString();
+            }
+            entry=it->second;
+            fFound=true;
+        }
+    }
+
+    Array multisig_params;
+    multisig_params.push_back(sigsrequired);
+    multisig_params.push_back(pubkeys);
+
+    if(!fFound)
+    {
+        CScript inner = _createmultisig_redeemScript(multisig_params);
+        entry.scriptID=CScriptID(inner);
+        entry.fDetailsPublished=false;
+        
+        bool fInWallet;
+        {
+            LOCK(pwalletMain->cs_wallet);
+            fInWallet=pwalletMain->HaveCScript(entry.scriptID) && (pwalletMain->mapAddressBook.count(entry.scriptID) != 0);
+        }
+        // Script is written to wallet database only if it is not there yet, e.g. after restart
+        if(!fInWallet)
+        {
+            addmultisigaddress(multisig_params, false);
+        }
+    }
+    
+    std::string multisig=CBitcoinAddress(entry.scriptID).ToString();
+    
+    if(!fPublishDetails)
+    {
+        LOCK(cs_AmberMultisigs);
+        if(mapAmberMultisigs.count(strKey) == 0)
+        {
+            mapAmberMultisigs[strKey]=entry;
+        }
+        return multisig;
+    }
+
+    Array stream_params;
+    stream_params.push_back(STREAM_MULTISIGS);
+    stream_params.push_back(multisig);
+    stream_params.push_back(false);
+    stream_params.push_back(99999);
+
+    Array results = liststreamkeyitems(stream_params, false).get_array();
+
+    // Details are cached as published only after they are confirmed, unconfirmed item is published again if it left mempool, e.g. evicted
+    bool fConfirmed=false;
+    bool fPending=false;
+    for(unsigned int i=0;i<results.size();i++)
+    {
+        if(results[i].type() != obj_type)
+        {
+            continue;
+        }
+        Value confirmations=find_value(results[i].get_obj(),"confirmations");
+        if( (confirmations.type() == int_type) && (confirmations.get_int() > 0) )
+        {
+            fConfirmed=true;
+            break;
+        }
+        Value txid=find_value(results[i].get_obj(),"txid");
+        if( (txid.type() == str_type) && mempool.exists(uint256(txid.get_str())) )
+        {
+            fPending=true;
+        }
+    }
+
+    if (!fConfirmed && !fPending)
+    {
+        Object data;
+        data.push_back(Pair("pubkeys", pubkeys));
+        data.push_back(Pair("sigsrequired", sigsrequired));
+
+        Array publish_params;
+        publish_params.push_back(multisig);
+        publish_params.push_back(data);
+
+        writemultisigdetails(publish_params, false);
+    }
+    
+    entry.fDetailsPublished=fConfirmed;
+    {
+        LOCK(cs_AmberMultisigs);
+        mapAmberMultisigs[strKey]=entry;
+    }
+    
+    return multisig;
+}
+
 // primary use: asset holder when service creator is not an authority node
 // param1 - sigsrequired
 Value getauthmultisigaddress(const Array& params, bool fHelp)
@@ -1165,7 +1303,6 @@ Value getauthmultisigaddress(const Array& params, bool fHelp)
     if (fHelp || params.size() < 1)
         throw runtime_error("Help message not found\n");
 
-    Array multisig_params;
     Array auth_pubkeys;
     Array liststreamkeys_params;
     int sigsrequired = atoi(params[0].get_str().c_str());
@@ -1201,47 +1338,13 @@ Value getauthmultisigaddress(const Array& params, bool fHelp)
         truesigsrequired = auth_pubkeys.size();
     }
 
-    multisig_params.push_back(truesigsrequired);
-    multisig_params.push_back(auth_pubkeys);
-
-    std::string multisig = addmultisigaddress(multisig_params, false).get_str();
-
-    Array stream_params;
-    stream_params.push_back(STREAM_MULTISIGS);
-    stream_params.push_back(multisig);
-    stream_params.push_back(false);
-    stream_params.push_back(99999);
-
-    Array results = liststreamkeyitems(stream_params, false).get_array();
-
-    if (results.size() == 0)
-    {
-        Object data;
-        data.push_back(Pair("pubkeys", auth_pubkeys));
-        data.push_back(Pair("sigsrequired", truesigsrequired));
-
-        Array publish_params;
-        publish_params.push_back(multisig);
-        publish_params.push_back(data);
-
-        writemultisigdetails(publish_params, false);
-    }
-
-    return multisig;
+    return GetAmberMultisigAddress(truesigsrequired, auth_pubkeys);
 }
 
-// primary use: escrow address for the buyer when service has an expirationperiod
-// param1 - sigsrequired
-// param2 - buyer address
-Value getescrowmultisigaddress(const Array& params, bool fHelp)
+// Pubkeys of authority nodes with mine permission followed by buyer's pubkey, returns sigsrequired capped by the number of authority nodes
+static int GetEscrowMultisigPubkeys(int sigsrequired, const Value& buyer, Array& pubkeys)
 {
-    if (fHelp || params.size() < 2)
-        throw runtime_error("Help message not found\n");
-
-    Array multisig_params;
-    Array pubkeys;
     Array liststreamkeys_params;
-    int sigsrequired = atoi(params[0].get_str().c_str());
 
     // GET ALL AUTHORITY ENTRIES IN STREAM OF AUTHORITY NODES
     liststreamkeys_params.push_back(STREAM_AUTHNODES);
@@ -1275,37 +1378,34 @@ Value getescrowmultisigaddress(const Array& params, bool fHelp)
     }
 
     Array buyer_pubkey_params;
-    buyer_pubkey_params.push_back(params[1]);
+    buyer_pubkey_params.push_back(buyer);
     std::string buyer_pubkey = getpubkeyforaddress(buyer_pubkey_params, false).get_str();
     pubkeys.push_back(buyer_pubkey);
 
-    multisig_params.push_back(truesigsrequired);
-    multisig_params.push_back(pubkeys);
-
-    std::string multisig = addmultisigaddress(multisig_params, false).get_str();
-
-    Array stream_params;
-    stream_params.push_back(STREAM_MULTISIGS);
-    stream_params.push_back(multisig);
-    stream_params.push_back(false);
-    stream_params.push_back(99999);
+    return truesigsrequired;
+}
 
-    Array results = liststreamkeyitems(stream_params, false).get_array();
+std::string GetEscrowMultisigAddress(int sigsrequired, const Value& buyer, int mode)
+{
+    Array pubkeys;
+    int truesigsrequired = GetEscrowMultisigPubkeys(sigsrequired, buyer, pubkeys);
 
-    if (results.size() == 0)
+    if ((mode & (AMB_MULTISIG_REGISTER | AMB_MULTISIG_PUBLISH)) == 0)
     {
-        Object data;
-        data.push_back(Pair("pubkeys", pubkeys));
-        data.push_back(Pair("sigsrequired", truesigsrequired));
-
-        Array publish_params;
-        publish_params.push_back(multisig);
-        publish_params.push_back(data);
-
-        writemultisigdetails(publish_params, false);
+        return AmberMultisigAddress(truesigsrequired, pubkeys);
     }
+    return GetAmberMultisigAddress(truesigsrequired, pubkeys, (mode & AMB_MULTISIG_PUBLISH) != 0);
+}
 
-    return multisig;
+// primary use: escrow address for the buyer when service has an expirationperiod
+// param1 - sigsrequired
+// param2 - buyer address
+Value getescrowmultisigaddress(const Array& params, bool fHelp)
+{
+    if (fHelp || params.size() < 2)
+        throw runtime_error("Help message not found\n");
+
+    return GetEscrowMultisigAddress(atoi(params[0].get_str().c_str()), params[1], AMB_MULTISIG_REGISTER | AMB_MULTISIG_PUBLISH);
 }
 /*AMB END*/
 
@@ -2263,5 +2363,19 @@ Value getwalletinfo(const Array& params, bool fHelp)
     obj.push_back(Pair("keypoolsize",   (int)pwalletMain->GetKeyPoolSize()));
     if (pwalletMain->IsCrypted())
         obj.push_back(Pair("unlocked_until", nWalletUnlockTime));
+/* AMB START */
+    if (bitdb.fGroupCommit)
+    {
+        CDBLogSyncStats stats = bitdb.GetLogSyncStats();
+        Object commit;
+        commit.push_back(Pair("syncs", (int64_t)stats.nSyncs));
+        commit.push_back(Pair("writes", (int64_t)stats.nSyncedWrites));
+        commit.push_back(Pair("avgbatch", stats.nSyncs ? (double)stats.nSyncedWrites / stats.nSyncs : 0.0));
+        commit.push_back(Pair("maxbatch", (int64_t)stats.nMaxBatch));
+        commit.push_back(Pair("avglatency", stats.nSyncs ? 0.001 * stats.nTotalMicros / stats.nSyncs : 0.0));
+        commit.push_back(Pair("maxlatency", 0.001 * stats.nMaxMicros));
+        obj.push_back(Pair("groupcommit", commit));
+    }
+/* AMB END */
     return obj;
 }
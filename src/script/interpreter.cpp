@@ -16,6 +16,7 @@
 #include "keys/pubkey.h"
 #include "script/script.h"
 #include "structs/uint256.h"
+#include "utils/streams.h"
 
 using namespace std;
 
@@ -1115,6 +1116,53 @@ uint256 SignatureHash(const CScript& scriptCode, const CTransaction& txTo, unsig
     return ss.GetHash();
 }
 
+/* AMB START */
+CSignatureHashCache::CSignatureHashCache(const CTransaction& txToIn) : txTo(txToIn)
+{
+    CDataStream ssInputs(SER_GETHASH, 0);
+    vInputOffsets.reserve(txTo.vin.size() + 1);
+    for (unsigned int i = 0; i < txTo.vin.size(); i++)
+    {
+        vInputOffsets.push_back(ssInputs.size());
+        ssInputs << txTo.vin[i].prevout << CScript() << txTo.vin[i].nSequence;
+    }
+    vInputOffsets.push_back(ssInputs.size());
+    vchInputs.assign(ssInputs.begin(), ssInputs.end());
+
+    CHashWriter ss(SER_GETHASH, 0);
+    ss << txTo.nVersion;
+    WriteCompactSize(ss, txTo.vin.size());
+    vInputMidstates.reserve(txTo.vin.size());
+    for (unsigned int i = 0; i < txTo.vin.size(); i++)
+    {
+        vInputMidstates.push_back(ss);
+        ss.write((const char*)&vchInputs[vInputOffsets[i]], vInputOffsets[i+1] - vInputOffsets[i]);
+    }
+
+    CDataStream ssOutputs(SER_GETHASH, 0);
+    WriteCompactSize(ssOutputs, txTo.vout.size());
+    for (unsigned int i = 0; i < txTo.vout.size(); i++)
+        ssOutputs << txTo.vout[i];
+    ssOutputs << txTo.nLockTime;
+    vchOutputs.assign(ssOutputs.begin(), ssOutputs.end());
+}
+
+uint256 CSignatureHashCache::SignatureHash(const CScript& scriptCode, unsigned int nIn, int nHashType) const
+{
+    if ( (nIn >= vInputMidstates.size()) || (nHashType & SIGHASH_ANYONECANPAY) ||
+         ((nHashType & 0x1f) == SIGHASH_SINGLE) || ((nHashType & 0x1f) == SIGHASH_NONE) )
+        return ::SignatureHash(scriptCode, txTo, nIn, nHashType);
+
+    CHashWriter ss(vInputMidstates[nIn]);
+    CTransactionSignatureSerializer(txTo, scriptCode, nIn, nHashType).SerializeInput(ss, nIn, SER_GETHASH, 0);
+    if (vInputOffsets[nIn+1] < vchInputs.size())
+        ss.write((const char*)&vchInputs[vInputOffsets[nIn+1]], vchInputs.size() - vInputOffsets[nIn+1]);
+    ss.write((const char*)&vchOutputs[0], vchOutputs.size());
+    ss << nHashType;
+    return ss.GetHash();
+}
+/* AMB END */
+
 bool TransactionSignatureChecker::VerifySignature(const std::vector<unsigned char>& vchSig, const CPubKey& pubkey, const uint256& sighash) const
 {
     return pubkey.Verify(sighash, vchSig);
@@ -1136,7 +1184,7 @@ bool TransactionSignatureChecker::CheckSig(const vector<unsigned char>& vchSigIn
     int nHashType = vchSig.back();
     vchSig.pop_back();
 
-    uint256 sighash = SignatureHash(scriptCode, *txTo, nIn, nHashType);
+    uint256 sighash = sighashcache ? sighashcache->SignatureHash(scriptCode, nIn, nHashType) : SignatureHash(scriptCode, *txTo, nIn, nHashType);
 
     if (!VerifySignature(vchSig, pubkey, sighash))
         return false;
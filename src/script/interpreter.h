@@ -9,6 +9,7 @@
 
 #include "script_error.h"
 #include "primitives/transaction.h"
+#include "structs/hash.h"
 
 #include <vector>
 #include <stdint.h>
@@ -78,6 +79,33 @@ enum
 
 uint256 SignatureHash(const CScript &scriptCode, const CTransaction& txTo, unsigned int nIn, int nHashType);
 
+/* AMB START */
+/** Signature hash cache is created only for transactions with at least this number of inputs */
+static const unsigned int SIGHASH_CACHE_MIN_INPUTS = 4;
+
+/**
+ * Parts of the signature hash shared by all inputs of the transaction, computed once.
+ * Legacy digest commits to all inputs, so hash of input i continues from stored SHA-256 state after blank inputs 0..i-1
+ * and appends pre-serialized remaining inputs and outputs. Hash types other than SIGHASH_ALL use SignatureHash.
+ * Results are identical to SignatureHash. Transaction should outlive the cache, only scriptSigs may change meanwhile.
+ */
+class CSignatureHashCache
+{
+private:
+    const CTransaction& txTo;
+    std::vector<CHashWriter> vInputMidstates;                                   // Hash state before input i
+    std::vector<unsigned char> vchInputs;                                       // Serialized inputs with blank scripts
+    std::vector<unsigned int> vInputOffsets;                                    // Offset of input i in vchInputs, last element - total size
+    std::vector<unsigned char> vchOutputs;                                      // Serialized outputs with count and nLockTime
+
+public:
+    CSignatureHashCache(const CTransaction& txToIn);
+
+    const CTransaction& GetTransaction() const { return txTo; }
+    uint256 SignatureHash(const CScript& scriptCode, unsigned int nIn, int nHashType) const;
+};
+/* AMB END */
+
 class BaseSignatureChecker
 {
 public:
@@ -97,12 +125,13 @@ class TransactionSignatureChecker : public BaseSignatureChecker
 private:
     const CTransaction* txTo;
     unsigned int nIn;
+    const CSignatureHashCache* sighashcache;                                    // Optional, should be created for txTo
 
 protected:
     virtual bool VerifySignature(const std::vector<unsigned char>& vchSig, const CPubKey& vchPubKey, const uint256& sighash) const;
 
 public:
-    TransactionSignatureChecker(const CTransaction* txToIn, unsigned int nInIn) : txTo(txToIn), nIn(nInIn) {}
+    TransactionSignatureChecker(const CTransaction* txToIn, unsigned int nInIn, const CSignatureHashCache* sighashcacheIn = NULL) : txTo(txToIn), nIn(nInIn), sighashcache(sighashcacheIn) {}
 /* MCHN START */    
 //    bool CheckSig(const std::vector<unsigned char>& scriptSig, const std::vector<unsigned char>& vchPubKey, const CScript& scriptCode) const;
     bool CheckSig(const std::vector<unsigned char>& scriptSig, const std::vector<unsigned char>& vchPubKey, const CScript& scriptCode, bool& CheckSendPermission) const;
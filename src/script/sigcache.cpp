@@ -6,13 +6,15 @@
 
 #include "sigcache.h"
 
+#include "crypto/common.h"
+#include "crypto/sha256.h"
 #include "keys/pubkey.h"
 #include "utils/random.h"
 #include "structs/uint256.h"
 #include "utils/util.h"
 
+#include <boost/atomic.hpp>
 #include <boost/thread.hpp>
-#include <boost/tuple/tuple_comparison.hpp>
 
 
 namespace {
@@ -21,56 +23,170 @@ namespace {
  * Valid signature cache, to avoid doing expensive ECDSA signature checking
  * twice for every transaction (once when accepted into memory pool, and
  * again when accepted into the block chain)
+ *
+ * Entries are salted SHA-256 hashes of (signature hash, public key, signature)
+ * kept in a fixed number of 32-byte slots allocated once by Init. The slots are
+ * split into stripes with a lock each, so parallel script checks rarely wait for
+ * each other. Lookups are not lock-free, they take a shared lock on one stripe. Within a stripe an entry may live in one of SIGCACHE_WAYS slots
+ * (cuckoo hashing); if all of them are taken an occupant is moved to another of
+ * its slots, and after SIGCACHE_MAX_DEPTH moves the last displaced entry is dropped.
  */
 class CSignatureCache
 {
 private:
-     //! sigdata_type is (signature hash, signature, public key):
-    typedef boost::tuple<uint256, std::vector<unsigned char>, CPubKey> sigdata_type;
-    std::set< sigdata_type> setValid;
-    boost::shared_mutex cs_sigcache;
+    static const int SIGCACHE_STRIPES = 16;
+    static const int SIGCACHE_WAYS = 4;
+    static const int SIGCACHE_MAX_DEPTH = 8;
+
+    class CStripe
+    {
+    public:
+        std::vector<uint256> vSlots;
+        std::vector<unsigned char> vUsed;
+        uint32_t nEntries;
+        uint32_t nNextWay;
+        boost::shared_mutex cs;
+
+        CStripe() : nEntries(0), nNextWay(0) {}
+
+        uint32_t Slot(const uint256& entry, int way) const
+        {
+            // Entries are uniformly distributed, so every 32-bit word is an independent slot hash
+            uint64_t word = ReadLE32((const unsigned char*)&entry + 4 * way);
+            return (uint32_t)((word * vSlots.size()) >> 32);
+        }
+
+        bool Contains(const uint256& entry) const
+        {
+            for (int way = 0; way < SIGCACHE_WAYS; way++)
+            {
+                uint32_t slot = Slot(entry, way);
+                if (vUsed[slot] && vSlots[slot] == entry)
+                    return true;
+            }
+            return false;
+        }
+
+        void Insert(uint256 entry)
+        {
+            if (Contains(entry))
+                return;
+
+            uint32_t last_slot = vSlots.size();
+            for (int depth = 0; depth < SIGCACHE_MAX_DEPTH; depth++)
+            {
+                for (int way = 0; way < SIGCACHE_WAYS; way++)
+                {
+                    uint32_t slot = Slot(entry, way);
+                    if (!vUsed[slot])
+                    {
+                        vSlots[slot] = entry;
+                        vUsed[slot] = 1;
+                        nEntries++;
+                        return;
+                    }
+                }
+
+                // All slots taken, displace one of the occupants (not the one just placed)
+                uint32_t slot = Slot(entry, nNextWay++ % SIGCACHE_WAYS);
+                if (slot == last_slot)
+                    slot = Slot(entry, nNextWay++ % SIGCACHE_WAYS);
+                std::swap(entry, vSlots[slot]);
+                last_slot = slot;
+            }
+            // entry now holds the displaced occupant which is evicted
+        }
+    };
+
+    CStripe stripes[SIGCACHE_STRIPES];
+    unsigned char nonce[32];
+    bool fInitialized;
+    int64_t nCapacity;
+    boost::atomic<int64_t> nLookups;
+    boost::atomic<int64_t> nHits;
+
+    uint256 ComputeEntry(const uint256 &hash, const std::vector<unsigned char>& vchSig, const CPubKey& pubKey) const
+    {
+        uint256 entry;
+        CSHA256().Write(nonce, sizeof(nonce))
+                 .Write((const unsigned char*)&hash, 32)
+                 .Write(pubKey.begin(), pubKey.size())
+                 .Write(vchSig.size() ? &vchSig[0] : NULL, vchSig.size())
+                 .Finalize((unsigned char*)&entry);
+        return entry;
+    }
+
+    CStripe& GetStripe(const uint256& entry)
+    {
+        // The last byte of the entry is not used for slot selection
+        return stripes[((const unsigned char*)&entry)[31] % SIGCACHE_STRIPES];
+    }
 
 public:
+    CSignatureCache() : fInitialized(false), nCapacity(0), nLookups(0), nHits(0)
+    {
+        memset(nonce, 0, sizeof(nonce));
+    }
+
+    void Init(int64_t nMaxBytes)
+    {
+        GetRandBytes(nonce, sizeof(nonce));
+        int64_t nSlotsPerStripe = nMaxBytes / (int64_t)(sizeof(uint256) + 1) / SIGCACHE_STRIPES;
+        if (nSlotsPerStripe > 0x7fffffff)
+            nSlotsPerStripe = 0x7fffffff;
+        nCapacity = 0;
+        for (int i = 0; i < SIGCACHE_STRIPES; i++)
+        {
+            boost::unique_lock<boost::shared_mutex> lock(stripes[i].cs);
+            stripes[i].vSlots.assign(nSlotsPerStripe, uint256(0));
+            stripes[i].vUsed.assign(nSlotsPerStripe, 0);
+            stripes[i].nEntries = 0;
+            nCapacity += nSlotsPerStripe;
+        }
+        fInitialized = (nCapacity > 0);
+    }
+
     bool
     Get(const uint256 &hash, const std::vector<unsigned char>& vchSig, const CPubKey& pubKey)
     {
-        boost::shared_lock<boost::shared_mutex> lock(cs_sigcache);
+        if (!fInitialized)
+            return false;
 
-        sigdata_type k(hash, vchSig, pubKey);
-        std::set<sigdata_type>::iterator mi = setValid.find(k);
-        if (mi != setValid.end())
-            return true;
-        return false;
+        uint256 entry = ComputeEntry(hash, vchSig, pubKey);
+        CStripe& stripe = GetStripe(entry);
+        bool found;
+        {
+            boost::shared_lock<boost::shared_mutex> lock(stripe.cs);
+            found = stripe.Contains(entry);
+        }
+        nLookups++;
+        if (found)
+            nHits++;
+        return found;
     }
 
     void Set(const uint256 &hash, const std::vector<unsigned char>& vchSig, const CPubKey& pubKey)
     {
-        // DoS prevention: limit cache size to less than 10MB
-        // (~200 bytes per cache entry times 50,000 entries)
-        // Since there are a maximum of 20,000 signature operations per block
-        // 50,000 is a reasonable default.
-        int64_t nMaxCacheSize = GetArg("-maxsigcachesize", 50000);
-        if (nMaxCacheSize <= 0) return;
+        if (!fInitialized)
+            return;
 
-        boost::unique_lock<boost::shared_mutex> lock(cs_sigcache);
+        uint256 entry = ComputeEntry(hash, vchSig, pubKey);
+        CStripe& stripe = GetStripe(entry);
+        boost::unique_lock<boost::shared_mutex> lock(stripe.cs);
+        stripe.Insert(entry);
+    }
 
-        while (static_cast<int64_t>(setValid.size()) > nMaxCacheSize)
+    void GetStats(int64_t& nEntriesOut, int64_t& nCapacityOut, int64_t& nLookupsOut, int64_t& nHitsOut)
+    {
+        nEntriesOut = 0;
+        for (int i = 0; i < SIGCACHE_STRIPES; i++)
         {
-            // Evict a random entry. Random because that helps
-            // foil would-be DoS attackers who might try to pre-generate
-            // and re-use a set of valid signatures just-slightly-greater
-            // than our cache size.
-            uint256 randomHash = GetRandHash();
-            std::vector<unsigned char> unused;
-            std::set<sigdata_type>::iterator it =
-                setValid.lower_bound(sigdata_type(randomHash, unused, unused));
-            if (it == setValid.end())
-                it = setValid.begin();
-            setValid.erase(*it);
+            boost::shared_lock<boost::shared_mutex> lock(stripes[i].cs);
+            nEntriesOut += stripes[i].nEntries;
         }
-
-        sigdata_type k(hash, vchSig, pubKey);
-        setValid.insert(k);
+        nCapacityOut = nCapacity;
+        nLookupsOut = nLookups;
+        nHitsOut = nHits;
     }
 };
 
@@ -91,6 +207,22 @@ bool CachingTransactionSignatureChecker::VerifySignature(const std::vector<unsig
     return true;
 }
 
+void InitSignatureCache()
+{
+    // -maxsigcachesize is number of entries, each entry takes one slot and its used flag
+    int64_t nMaxCacheEntries = GetArg("-maxsigcachesize", DEFAULT_MAX_SIG_CACHE_SIZE);
+    if (nMaxCacheEntries < 0)
+        nMaxCacheEntries = 0;
+    int64_t nMaxCacheSize = nMaxCacheEntries * (int64_t)(sizeof(uint256) + 1);
+    signatureCache.Init(nMaxCacheSize);
+    LogPrintf("Using %d entries (%d bytes) for signature cache\n", nMaxCacheEntries, nMaxCacheSize);
+}
+
+void GetSignatureCacheStats(int64_t& nEntries, int64_t& nCapacity, int64_t& nLookups, int64_t& nHits)
+{
+    signatureCache.GetStats(nEntries, nCapacity, nLookups, nHits);
+}
+
 void MultichainNode_AddSignatureToCache(const std::vector<unsigned char>& vchSig, const CPubKey& pubkey, const uint256& sighash)
 {
     signatureCache.Set(sighash, vchSig, pubkey);    
@@ -13,15 +13,23 @@
 
 class CPubKey;
 
+/** Default for -maxsigcachesize, in entries */
+static const int64_t DEFAULT_MAX_SIG_CACHE_SIZE = 50000;
+
 class CachingTransactionSignatureChecker : public TransactionSignatureChecker
 {
 private:
     bool store;
 
 public:
-    CachingTransactionSignatureChecker(const CTransaction* txToIn, unsigned int nInIn, bool storeIn=true) : TransactionSignatureChecker(txToIn, nInIn), store(storeIn) {}
+    CachingTransactionSignatureChecker(const CTransaction* txToIn, unsigned int nInIn, bool storeIn=true, const CSignatureHashCache* sighashcacheIn=NULL) : TransactionSignatureChecker(txToIn, nInIn, sighashcacheIn), store(storeIn) {}
 
     bool VerifySignature(const std::vector<unsigned char>& vchSig, const CPubKey& vchPubKey, const uint256& sighash) const;
 };
 
+/** Allocate the signature cache, sized by -maxsigcachesize entries */
+void InitSignatureCache();
+/** Signature cache occupancy and lookup counters since startup */
+void GetSignatureCacheStats(int64_t& nEntries, int64_t& nCapacity, int64_t& nLookups, int64_t& nHits);
+
 #endif // BITCOIN_SCRIPT_SIGCACHE_H
@@ -14,7 +14,10 @@
 #include "structs/uint256.h"
 #include "sigcache.h"
 
+#include <boost/atomic.hpp>
+#include <boost/bind.hpp>
 #include <boost/foreach.hpp>
+#include <boost/thread.hpp>
 
 void MultichainNode_AddSignatureToCache(const std::vector<unsigned char>& vchSig, const CPubKey& pubkey, const uint256& sighash);
 
@@ -22,6 +25,9 @@ using namespace std;
 
 typedef vector<unsigned char> valtype;
 
+/** Additional signing thread is started for every this number of inputs */
+static const unsigned int SIGN_INPUTS_PER_THREAD = 8;
+
 bool Sign1(const CKeyID& address, const CKeyStore& keystore, uint256 hash, int nHashType, CScript& scriptSigRet)
 {
 /* MCHN START */    
@@ -174,6 +180,91 @@ bool SignSignature(const CKeyStore &keystore, const CTransaction& txFrom, CMutab
     return SignSignature(keystore, txout.scriptPubKey, txTo, nIn, nHashType);
 }
 
+/* AMB START */
+bool SignSignature(const CKeyStore &keystore, const CScript& fromPubKey, CScript& scriptSigRet, unsigned int nIn, const CSignatureHashCache& sighashcache, int nHashType)
+{
+    assert(nIn < sighashcache.GetTransaction().vin.size());
+
+    uint256 hash = sighashcache.SignatureHash(fromPubKey, nIn, nHashType);
+    txnouttype whichType;
+    if (!Solver(keystore, fromPubKey, hash, nHashType, scriptSigRet, whichType))
+        return false;
+
+    if (whichType == TX_SCRIPTHASH)
+    {
+        CScript subscript = scriptSigRet;
+        uint256 hash2 = sighashcache.SignatureHash(subscript, nIn, nHashType);
+
+        txnouttype subType;
+        bool fSolved =
+            Solver(keystore, subscript, hash2, nHashType, scriptSigRet, subType) && subType != TX_SCRIPTHASH;
+        scriptSigRet << static_cast<valtype>(subscript);
+        if (!fSolved) return false;
+    }
+
+    // Signature hash doesn't depend on scriptSigs, cached transaction can be used even if they were changed since
+    if(GetBoolArg("-verifyjustsigned",false))
+    {
+        return VerifyScript(scriptSigRet, fromPubKey, STANDARD_SCRIPT_VERIFY_FLAGS, TransactionSignatureChecker(&sighashcache.GetTransaction(), nIn, &sighashcache));
+    }
+    return true;
+}
+
+/** Inputs are taken from the shared counter, each thread writes only scriptSigs of inputs it has taken */
+static void SignSignaturesThread(const CKeyStore* keystore, const std::vector<CScript>* vFromPubKeys, CMutableTransaction* txTo,
+                                 const CSignatureHashCache* sighashcache, int nHashType,
+                                 boost::atomic<unsigned int>* nNextInput, std::vector<char>* vSigned)
+{
+    unsigned int nIn;
+    while ((nIn = (*nNextInput)++) < txTo->vin.size())
+    {
+        if (!(*vFromPubKeys)[nIn].empty())
+            (*vSigned)[nIn] = SignSignature(*keystore, (*vFromPubKeys)[nIn], txTo->vin[nIn].scriptSig, nIn, *sighashcache, nHashType);
+    }
+}
+
+bool SignSignatures(const CKeyStore &keystore, const std::vector<CScript>& vFromPubKeys, CMutableTransaction& txTo, std::vector<bool>& vSigned, int nHashType)
+{
+    assert(vFromPubKeys.size() == txTo.vin.size());
+
+    const CTransaction txConst(txTo);
+    CSignatureHashCache sighashcache(txConst);
+    std::vector<char> vSignedThread(txTo.vin.size(), 0);
+    boost::atomic<unsigned int> nNextInput(0);
+
+    int nThreads = GetArg("-signthreads", DEFAULT_SIGN_THREADS);
+    if (nThreads <= 0)
+        nThreads += boost::thread::hardware_concurrency();
+    nThreads = std::min(nThreads, MAX_SIGN_THREADS);
+    nThreads = std::min(nThreads, (int)(txTo.vin.size() / SIGN_INPUTS_PER_THREAD));
+
+    boost::thread_group threadGroup;
+    try
+    {
+        for (int i = 1; i < nThreads; i++)
+            threadGroup.create_thread(boost::bind(&SignSignaturesThread, &keystore, &vFromPubKeys, &txTo, &sighashcache, nHashType, &nNextInput, &vSignedThread));
+    }
+    catch (boost::thread_resource_error& e)
+    {
+        LogPrintf("SignSignatures: cannot create signing thread: %s\n", e.what());               // Remaining inputs are signed by this thread
+    }
+    SignSignaturesThread(&keystore, &vFromPubKeys, &txTo, &sighashcache, nHashType, &nNextInput, &vSignedThread);
+    threadGroup.join_all();
+
+    bool fAllSigned = true;
+    vSigned.assign(txTo.vin.size(), false);
+    for (unsigned int i = 0; i < txTo.vin.size(); i++)
+    {
+        if (vFromPubKeys[i].empty())
+            continue;
+        vSigned[i] = (vSignedThread[i] != 0);
+        if (!vSigned[i])
+            fAllSigned = false;
+    }
+    return fAllSigned;
+}
+/* AMB END */
+
 static CScript PushAll(const vector<valtype>& values)
 {
     CScript result;
@@ -184,7 +275,8 @@ static CScript PushAll(const vector<valtype>& values)
 
 static CScript CombineMultisig(const CScript& scriptPubKey, const CTransaction& txTo, unsigned int nIn,
                                const vector<valtype>& vSolutions,
-                               const vector<valtype>& sigs1, const vector<valtype>& sigs2)
+                               const vector<valtype>& sigs1, const vector<valtype>& sigs2,
+                               const CSignatureHashCache* sighashcache)
 {
     // Combine all the signatures we've got:
     set<valtype> allsigs;
@@ -217,7 +309,7 @@ static CScript CombineMultisig(const CScript& scriptPubKey, const CTransaction&
 
 /* MCHN START */            
 //            if (TransactionSignatureChecker(&txTo, nIn).CheckSig(sig, pubkey, scriptPubKey))
-            if (TransactionSignatureChecker(&txTo, nIn).CheckSig(sig, pubkey, scriptPubKey, cannot_send))
+            if (TransactionSignatureChecker(&txTo, nIn, sighashcache).CheckSig(sig, pubkey, scriptPubKey, cannot_send))
             {
 /* MCHN END */            
                 sigs[pubkey] = sig;
@@ -245,7 +337,8 @@ static CScript CombineMultisig(const CScript& scriptPubKey, const CTransaction&
 
 static CScript CombineSignatures(const CScript& scriptPubKey, const CTransaction& txTo, unsigned int nIn,
                                  const txnouttype txType, const vector<valtype>& vSolutions,
-                                 vector<valtype>& sigs1, vector<valtype>& sigs2)
+                                 vector<valtype>& sigs1, vector<valtype>& sigs2,
+                                 const CSignatureHashCache* sighashcache)
 {
     switch (txType)
     {
@@ -277,19 +370,19 @@ static CScript CombineSignatures(const CScript& scriptPubKey, const CTransaction
             TemplateSolver(pubKey2, txType2, vSolutions2);
             sigs1.pop_back();
             sigs2.pop_back();
-            CScript result = CombineSignatures(pubKey2, txTo, nIn, txType2, vSolutions2, sigs1, sigs2);
+            CScript result = CombineSignatures(pubKey2, txTo, nIn, txType2, vSolutions2, sigs1, sigs2, sighashcache);
             result << spk;
             return result;
         }
     case TX_MULTISIG:
-        return CombineMultisig(scriptPubKey, txTo, nIn, vSolutions, sigs1, sigs2);
+        return CombineMultisig(scriptPubKey, txTo, nIn, vSolutions, sigs1, sigs2, sighashcache);
     }
 
     return CScript();
 }
 
 CScript CombineSignatures(const CScript& scriptPubKey, const CTransaction& txTo, unsigned int nIn,
-                          const CScript& scriptSig1, const CScript& scriptSig2)
+                          const CScript& scriptSig1, const CScript& scriptSig2, const CSignatureHashCache* sighashcache)
 {
     txnouttype txType;
     vector<vector<unsigned char> > vSolutions;
@@ -300,5 +393,5 @@ CScript CombineSignatures(const CScript& scriptPubKey, const CTransaction& txTo,
     vector<valtype> stack2;
     EvalScript(stack2, scriptSig2, SCRIPT_VERIFY_STRICTENC, BaseSignatureChecker());
 
-    return CombineSignatures(scriptPubKey, txTo, nIn, txType, vSolutions, stack1, stack2);
+    return CombineSignatures(scriptPubKey, txTo, nIn, txType, vSolutions, stack1, stack2, sighashcache);
 }
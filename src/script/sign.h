@@ -9,6 +9,15 @@
 
 #include "script/interpreter.h"
 
+#include <vector>
+
+/* AMB START */
+/** -signthreads default, 0 - number of cores */
+static const int DEFAULT_SIGN_THREADS = 0;
+/** Maximal number of input signing threads */
+static const int MAX_SIGN_THREADS = 16;
+/* AMB END */
+
 class CKeyStore;
 class CScript;
 class CTransaction;
@@ -17,11 +26,24 @@ struct CMutableTransaction;
 
 bool SignSignature(const CKeyStore& keystore, const CScript& fromPubKey, CMutableTransaction& txTo, unsigned int nIn, int nHashType=SIGHASH_ALL);
 bool SignSignature(const CKeyStore& keystore, const CTransaction& txFrom, CMutableTransaction& txTo, unsigned int nIn, int nHashType=SIGHASH_ALL);
+/* AMB START */
+/** Signs input nIn of the transaction the cache was created for, signature script is returned in scriptSigRet */
+bool SignSignature(const CKeyStore& keystore, const CScript& fromPubKey, CScript& scriptSigRet, unsigned int nIn, const CSignatureHashCache& sighashcache, int nHashType=SIGHASH_ALL);
+
+/**
+ * Signs all inputs of txTo, vFromPubKeys[i] is the script of the output spent by input i, inputs with empty scripts are not touched.
+ * Signature hash parts are computed once per transaction, large transactions are signed by -signthreads threads.
+ * Signatures are identical to those of SignSignature called for each input. vSigned[i] is true if input i was signed.
+ * Returns true if all inputs with non-empty scripts were signed.
+ */
+bool SignSignatures(const CKeyStore& keystore, const std::vector<CScript>& vFromPubKeys, CMutableTransaction& txTo, std::vector<bool>& vSigned, int nHashType=SIGHASH_ALL);
+/* AMB END */
 
 /**
  * Given two sets of signatures for scriptPubKey, possibly with OP_0 placeholders,
  * combine them intelligently and return the result.
  */
-CScript CombineSignatures(const CScript& scriptPubKey, const CTransaction& txTo, unsigned int nIn, const CScript& scriptSig1, const CScript& scriptSig2);
+CScript CombineSignatures(const CScript& scriptPubKey, const CTransaction& txTo, unsigned int nIn, const CScript& scriptSig1, const CScript& scriptSig2,
+                          const CSignatureHashCache* sighashcache = NULL);
 
 #endif // BITCOIN_SCRIPT_SIGN_H
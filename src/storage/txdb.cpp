@@ -174,6 +174,72 @@ bool CBlockTreeDB::WriteTxIndex(const std::vector<std::pair<uint256, CDiskTxPos>
     return WriteBatch(batch);
 }
 
+/* AMB START */
+bool CBlockTreeDB::WriteStreamIndex(const std::vector<std::pair<CStreamIndexKey, CDiskTxPos> > &vect) {
+    CLevelDBBatch batch;
+    for (std::vector<std::pair<CStreamIndexKey, CDiskTxPos> >::const_iterator it=vect.begin(); it!=vect.end(); it++)
+        batch.Write(make_pair('S', it->first), it->second);
+    return WriteBatch(batch);
+}
+
+bool CBlockTreeDB::EraseStreamIndex(const std::vector<CStreamIndexKey> &vect) {
+    CLevelDBBatch batch;
+    for (std::vector<CStreamIndexKey>::const_iterator it=vect.begin(); it!=vect.end(); it++)
+        batch.Erase(make_pair('S', *it));
+    return WriteBatch(batch);
+}
+
+bool CBlockTreeDB::ReadStreamIndex(const unsigned char *streamID, uint32_t nFromHeight, std::vector<std::pair<CStreamIndexKey, CDiskTxPos> > &vect) {
+    boost::scoped_ptr<leveldb::Iterator> pcursor(NewIterator());
+
+    CDataStream ssKeySet(SER_DISK, CLIENT_VERSION);
+    ssKeySet << make_pair('S', CStreamIndexKey(streamID, nFromHeight, 0));
+    pcursor->Seek(ssKeySet.str());
+
+    while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+        try {
+            leveldb::Slice slKey = pcursor->key();
+            CDataStream ssKey(slKey.data(), slKey.data()+slKey.size(), SER_DISK, CLIENT_VERSION);
+            char chType;
+            CStreamIndexKey key;
+            ssKey >> chType;
+            if (chType != 'S')
+                break;
+            ssKey >> key;
+            if (memcmp(key.streamID, streamID, STREAM_INDEX_ID_SIZE) != 0)
+                break;
+            leveldb::Slice slValue = pcursor->value();
+            CDataStream ssValue(slValue.data(), slValue.data()+slValue.size(), SER_DISK, CLIENT_VERSION);
+            CDiskTxPos pos;
+            ssValue >> pos;
+            vect.push_back(make_pair(key, pos));
+            pcursor->Next();
+        } catch (std::exception &e) {
+            return error("%s : Deserialize or I/O error - %s", __func__, e.what());
+        }
+    }
+
+    return true;
+}
+
+bool CBlockTreeDB::WritePinnedBlockFile(int nFile) {
+    return Write(make_pair('p', nFile), '1', true);
+}
+
+bool CBlockTreeDB::IsPinnedBlockFile(int nFile) {
+    return Exists(make_pair('p', nFile));
+}
+
+bool CBlockTreeDB::WriteFirstPinTrackedFile(int nFile) {
+    return Write('P', nFile, true);
+}
+
+bool CBlockTreeDB::ReadFirstPinTrackedFile(int &nFile) {
+    return Read('P', nFile);
+}
+/* AMB END */
+
 bool CBlockTreeDB::WriteFlag(const std::string &name, bool fValue) {
     return Write(std::make_pair('F', name), fValue ? '1' : '0');
 }
@@ -9,6 +9,7 @@
 
 #include "storage/leveldbwrapper.h"
 #include "core/main.h"
+#include "crypto/common.h"
 
 #include <map>
 #include <string>
@@ -40,6 +41,54 @@ public:
     bool GetStats(CCoinsStats &stats) const;
 };
 
+/* AMB START */
+//! Size of stream ID in the stream index, short txid of stream creation transaction
+static const unsigned int STREAM_INDEX_ID_SIZE = 16;
+
+/** 
+ * Key of the per-stream block index. Height and transaction position are stored big-endian,
+ * so keys of one stream are iterated in chain order.
+ */
+class CStreamIndexKey
+{
+public:
+    unsigned char streamID[STREAM_INDEX_ID_SIZE];
+    uint32_t nHeight;
+    uint32_t nTx;
+
+    CStreamIndexKey() { memset(streamID, 0, STREAM_INDEX_ID_SIZE); nHeight = 0; nTx = 0; }
+    CStreamIndexKey(const unsigned char *streamIDIn, uint32_t nHeightIn, uint32_t nTxIn) : nHeight(nHeightIn), nTx(nTxIn)
+    {
+        memcpy(streamID, streamIDIn, STREAM_INDEX_ID_SIZE);
+    }
+
+    unsigned int GetSerializeSize(int nType, int nVersion) const
+    {
+        return STREAM_INDEX_ID_SIZE + 8;
+    }
+
+    template<typename Stream>
+    void Serialize(Stream& s, int nType, int nVersion) const
+    {
+        unsigned char buf[8];
+        WriteBE32(buf, nHeight);
+        WriteBE32(buf + 4, nTx);
+        s.write((char*)streamID, STREAM_INDEX_ID_SIZE);
+        s.write((char*)buf, 8);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s, int nType, int nVersion)
+    {
+        unsigned char buf[8];
+        s.read((char*)streamID, STREAM_INDEX_ID_SIZE);
+        s.read((char*)buf, 8);
+        nHeight = ReadBE32(buf);
+        nTx = ReadBE32(buf + 4);
+    }
+};
+/* AMB END */
+
 /** Access to the block database (blocks/index/) */
 class CBlockTreeDB : public CLevelDBWrapper
 {
@@ -58,6 +107,15 @@ public:
     bool ReadReindexing(bool &fReindex);
     bool ReadTxIndex(const uint256 &txid, CDiskTxPos &pos);
     bool WriteTxIndex(const std::vector<std::pair<uint256, CDiskTxPos> > &list);
+/* AMB START */
+    bool WriteStreamIndex(const std::vector<std::pair<CStreamIndexKey, CDiskTxPos> > &list);
+    bool EraseStreamIndex(const std::vector<CStreamIndexKey> &list);
+    bool ReadStreamIndex(const unsigned char *streamID, uint32_t nFromHeight, std::vector<std::pair<CStreamIndexKey, CDiskTxPos> > &list);
+    bool WritePinnedBlockFile(int nFile);
+    bool IsPinnedBlockFile(int nFile);
+    bool WriteFirstPinTrackedFile(int nFile);
+    bool ReadFirstPinTrackedFile(int &nFile);
+/* AMB END */
     bool WriteFlag(const std::string &name, bool fValue);
     bool ReadFlag(const std::string &name, bool &fValue);
     bool LoadBlockIndexGuts();
@@ -121,7 +121,7 @@ std::string EncodeBase58Check(const std::vector<unsigned char>& vchIn)
     
 /* MCHN START */
     int32_t checksum=(int32_t)mc_GetLE(&hash,4);
-    checksum ^= (int32_t)mc_gState->m_NetworkParams->GetInt64Param("addresschecksumvalue");
+    checksum ^= (int32_t)mc_gState->m_NetworkParams->GetInt64Param(MC_PRM_ID_ADDRESS_CHECKSUM_VALUE);
     vch.insert(vch.end(), (unsigned char*)&checksum, (unsigned char*)&checksum + 4);
 //    vch.insert(vch.end(), (unsigned char*)&hash, (unsigned char*)&hash + 4);
 /* MCHN END */    
@@ -141,7 +141,7 @@ bool DecodeBase58Check(const char* psz, std::vector<unsigned char>& vchRet)
     
 /* MCHN START */
     int32_t checksum=(int32_t)mc_GetLE(&hash,4);
-    checksum ^= (int32_t)mc_gState->m_NetworkParams->GetInt64Param("addresschecksumvalue");
+    checksum ^= (int32_t)mc_gState->m_NetworkParams->GetInt64Param(MC_PRM_ID_ADDRESS_CHECKSUM_VALUE);
     
     if (memcmp((unsigned char*)&checksum, &vchRet.end()[-4], 4) != 0) {
 //    if (memcmp(&hash, &vchRet.end()[-4], 4) != 0) {
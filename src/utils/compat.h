@@ -46,6 +46,14 @@
 #include <unistd.h>
 #endif
 
+/* AMB START */
+#if !defined(WIN32) && defined(HAVE_SYS_EPOLL_H)
+#define USE_EPOLL
+#include <poll.h>
+#include <sys/epoll.h>
+#endif
+/* AMB END */
+
 #ifdef WIN32
 #define MSG_DONTWAIT        0
 #else
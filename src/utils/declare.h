@@ -58,6 +58,35 @@ typedef struct mc_MapStringString
     int GetCount();
 } mc_MapStringString;
 
+struct mc_Buffer;
+
+/* AMB START */
+typedef struct mc_BufferIndex
+{
+    mc_BufferIndex()
+    {
+        Zero();
+    }
+
+    ~mc_BufferIndex()
+    {
+        Destroy();
+    }
+
+    uint32_t               *m_lpSlots;                                          // Open addressing table of (key hash, row ID+1) pairs, row 0 - empty slot
+    int                     m_SlotCount;                                        // Power of 2
+    int                     m_UsedCount;                                        // Occupied slots, including slots of rows overwritten by PutRow
+    
+    void Zero();
+    int Destroy();
+    int Clear();
+    int Rebuild(struct mc_Buffer *buffer,int count);
+    int Insert(struct mc_Buffer *buffer,const void *lpKey,int RowID);
+    int Add(struct mc_Buffer *buffer,const void *lpKey,int RowID);
+    int Get(struct mc_Buffer *buffer,const void *lpKey);
+} mc_BufferIndex;
+/* AMB END */
+
 typedef struct mc_Buffer
 {
     mc_Buffer()
@@ -70,7 +99,7 @@ typedef struct mc_Buffer
         Destroy();
     }
 
-    mc_MapStringIndex      *m_lpIndex;
+    mc_BufferIndex         *m_lpIndex;
     unsigned char          *m_lpData;   
     int                     m_AllocSize;
     int                     m_Size;
@@ -260,6 +289,10 @@ const unsigned char *mc_ParseOpDropOpReturnScript(const unsigned char *src,int s
 const unsigned char *mc_ExtractAddressFromInputScript(const unsigned char *src,int size,int *op_addr_offset,int *op_addr_size,int* is_redeem_script,int* sighash_type,int check_last);
 
 void mc_LogString(FILE *fHan, const char* message);
+/* AMB START */
+typedef int (*mc_LogStringFunc)(const char *filename,const char *message);
+extern mc_LogStringFunc mc_gLogStringFunc;                                      // Queues message for asynchronous writer, NULL or nonzero result - caller writes the file
+/* AMB END */
 
 const char *mc_Version();
 const char *mc_FullVersion();
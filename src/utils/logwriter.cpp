@@ -0,0 +1,367 @@
+// Copyright (c) 2018 Apsaras Group Ltd
+// Amberchain code distributed under the GPLv3 license, see COPYING file.
+
+#include "utils/logwriter.h"
+
+#include "utils/util.h"
+#include "utils/utiltime.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include <boost/atomic.hpp>
+#include <boost/lockfree/spsc_queue.hpp>
+#include <boost/thread.hpp>
+
+using namespace std;
+
+/** Writer thread wakes up at least this often, milliseconds */
+static const int LOG_WRITER_INTERVAL = 100;
+/** Largest supported message, longer messages are truncated */
+static const size_t MAX_LOG_MESSAGE_SIZE = 1 << 20;
+
+struct CLogRecordHeader
+{
+    uint32_t nSize;
+    int16_t nFile;
+    int16_t nFormat;
+    int64_t nTime;
+};
+
+/** Ring buffer of one logging thread, written by this thread only, read by writer thread only */
+class CLogRing
+{
+public:
+    boost::lockfree::spsc_queue<char> queue;
+    size_t nCapacity;
+    boost::atomic<bool> fOrphaned;                                              // Logging thread exited, ring is deleted when drained
+    bool fStartedNewLine;                                                       // Writer thread only, debug.log line state of this thread
+
+    CLogRing(size_t nCapacityIn) : queue(nCapacityIn), nCapacity(nCapacityIn), fOrphaned(false), fStartedNewLine(true) {}
+};
+
+struct CLogFile
+{
+    std::string strName;
+    FILE *file;                                                                 // Writer thread only after registration
+    std::string strBuffer;                                                      // Writer thread only
+
+    CLogFile(const std::string& strNameIn, FILE *fileIn) : strName(strNameIn), file(fileIn) {}
+};
+
+static boost::mutex csLogWriter;                                                // Protects registration of rings and files
+static boost::condition_variable condLogWriter;
+static std::vector<CLogRing*> vLogRings;
+static std::vector<CLogFile*> vLogFiles;
+static std::map<std::string, int> mapLogFiles;
+static boost::thread *pLogWriterThread = NULL;
+static size_t nLogRingSize = DEFAULT_LOG_BUFFER_SIZE * 1024;
+
+static boost::atomic<bool> fLogWriterRunning(false);
+static boost::atomic<uint64_t> nLogWritten(0);
+static boost::atomic<uint64_t> nLogDropped(0);
+static boost::atomic<uint64_t> nLogDroppedBytes(0);
+
+static void OrphanLogRing(CLogRing *ring)
+{
+    // Called on thread exit, buffered messages are still written
+    ring->fOrphaned = true;
+}
+
+static boost::thread_specific_ptr<CLogRing> ptrLogRing(OrphanLogRing);
+
+static void FormatLogRecord(bool& fStartedNewLine, const CLogRecordHeader& header, const char *data, std::string& strOut)
+{
+    int64_t nTime = header.nTime / 1000;
+    int nMillis = (int)(header.nTime % 1000);
+
+    if (header.nFormat == LOG_FORMAT_MC)
+    {
+        struct tm bdt;
+        time_t t = (time_t)nTime;
+#ifndef WIN32
+        localtime_r(&t, &bdt);
+#else
+        bdt = *localtime(&t);
+#endif
+        char buf[64];
+        size_t len = strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &bdt);
+        snprintf(buf + len, sizeof(buf) - len, ".%03d\t", nMillis);
+        strOut.append(buf);
+        strOut.append(data, header.nSize);
+        strOut.push_back('\n');
+        return;
+    }
+
+    if (fLogTimestamps && fStartedNewLine)
+    {
+        strOut.append(DateTimeStrFormat("%Y-%m-%d %H:%M:%S", nTime));
+        if (fLogTimeMillis)
+            strOut.append(strprintf(".%03d ", nMillis));
+        else
+            strOut.push_back(' ');
+    }
+    fStartedNewLine = (header.nSize > 0) && (data[header.nSize - 1] == '\n');
+    strOut.append(data, header.nSize);
+}
+
+static void DrainLogRing(CLogRing *ring, const std::vector<CLogFile*>& vFiles, std::vector<char>& vData)
+{
+    CLogRecordHeader header;
+    while (ring->queue.read_available() >= sizeof(header))
+    {
+        // Records are pushed in one call, so the whole record is available once its header is
+        ring->queue.pop((char*)&header, sizeof(header));
+        vData.resize(header.nSize + 1);
+        if (header.nSize)
+            ring->queue.pop(&vData[0], header.nSize);
+        vData[header.nSize] = 0;
+        if ((header.nFile >= 0) && (header.nFile < (int)vFiles.size()))
+        {
+            FormatLogRecord(ring->fStartedNewLine, header, &vData[0], vFiles[header.nFile]->strBuffer);
+            nLogWritten++;
+        }
+    }
+}
+
+static void FlushLogFiles(const std::vector<CLogFile*>& vFiles, bool fReopen)
+{
+    for (unsigned int i = 0; i < vFiles.size(); i++)
+    {
+        CLogFile *logfile = vFiles[i];
+        if (fReopen && logfile->file)
+        {
+            fclose(logfile->file);
+            logfile->file = NULL;
+        }
+        if (logfile->strBuffer.empty())
+            continue;
+        if (logfile->file == NULL)
+            logfile->file = fopen(logfile->strName.c_str(), "a");
+        if (logfile->file)
+        {
+            fwrite(logfile->strBuffer.data(), 1, logfile->strBuffer.size(), logfile->file);
+            fflush(logfile->file);
+        }
+        logfile->strBuffer.clear();
+    }
+}
+
+static void ThreadLogWriter()
+{
+    RenameThread("bitcoin-logwriter");
+
+    std::vector<char> vData;
+    uint64_t nDroppedReported = 0;
+    uint64_t nDroppedBytesReported = 0;
+    bool fStop = false;
+    while (!fStop)
+    {
+        std::vector<CLogRing*> vRings;
+        std::vector<CLogFile*> vFiles;
+        {
+            boost::unique_lock<boost::mutex> lock(csLogWriter);
+            if (fLogWriterRunning)
+                condLogWriter.timed_wait(lock, boost::posix_time::milliseconds(LOG_WRITER_INTERVAL));
+            fStop = !fLogWriterRunning;                                         // Rings are drained once more after stop is requested
+            vRings = vLogRings;
+            vFiles = vLogFiles;
+        }
+
+        std::vector<CLogRing*> vDrained;
+        for (unsigned int i = 0; i < vRings.size(); i++)
+        {
+            bool fOrphaned = vRings[i]->fOrphaned;
+            DrainLogRing(vRings[i], vFiles, vData);
+            if (fOrphaned)
+                vDrained.push_back(vRings[i]);
+        }
+
+        uint64_t nDropped = nLogDropped;
+        uint64_t nDroppedBytes = nLogDroppedBytes;
+        if ((nDropped != nDroppedReported) && !vFiles.empty())
+        {
+            CLogRecordHeader header;
+            std::string strMessage = strprintf("Log buffer full, %d messages (%d bytes) dropped\n",
+                                               nDropped - nDroppedReported, nDroppedBytes - nDroppedBytesReported);
+            bool fStartedNewLine = true;
+            header.nSize = strMessage.size();
+            header.nFile = 0;
+            header.nFormat = LOG_FORMAT_DEBUG;
+            header.nTime = GetTimeMillis();
+            FormatLogRecord(fStartedNewLine, header, strMessage.c_str(), vFiles[0]->strBuffer);
+            nDroppedReported = nDropped;
+            nDroppedBytesReported = nDroppedBytes;
+        }
+
+        // Reopen requested by SIGHUP, used after log rotation
+        bool fReopen = fReopenDebugLog;
+        if (fReopen)
+            fReopenDebugLog = false;
+        FlushLogFiles(vFiles, fReopen);
+
+        if (!vDrained.empty())
+        {
+            boost::unique_lock<boost::mutex> lock(csLogWriter);
+            for (unsigned int i = 0; i < vDrained.size(); i++)
+            {
+                vLogRings.erase(std::find(vLogRings.begin(), vLogRings.end(), vDrained[i]));
+                delete vDrained[i];
+            }
+        }
+    }
+}
+
+bool StartLogWriter(const std::string& strDebugLog, int nBufferSizeKB)
+{
+    if (fLogWriterRunning)
+        return true;
+
+    nLogRingSize = std::max(nBufferSizeKB, 16) * 1024;
+    if (LogWriterGetFile(strDebugLog) != 0)
+        return false;
+
+    boost::unique_lock<boost::mutex> lock(csLogWriter);
+    fLogWriterRunning = true;
+    pLogWriterThread = new boost::thread(&ThreadLogWriter);
+    return true;
+}
+
+void StopLogWriter()
+{
+    boost::thread *pThread;
+    {
+        boost::unique_lock<boost::mutex> lock(csLogWriter);
+        if (!fLogWriterRunning)
+            return;
+        // Messages pushed by threads which passed running check before this point may be lost
+        fLogWriterRunning = false;
+        pThread = pLogWriterThread;
+        pLogWriterThread = NULL;
+    }
+    condLogWriter.notify_all();
+    pThread->join();
+    delete pThread;
+
+    boost::unique_lock<boost::mutex> lock(csLogWriter);
+    for (unsigned int i = 0; i < vLogFiles.size(); i++)
+    {
+        if (vLogFiles[i]->file)
+        {
+            fclose(vLogFiles[i]->file);
+            vLogFiles[i]->file = NULL;
+        }
+    }
+}
+
+bool IsLogWriterRunning()
+{
+    return fLogWriterRunning;
+}
+
+int LogWriterGetFile(const std::string& strFileName)
+{
+    boost::unique_lock<boost::mutex> lock(csLogWriter);
+    std::map<std::string, int>::const_iterator it = mapLogFiles.find(strFileName);
+    if (it != mapLogFiles.end())
+        return it->second;
+
+    FILE *file = fopen(strFileName.c_str(), "a");
+    if (file == NULL)
+        return -1;
+    int nFile = vLogFiles.size();
+    vLogFiles.push_back(new CLogFile(strFileName, file));
+    mapLogFiles.insert(make_pair(strFileName, nFile));
+    return nFile;
+}
+
+bool LogWriterPush(int nFile, int nFormat, const char *data, size_t size)
+{
+    if (!fLogWriterRunning || (nFile < 0))
+        return false;
+
+    CLogRing *ring = ptrLogRing.get();
+    if (ring == NULL)
+    {
+        ring = new CLogRing(nLogRingSize);
+        {
+            boost::unique_lock<boost::mutex> lock(csLogWriter);
+            vLogRings.push_back(ring);
+        }
+        ptrLogRing.reset(ring);
+    }
+
+    if (size > MAX_LOG_MESSAGE_SIZE)
+        size = MAX_LOG_MESSAGE_SIZE;
+
+    CLogRecordHeader header;
+    header.nSize = size;
+    header.nFile = nFile;
+    header.nFormat = nFormat;
+    header.nTime = GetTimeMillis();
+
+    size_t nTotal = sizeof(header) + size;
+    size_t nAvailable = ring->queue.write_available();
+    if (nAvailable < nTotal)
+    {
+        nLogDropped++;
+        nLogDroppedBytes += size;
+        condLogWriter.notify_one();
+        return true;
+    }
+
+    char buf[512];
+    std::vector<char> vBuf;
+    char *ptr = buf;
+    if (nTotal > sizeof(buf))
+    {
+        vBuf.resize(nTotal);
+        ptr = &vBuf[0];
+    }
+    memcpy(ptr, &header, sizeof(header));
+    memcpy(ptr + sizeof(header), data, size);
+    ring->queue.push(ptr, nTotal);
+
+    if (nAvailable - nTotal < ring->nCapacity / 2)
+        condLogWriter.notify_one();
+
+    return true;
+}
+
+void LogWriterGetStats(uint64_t *pnWritten, uint64_t *pnDropped, uint64_t *pnDroppedBytes)
+{
+    *pnWritten = nLogWritten;
+    *pnDropped = nLogDropped;
+    *pnDroppedBytes = nLogDroppedBytes;
+}
+
+int LogWriterLogString(const char *filename, const char *message)
+{
+    if (!fLogWriterRunning)
+        return -1;
+
+    static boost::thread_specific_ptr<std::map<std::string, int> > ptrFiles;
+    if (ptrFiles.get() == NULL)
+        ptrFiles.reset(new std::map<std::string, int>());
+
+    int nFile;
+    std::map<std::string, int>::const_iterator it = ptrFiles->find(filename);
+    if (it != ptrFiles->end())
+    {
+        nFile = it->second;
+    }
+    else
+    {
+        nFile = LogWriterGetFile(filename);
+        if (nFile < 0)
+            return -1;
+        ptrFiles->insert(make_pair(std::string(filename), nFile));
+    }
+
+    return LogWriterPush(nFile, LOG_FORMAT_MC, message, strlen(message)) ? 0 : -1;
+}
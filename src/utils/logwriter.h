@@ -0,0 +1,41 @@
+// Copyright (c) 2018 Apsaras Group Ltd
+// Amberchain code distributed under the GPLv3 license, see COPYING file.
+
+#ifndef AMBER_LOGWRITER_H
+#define AMBER_LOGWRITER_H
+
+#include <stdint.h>
+#include <string>
+
+/** -asynclog default */
+static const bool DEFAULT_ASYNC_LOG = true;
+/** -logbuffersize default, per-thread log buffer in KB */
+static const int DEFAULT_LOG_BUFFER_SIZE = 256;
+
+/** Line prefix added by writer thread */
+enum LogFormat
+{
+    LOG_FORMAT_DEBUG = 0,                                                       // debug.log: GMT timestamp, subject to -logtimestamps and -logtimemillis, message written as is
+    LOG_FORMAT_MC = 1,                                                          // MultiChain module logs: local time with milliseconds, tab, message, new line
+};
+
+/**
+ * Asynchronous log writer.
+ * Each logging thread writes messages into its own lock-free ring buffer, the writer thread drains
+ * all buffers and writes them in batches, keeping one open handle per log file.
+ * If the buffer of the thread is full, the message is dropped and counted, the number of dropped messages
+ * is written to debug.log on the next drain. All files are reopened on SIGHUP (fReopenDebugLog).
+ * Buffers are drained one after another, so lines of one thread keep their order, but lines of different threads
+ * logged within one drain interval (LOG_WRITER_INTERVAL) may appear out of timestamp order.
+ */
+
+bool StartLogWriter(const std::string& strDebugLog, int nBufferSizeKB);       // Starts writer thread, debug.log is file 0
+void StopLogWriter();                                                           // Writes all buffered messages and stops writer thread, safe to call twice
+bool IsLogWriterRunning();
+
+int LogWriterGetFile(const std::string& strFileName);                           // Returns file ID, registers file on first use, -1 if cannot be opened
+bool LogWriterPush(int nFile, int nFormat, const char *data, size_t size);      // Returns false if writer is not running, message should be written synchronously
+int LogWriterLogString(const char *filename, const char *message);             // mc_LogString replacement for MultiChain module logs, 0 if message was queued
+void LogWriterGetStats(uint64_t *pnWritten, uint64_t *pnDropped, uint64_t *pnDroppedBytes);
+
+#endif // AMBER_LOGWRITER_H
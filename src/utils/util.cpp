@@ -11,6 +11,7 @@
 #include "utils/util.h"
 
 #include "chainparams/chainparamsbase.h"
+#include "utils/logwriter.h"
 #include "utils/random.h"
 #include "utils/serialize.h"
 #include "utils/sync.h"
@@ -188,6 +189,7 @@ static void DebugPrintInit()
 
 void DebugPrintClose()
 {
+    StopLogWriter();
     if(fileout)
     {
         fclose(fileout);
@@ -234,6 +236,12 @@ int LogPrintStr(const std::string &str)
         ret = fwrite(str.data(), 1, str.size(), stdout);
         fflush(stdout);
     }
+/* AMB START */
+    else if (fPrintToDebugLog && LogWriterPush(0, LOG_FORMAT_DEBUG, str.data(), str.size()))
+    {
+        ret = str.size();
+    }
+/* AMB END */
     else if (fPrintToDebugLog && AreBaseParamsConfigured())
     {
         static bool fStartedNewLine = true;
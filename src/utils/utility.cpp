@@ -11,6 +11,7 @@
 #define MC_DCT_BUF_ALLOC_ITEMS          256
 #define MC_DCT_LIST_ALLOC_MIN_SIZE      32768
 #define MC_DCT_LIST_ALLOC_MAX_SIZE      268435456
+#define MC_DCT_INDEX_MIN_SLOTS          64
 
 
 int c_IsHexNumeric[256]={
@@ -318,6 +319,155 @@ double mc_TimeNowAsDouble()
 }
 
 
+/* AMB START */
+
+static uint32_t mc_BufferKeyHash(const unsigned char *lpKey,int size)
+{
+    uint64_t h,v;
+    
+    h=0x9E3779B97F4A7C15ULL ^ (uint64_t)size;
+    while(size > 0)
+    {
+        v=0;
+        memcpy(&v,lpKey,(size >= 8) ? 8 : size);
+        h^=v;
+        h*=0xFF51AFD7ED558CCDULL;
+        h^=h>>32;
+        lpKey+=8;
+        size-=8;
+    }
+    
+    return (uint32_t)(h ^ (h >> 29));
+}
+
+void mc_BufferIndex::Zero()
+{
+    m_lpSlots=NULL;
+    m_SlotCount=0;
+    m_UsedCount=0;
+}
+
+int mc_BufferIndex::Destroy()
+{
+    if(m_lpSlots)
+    {
+        mc_Delete(m_lpSlots);
+    }
+    
+    Zero();
+    
+    return MC_ERR_NOERROR;
+}
+
+int mc_BufferIndex::Clear()
+{
+    if(m_lpSlots)
+    {
+        memset(m_lpSlots,0,m_SlotCount*2*sizeof(uint32_t));
+    }
+    m_UsedCount=0;
+    
+    return MC_ERR_NOERROR;
+}
+
+int mc_BufferIndex::Rebuild(mc_Buffer *buffer,int count)
+{
+    int slots,i;
+    
+    slots=MC_DCT_INDEX_MIN_SLOTS;
+    while(slots < 4*(count+1))
+    {
+        slots*=2;
+    }
+    
+    if(slots != m_SlotCount)
+    {
+        Destroy();
+        m_lpSlots=(uint32_t*)mc_New(slots*2*sizeof(uint32_t));
+        if(m_lpSlots == NULL)
+        {
+            return MC_ERR_ALLOCATION;
+        }
+        m_SlotCount=slots;
+    }
+    else
+    {
+        Clear();
+    }
+    
+    for(i=0;i<count;i++)
+    {
+        Insert(buffer,buffer->GetRow(i),i);
+    }
+    
+    return MC_ERR_NOERROR;
+}
+
+int mc_BufferIndex::Insert(mc_Buffer *buffer,const void *lpKey,int RowID)
+{
+    uint32_t hash,mask,pos,row;
+    
+    hash=mc_BufferKeyHash((const unsigned char*)lpKey,buffer->m_KeySize);
+    mask=m_SlotCount-1;
+    pos=hash & mask;
+    
+    while(m_lpSlots[2*pos+1])
+    {
+        row=m_lpSlots[2*pos+1]-1;
+        if( (m_lpSlots[2*pos] == hash) && ((int)row < buffer->m_Count) &&
+            (memcmp(buffer->GetRow(row),lpKey,buffer->m_KeySize) == 0) )
+        {
+            return MC_ERR_NOERROR;                                              // First row with this key is kept
+        }
+        pos=(pos+1) & mask;
+    }
+    
+    m_lpSlots[2*pos]=hash;
+    m_lpSlots[2*pos+1]=RowID+1;
+    m_UsedCount++;
+    
+    return MC_ERR_NOERROR;
+}
+
+int mc_BufferIndex::Add(mc_Buffer *buffer,const void *lpKey,int RowID)
+{
+    if(2*(m_UsedCount+1) > m_SlotCount)                                         // Key of RowID is already in the buffer, rebuilding drops slots of overwritten rows
+    {
+        return Rebuild(buffer,(RowID >= buffer->m_Count) ? RowID+1 : buffer->m_Count);
+    }
+    
+    return Insert(buffer,lpKey,RowID);
+}
+
+int mc_BufferIndex::Get(mc_Buffer *buffer,const void *lpKey)
+{
+    uint32_t hash,mask,pos,row;
+    
+    if(m_SlotCount == 0)
+    {
+        return -1;
+    }
+    
+    hash=mc_BufferKeyHash((const unsigned char*)lpKey,buffer->m_KeySize);
+    mask=m_SlotCount-1;
+    pos=hash & mask;
+    
+    while(m_lpSlots[2*pos+1])
+    {
+        row=m_lpSlots[2*pos+1]-1;
+        if( (m_lpSlots[2*pos] == hash) && ((int)row < buffer->m_Count) &&
+            (memcmp(buffer->GetRow(row),lpKey,buffer->m_KeySize) == 0) )
+        {
+            return row;
+        }
+        pos=(pos+1) & mask;
+    }
+    
+    return -1;
+}
+
+/* AMB END */
+
 void mc_Buffer::Zero()
 {
     m_lpData=NULL;   
@@ -360,7 +510,7 @@ int mc_Buffer::Initialize(int KeySize,int RowSize,uint32_t Mode)
     
     if(m_Mode & MC_BUF_MODE_MAP)
     {
-        m_lpIndex=new mc_MapStringIndex;
+        m_lpIndex=new mc_BufferIndex;
     }
         
     
@@ -444,7 +594,7 @@ int mc_Buffer::Add(const void *lpKey,const void *lpValue)
     
     if(m_lpIndex)
     {
-        m_lpIndex->Add((unsigned char*)lpKey,m_KeySize,m_Count);
+        m_lpIndex->Add(this,lpKey,m_Count);
     }
     
     m_Count++;
@@ -480,7 +630,7 @@ int mc_Buffer::PutRow(int RowID,const void *lpKey,const void *lpValue)
     
     if(m_lpIndex)
     {
-        m_lpIndex->Add((unsigned char*)lpKey,m_KeySize,RowID);
+        m_lpIndex->Add(this,lpKey,RowID);
     }
     
     return MC_ERR_NOERROR;
@@ -494,16 +644,7 @@ int mc_Buffer::Seek(void *lpKey)
     
     if(m_lpIndex)
     {
-        row=m_lpIndex->Get((unsigned char*)lpKey,m_KeySize);
-        if(row >= 0)
-        {
-            ptr=GetRow(row);
-            if(memcmp(ptr,lpKey,m_KeySize)==0)
-            {
-                return row;
-            }
-        }
-        return -1;
+        return m_lpIndex->Get(this,lpKey);
     }
     
     ptr=m_lpData;
@@ -1812,6 +1953,10 @@ int mc_StringCompareCaseInsensitive(const char *str1,const char *str2, int len)
     return res;
 }
 
+/* AMB START */
+mc_LogStringFunc mc_gLogStringFunc=NULL;
+/* AMB END */
+
 void mc_LogString(FILE *fHan, const char* message)
 {
     struct tm *bdt;
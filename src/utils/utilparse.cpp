@@ -420,7 +420,7 @@ bool ParseMultichainTxOutToBuffer(uint256 hash,
                         {
                             if(mc_gState->m_Features->CachedInputScript())
                             {
-                                if(mc_gState->m_NetworkParams->GetInt64Param("supportminerprecheck"))                                
+                                if(mc_gState->m_NetworkParams->GetInt64Param(MC_PRM_ID_SUPPORT_MINER_PRECHECK))                                
                                 {
                                     *required |= MC_PTP_CACHED_SCRIPT_REQUIRED;
                                 }        
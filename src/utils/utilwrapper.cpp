@@ -702,6 +702,7 @@ int mc_MultichainParams::SetGlobals()
         }
     }
     m_ProtocolVersion=ProtocolVersion();
+    ResolveParams();
     
     MIN_RELAY_TX_FEE=(unsigned int)GetInt64Param("minimumrelayfee");    
     MAX_OP_RETURN_RELAY=(unsigned int)GetInt64Param("maxstdopreturnsize");    
@@ -64,6 +64,13 @@ CDBEnv::CDBEnv() : dbenv(DB_CXX_NO_EXCEPTIONS)
 {
     fDbEnvInit = false;
     fMockDb = false;
+/* AMB START */
+    nLogWriteSeq = 0;
+    nLogSyncedSeq = 0;
+    fLogSyncRunning = false;
+    fGroupCommit = false;
+    nCommitDelay = DEFAULT_WALLET_COMMIT_DELAY;
+/* AMB END */
 }
 
 CDBEnv::~CDBEnv()
@@ -118,9 +125,106 @@ bool CDBEnv::Open(const boost::filesystem::path& pathIn)
 
     fDbEnvInit = true;
     fMockDb = false;
+/* AMB START */
+    fGroupCommit = GetBoolArg("-walletgroupcommit", DEFAULT_WALLET_GROUP_COMMIT);
+    nCommitDelay = std::max(0, (int)GetArg("-walletcommitdelay", DEFAULT_WALLET_COMMIT_DELAY));
+    LogPrintf("CDBEnv::Open : Group commit %s, commit delay %dms\n", fGroupCommit ? "enabled" : "disabled", nCommitDelay);
+/* AMB END */
     return true;
 }
 
+/* AMB START */
+uint64_t CDBEnv::NoteWrite()
+{
+    boost::unique_lock<boost::mutex> lock(csLogSync);
+    return ++nLogWriteSeq;
+}
+
+bool CDBEnv::SyncLog(uint64_t nSeq)
+{
+    if (fMockDb || !fDbEnvInit)
+        return true;
+
+    boost::unique_lock<boost::mutex> lock(csLogSync);
+    while (nLogSyncedSeq < nSeq)
+    {
+        if (fLogSyncRunning)
+        {
+            // Flush in progress may not cover this write, wait and check again
+            condLogSync.wait(lock);
+            continue;
+        }
+
+        fLogSyncRunning = true;
+        lock.unlock();
+        if (nCommitDelay > 0)
+            MilliSleep(nCommitDelay);
+        lock.lock();
+        // Writes noted so far are in the log, flush covers all of them
+        uint64_t nTarget = nLogWriteSeq;
+        lock.unlock();
+
+        int64_t nStart = GetTimeMicros();
+        int ret = dbenv.log_flush(NULL);
+        uint64_t nMicros = GetTimeMicros() - nStart;
+
+        lock.lock();
+        fLogSyncRunning = false;
+        if (ret == 0 && nTarget > nLogSyncedSeq)
+        {
+            uint64_t nBatch = nTarget - nLogSyncedSeq;
+            nLogSyncedSeq = nTarget;
+            logSyncStats.nSyncs++;
+            logSyncStats.nSyncedWrites += nBatch;
+            logSyncStats.nMaxBatch = std::max(logSyncStats.nMaxBatch, nBatch);
+            logSyncStats.nTotalMicros += nMicros;
+            logSyncStats.nMaxMicros = std::max(logSyncStats.nMaxMicros, nMicros);
+            if(fDebug)LogPrint("db", "CDBEnv::SyncLog : %d writes flushed in %dus\n", nBatch, nMicros);
+        }
+        condLogSync.notify_all();
+        if (ret != 0)
+            return error("CDBEnv::SyncLog : Error %d flushing database log: %s", ret, DbEnv::strerror(ret));
+    }
+    return true;
+}
+
+CDBLogSyncStats CDBEnv::GetLogSyncStats()
+{
+    boost::unique_lock<boost::mutex> lock(csLogSync);
+    return logSyncStats;
+}
+
+// Last write deferred in the outermost CDBDeferLogSync scope of the thread, NULL if there is no scope
+static boost::thread_specific_ptr<uint64_t> pDeferredLogSeq;
+
+CDBDeferLogSync::CDBDeferLogSync()
+{
+    fOuter = (pDeferredLogSeq.get() == NULL);
+    if (fOuter)
+        pDeferredLogSeq.reset(new uint64_t(0));
+}
+
+CDBDeferLogSync::~CDBDeferLogSync()
+{
+    if (!fOuter)
+        return;
+    uint64_t nSeq = *pDeferredLogSeq;
+    pDeferredLogSeq.reset();
+    if (nSeq)
+        bitdb.SyncLog(nSeq);
+}
+
+bool CDBDeferLogSync::Defer(uint64_t nSeq)
+{
+    uint64_t *pSeq = pDeferredLogSeq.get();
+    if (pSeq == NULL)
+        return false;
+    if (nSeq > *pSeq)
+        *pSeq = nSeq;
+    return true;
+}
+/* AMB END */
+
 void CDBEnv::MakeMock()
 {
     if (fDbEnvInit)
@@ -246,7 +350,7 @@ void CDBEnv::CheckpointLSN(const std::string& strFile)
 }
 
 
-CDB::CDB(const std::string& strFilename, const char* pszMode) : pdb(NULL), activeTxn(NULL)
+CDB::CDB(const std::string& strFilename, const char* pszMode) : pdb(NULL), activeTxn(NULL), nWriteSeq(0)
 {
     int ret;
     fReadOnly = (!strchr(pszMode, '+') && !strchr(pszMode, 'w'));
@@ -313,6 +417,11 @@ void CDB::Flush()
     unsigned int nMinutes = 0;
     if (fReadOnly)
         nMinutes = 1;
+/* AMB START */
+    // With group commit writes are durable in the log, data files are checkpointed by size or time only
+    if (bitdb.fGroupCommit)
+        nMinutes = 1;
+/* AMB END */
 
     bitdb.dbenv.txn_checkpoint(nMinutes ? GetArg("-dblogsize", 100) * 1024 : 0, nMinutes, 0);
 }
@@ -326,6 +435,14 @@ void CDB::Close()
     activeTxn = NULL;
     pdb = NULL;
 
+/* AMB START */
+    if (nWriteSeq && bitdb.fGroupCommit)
+    {
+        if (!CDBDeferLogSync::Defer(nWriteSeq))
+            bitdb.SyncLog(nWriteSeq);
+    }
+    nWriteSeq = 0;
+/* AMB END */
     Flush();
 
     {
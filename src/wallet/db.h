@@ -30,6 +30,41 @@ extern unsigned int nWalletDBUpdated;
 
 void ThreadFlushWalletDB(const std::string& strWalletFile);
 
+/* AMB START */
+/** -walletgroupcommit default */
+static const bool DEFAULT_WALLET_GROUP_COMMIT = true;
+/** -walletcommitdelay default, milliseconds */
+static const int DEFAULT_WALLET_COMMIT_DELAY = 0;
+
+/** Wallet log sync statistics, returned by CDBEnv::GetLogSyncStats */
+struct CDBLogSyncStats
+{
+    uint64_t nSyncs;                                                            // Log flushes
+    uint64_t nSyncedWrites;                                                     // Committed writes made durable by these flushes
+    uint64_t nMaxBatch;                                                         // Largest number of writes made durable by one flush
+    uint64_t nTotalMicros;                                                      // Time spent in log flushes
+    uint64_t nMaxMicros;
+
+    CDBLogSyncStats() : nSyncs(0), nSyncedWrites(0), nMaxBatch(0), nTotalMicros(0), nMaxMicros(0) {}
+};
+
+/**
+ * Defers log sync of wallet writes made by this thread until the scope ends.
+ * Created before cs_main/cs_wallet are taken, so writers wait for the shared log flush without holding them.
+ * Nested scopes are merged into the outermost one.
+ */
+class CDBDeferLogSync
+{
+    bool fOuter;
+
+public:
+    CDBDeferLogSync();
+    ~CDBDeferLogSync();                                                         // Returns when writes made in scope are on disk
+
+    static bool Defer(uint64_t nSeq);                                           // Records write of closed handle, false if there is no scope in this thread
+};
+/* AMB END */
+
 
 class CDBEnv
 {
@@ -42,6 +77,17 @@ private:
  
     void EnvShutdown();
 
+/* AMB START */
+    // Group commit: writes are committed without sync, each writer waits in SyncLog until one log flush covers its write.
+    // RPC calls and block processing wait in CDBDeferLogSync destructor, after cs_main and cs_wallet are released
+    boost::mutex csLogSync;
+    boost::condition_variable condLogSync;
+    uint64_t nLogWriteSeq;                                                      // Sequence number of the last committed write
+    uint64_t nLogSyncedSeq;                                                     // All writes up to this one are on disk
+    bool fLogSyncRunning;
+    CDBLogSyncStats logSyncStats;
+/* AMB END */
+
 public:
     mutable CCriticalSection cs_db;
     DbEnv dbenv;
@@ -81,6 +127,15 @@ public:
     void CloseDb(const std::string& strFile);
     bool RemoveDb(const std::string& strFile);
 
+/* AMB START */
+    bool fGroupCommit;
+    int nCommitDelay;                                                           // Milliseconds the first writer waits for others before flushing the log
+
+    uint64_t NoteWrite();                                                       // Called after write was committed, returns its sequence number
+    bool SyncLog(uint64_t nSeq);                                                // Returns when write nSeq is on disk, one flush serves all waiting writers
+    CDBLogSyncStats GetLogSyncStats();
+/* AMB END */
+
     DbTxn* TxnBegin(int flags = DB_TXN_WRITE_NOSYNC)
     {
         DbTxn* ptxn = NULL;
@@ -102,6 +157,9 @@ protected:
     std::string strFile;
     DbTxn* activeTxn;
     bool fReadOnly;
+/* AMB START */
+    uint64_t nWriteSeq;                                                         // Last write of this handle which may be not on disk yet
+/* AMB END */
 
     explicit CDB(const std::string& strFilename, const char* pszMode = "r+");
     ~CDB() { Close(); }
@@ -171,6 +229,10 @@ protected:
 
         // Write
         int ret = pdb->put(activeTxn, &datKey, &datValue, (fOverwrite ? 0 : DB_NOOVERWRITE));
+/* AMB START */
+        if (ret == 0 && !activeTxn)
+            nWriteSeq = bitdb.NoteWrite();
+/* AMB END */
 
         // Clear memory in case it was a private key
         memset(datKey.get_data(), 0, datKey.get_size());
@@ -194,6 +256,10 @@ protected:
 
         // Erase
         int ret = pdb->del(activeTxn, &datKey, 0);
+/* AMB START */
+        if (ret == 0 && !activeTxn)
+            nWriteSeq = bitdb.NoteWrite();
+/* AMB END */
 
         // Clear memory
         memset(datKey.get_data(), 0, datKey.get_size());
@@ -286,6 +352,10 @@ public:
             return false;
         int ret = activeTxn->commit(0);
         activeTxn = NULL;
+/* AMB START */
+        if (ret == 0)
+            nWriteSeq = bitdb.NoteWrite();
+/* AMB END */
         return (ret == 0);
     }
 
@@ -100,6 +100,13 @@ public:
     virtual bool AddCScript(const CScript& redeemScript);
     virtual bool HaveCScript(const CScriptID &hash) const;
     virtual bool GetCScript(const CScriptID &hash, CScript& redeemScriptOut) const;
+/* AMB START */
+    unsigned int GetCScriptCount() const
+    {
+        LOCK(cs_KeyStore);
+        return mapScripts.size();
+    }
+/* AMB END */
 
     virtual bool AddWatchOnly(const CScript &dest);
     virtual bool RemoveWatchOnly(const CScript &dest);
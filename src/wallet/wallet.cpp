@@ -16,6 +16,7 @@ extern mc_WalletTxs* pwalletTxsMain;
 #include "net/net.h"
 #include "script/script.h"
 #include "script/sign.h"
+#include "storage/txdb.h"
 #include "utils/timedata.h"
 #include "utils/util.h"
 #include "utils/utilmoneystr.h"
@@ -23,6 +24,7 @@ extern mc_WalletTxs* pwalletTxsMain;
 #include <assert.h>
 
 #include <boost/algorithm/string/replace.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/thread.hpp>
 
 using namespace std;
@@ -1533,7 +1535,18 @@ int CWallet::ScanForWalletTransactions(CBlockIndex* pindexStart, bool fUpdate,bo
                 ShowProgress(_("Rescanning..."), std::max(1, std::min(99, (int)((Checkpoints::GuessVerificationProgress(pindex, false) - dProgressStart) / (dProgressTip - dProgressStart) * 100))));
             
             CBlock block;
-            ReadBlockFromDisk(block, pindex);
+/* AMB START */
+            if(!ReadBlockFromDisk(block, pindex))
+            {
+                LogPrintf("Rescan: cannot read block %d%s\n",pindex->nHeight,(pindex->nStatus & BLOCK_HAVE_DATA) ? "" : ", block was pruned");
+                if(err == MC_ERR_NOERROR)
+                {
+                    err=MC_ERR_INTERNAL_ERROR;
+                }
+                ret=-1;
+                break;
+            }
+/* AMB END */
             
 /* MCHN START */            
             CDiskTxPos pos(pindex->GetBlockPos(), GetSizeOfCompactSize(block.vtx.size()));
@@ -1591,10 +1604,12 @@ int CWallet::ScanForWalletTransactions(CBlockIndex* pindexStart, bool fUpdate,bo
             if(err == MC_ERR_NOERROR)
             {
                 LogPrint("wallet","wtxs: Replaying import mempool, %d items\n",mempool.hashList->m_Count);
-                for(int pos=0;pos<mempool.hashList->m_Count;pos++)
+                vector<bool> vExists;
+                mempool.existsHashList(0,vExists);
+                for(int pos=0;pos<(int)vExists.size();pos++)
                 {
                     uint256 hash=*(uint256*)mempool.hashList->GetRow(pos);
-                    if(mempool.exists(hash))
+                    if(vExists[pos])
                     {
                         const CTransaction& tx = mempool.mapTx[hash].GetTx();
                         LogPrint("wallet","wtxs: Mempool tx: %s\n",hash.ToString().c_str());
@@ -1625,6 +1640,553 @@ int CWallet::ScanForWalletTransactions(CBlockIndex* pindexStart, bool fUpdate,bo
     return ret;
 }
 
+/* AMB START */
+
+// Background rescan of newly subscribed entities. The import is advanced in batches of blocks,
+// cs_main and cs_wallet are held only while a batch is added to the import. Blocks are read
+// from disk and deserialized by prefetch threads while the previous batch is processed.
+
+static boost::mutex mutexRescan;
+static boost::condition_variable condRescan;
+static bool fRescanRequested=false;
+static bool fRescanRunning=false;
+static int nRescanImportBlock=-1;                                               // Last block added to the running import
+static int nRescanTargetBlock=-1;                                               // Chain height when the import was advanced last
+
+class CBlockPrefetcher
+{
+private:
+    boost::mutex cs;
+    boost::condition_variable cond;
+    std::deque<CBlockIndex*> vToRead;
+    std::set<CBlockIndex*> setRequested;
+    std::map<CBlockIndex*, boost::shared_ptr<CBlock> > mapRead;
+    boost::thread_group threads;
+    bool fStop;
+
+    void ThreadRead()
+    {
+        while(true)
+        {
+            CBlockIndex *pindex;
+            {
+                boost::unique_lock<boost::mutex> lock(cs);
+                while(!fStop && vToRead.empty())
+                {
+                    cond.wait(lock);
+                }
+                if(fStop)
+                {
+                    return;
+                }
+                pindex=vToRead.front();
+                vToRead.pop_front();
+            }
+            
+            boost::shared_ptr<CBlock> pblock(new CBlock);
+            if(!ReadBlockFromDisk(*pblock,pindex))
+            {
+                pblock.reset();                                                 // Consumer retries synchronously
+            }
+            
+            {
+                boost::unique_lock<boost::mutex> lock(cs);
+                if(setRequested.count(pindex))
+                {
+                    mapRead[pindex]=pblock;
+                }
+            }
+            cond.notify_all();
+        }
+    }
+
+public:
+    CBlockPrefetcher(int nThreads) : fStop(false)
+    {
+        for(int i=0;i<nThreads;i++)
+        {
+            threads.create_thread(boost::bind(&CBlockPrefetcher::ThreadRead,this));
+        }
+    }
+
+    ~CBlockPrefetcher()
+    {
+        {
+            boost::unique_lock<boost::mutex> lock(cs);
+            fStop=true;
+        }
+        cond.notify_all();
+        threads.join_all();
+    }
+
+    void Request(CBlockIndex *pindex)
+    {
+        if(threads.size() == 0)
+        {
+            return;
+        }
+        {
+            boost::unique_lock<boost::mutex> lock(cs);
+            if(!setRequested.insert(pindex).second)
+            {
+                return;
+            }
+            vToRead.push_back(pindex);
+        }
+        cond.notify_all();
+    }
+
+    // Drops requested blocks, used when the chain is reorganized under the import
+    void Clear()
+    {
+        boost::unique_lock<boost::mutex> lock(cs);
+        vToRead.clear();
+        setRequested.clear();
+        mapRead.clear();
+    }
+
+    boost::shared_ptr<CBlock> Get(CBlockIndex *pindex)
+    {
+        boost::shared_ptr<CBlock> pblock;
+        {
+            boost::unique_lock<boost::mutex> lock(cs);
+            if(setRequested.count(pindex))
+            {
+                while(mapRead.count(pindex) == 0)
+                {
+                    cond.wait(lock);
+                }
+                pblock=mapRead[pindex];
+                mapRead.erase(pindex);
+                setRequested.erase(pindex);
+            }
+        }
+        if(!pblock)
+        {
+            pblock.reset(new CBlock);
+            if(!ReadBlockFromDisk(*pblock,pindex))
+            {
+                pblock.reset();
+            }
+        }
+        return pblock;
+    }
+};
+
+static void SetRescanProgress(bool running,int import_block,int target_block)
+{
+    boost::unique_lock<boost::mutex> lock(mutexRescan);
+    fRescanRunning=running;
+    nRescanImportBlock=import_block;
+    nRescanTargetBlock=target_block;
+}
+
+void RequestBackgroundRescan()
+{
+    {
+        boost::unique_lock<boost::mutex> lock(mutexRescan);
+        fRescanRequested=true;
+    }
+    condRescan.notify_one();
+}
+
+bool GetBackgroundRescanProgress(int *import_block,int *target_block)
+{
+    boost::unique_lock<boost::mutex> lock(mutexRescan);
+    if(!fRescanRunning && !fRescanRequested)
+    {
+        return false;
+    }
+    *import_block=nRescanImportBlock;
+    *target_block=nRescanTargetBlock;
+    return true;
+}
+
+// Stream-only imports are advanced using per-stream block index: only transactions found in the index
+// are read from disk and added to the import, blocks without items of imported streams are skipped.
+
+static bool CanUseStreamIndex(mc_TxImport *imp)
+{
+    if(!fStreamIndex)
+    {
+        return false;
+    }
+    if( ((mc_gState->m_WalletMode & MC_WMD_ADDRESS_TXS) == 0) || (mc_gState->m_WalletMode & MC_WMD_MAP_TXS) )
+    {
+        return false;                                                           // Blocks are also scanned for wallet transactions
+    }
+    for(int i=0;i<imp->m_Entities->GetCount();i++)
+    {
+        mc_TxEntityStat *stat=imp->GetEntity(i);
+        switch(stat->m_Entity.m_EntityType & MC_TET_TYPE_MASK)
+        {
+            case MC_TET_STREAM:
+            case MC_TET_STREAM_KEY:
+            case MC_TET_STREAM_PUBLISHER:
+                break;
+            default:
+                return false;
+        }
+    }
+    return true;
+}
+
+static bool CompareStreamIndexEntries(const std::pair<CStreamIndexKey, CDiskTxPos>& a,const std::pair<CStreamIndexKey, CDiskTxPos>& b)
+{
+    if(a.first.nHeight != b.first.nHeight)
+    {
+        return a.first.nHeight < b.first.nHeight;
+    }
+    return a.first.nTx < b.first.nTx;
+}
+
+static int IndexedRescan(CWallet *pwallet,mc_TxImport *imp,uint256& hashLast,int& nBlocks)
+{
+    int err=MC_ERR_NOERROR;
+    int nTipHeight;
+    uint256 hashTip;
+    vector<std::pair<CStreamIndexKey, CDiskTxPos> > vEntries;
+    
+    {
+        LOCK2(cs_main, pwallet->cs_wallet);
+        if(!CanUseStreamIndex(imp))
+        {
+            return MC_ERR_NOERROR;
+        }
+        nTipHeight=chainActive.Height();
+        if(nTipHeight <= imp->m_Block)
+        {
+            return MC_ERR_NOERROR;
+        }
+        hashTip=chainActive.Tip()->GetBlockHash();
+        set<uint160> setStreams;
+        for(int i=0;i<imp->m_Entities->GetCount();i++)
+        {
+            mc_TxEntityStat *stat=imp->GetEntity(i);
+            uint160 stream_id=0;
+            memcpy(&stream_id,stat->m_Entity.m_EntityID,STREAM_INDEX_ID_SIZE);
+            if(setStreams.insert(stream_id).second)                             // Stream, keys and publishers share the index
+            {
+                if(!pblocktree->ReadStreamIndex(stat->m_Entity.m_EntityID,imp->m_Block+1,vEntries))
+                {
+                    LogPrintf("Background rescan: cannot read stream index, falling back to full scan\n");
+                    return MC_ERR_NOERROR;
+                }
+            }
+        }
+        
+        // Entries of blocks connected after the last chainstate flush survive a crash, they are dropped if the block is not in the active chain
+        unsigned int valid=0;
+        for(unsigned int i=0;i<vEntries.size();i++)
+        {
+            int height=vEntries[i].first.nHeight;
+            if( (height <= nTipHeight) && !(chainActive[height]->nStatus & BLOCK_HAVE_DATA) )
+            {
+                LogPrintf("Background rescan: block %d with indexed transaction was pruned\n",height);
+                return MC_ERR_INTERNAL_ERROR;
+            }
+            if( (height <= nTipHeight) && ((CDiskBlockPos)vEntries[i].second == chainActive[height]->GetBlockPos()) )
+            {
+                vEntries[valid++]=vEntries[i];
+            }
+        }
+        vEntries.resize(valid);
+    }
+    
+    sort(vEntries.begin(),vEntries.end(),CompareStreamIndexEntries);
+    
+    LogPrint("wallet","wtxs: Background rescan: %d indexed transactions in blocks %d-%d\n",(int)vEntries.size(),imp->m_Block+1,nTipHeight);
+    
+    unsigned int next=0;
+    while( (next < vEntries.size()) && (vEntries[next].first.nHeight <= (uint32_t)nTipHeight) && (err == MC_ERR_NOERROR) )
+    {
+        boost::this_thread::interruption_point();
+        
+        // Transactions are read without locks held, batch ends on block boundary
+        vector<CTransaction> vTxs;
+        unsigned int first=next;
+        while( (next < vEntries.size()) && (vEntries[next].first.nHeight <= (uint32_t)nTipHeight) &&
+               ( (next-first < (unsigned int)RESCAN_BATCH_BLOCKS) || (vEntries[next].first.nHeight == vEntries[next-1].first.nHeight) ) )
+        {
+            if( (next > first) && (vEntries[next].first.nHeight == vEntries[next-1].first.nHeight) && (vEntries[next].first.nTx == vEntries[next-1].first.nTx) )
+            {
+                vTxs.push_back(vTxs.back());                                    // Same transaction in several imported streams
+                next++;
+                continue;
+            }
+            const CDiskTxPos& postx=vEntries[next].second;
+            CAutoFile file(OpenBlockFile(postx, true), SER_DISK, CLIENT_VERSION);
+            CBlockHeader header;
+            CTransaction tx;
+            try {
+                file >> header;
+                fseek(file.Get(), postx.nTxOffset, SEEK_CUR);
+                file >> tx;
+            } catch (std::exception &e) {
+                LogPrintf("Background rescan: cannot read transaction in block %d: %s\n",vEntries[next].first.nHeight,e.what());
+                return MC_ERR_INTERNAL_ERROR;
+            }
+            vTxs.push_back(tx);
+            next++;
+        }
+        
+        {
+            LOCK2(cs_main, pwallet->cs_wallet);
+            if( (chainActive.Height() < nTipHeight) || (chainActive[nTipHeight]->GetBlockHash() != hashTip) )
+            {
+                return MC_ERR_NOERROR;                                          // Reorganized, remaining blocks are scanned in full
+            }
+            for(unsigned int i=first;(i<next) && (err == MC_ERR_NOERROR);i++)
+            {
+                int height=vEntries[i].first.nHeight;
+                if(height == 0)                                                 // Skip 0-block coinbase
+                {
+                    continue;
+                }
+                CBlockIndex *pindex=chainActive[height];
+                bool fFirstInBlock=(i == first) || (vEntries[i-1].first.nHeight != vEntries[i].first.nHeight);
+                if(fFirstInBlock)
+                {
+                    err=pwalletTxsMain->ImportSkipBlocks(imp,height-1);
+                }
+                if( (err == MC_ERR_NOERROR) && (fFirstInBlock || (vEntries[i-1].first.nTx != vEntries[i].first.nTx)) )
+                {
+                    err=pwalletTxsMain->AddTx(imp,vTxs[i-first],height,&(vEntries[i].second),vEntries[i].first.nTx,pindex->GetBlockHash());
+                }
+                if( (err == MC_ERR_NOERROR) && ((i+1 == next) || (vEntries[i+1].first.nHeight != vEntries[i].first.nHeight)) )
+                {
+                    err=pwalletTxsMain->Commit(imp);
+                    if(err == MC_ERR_NOERROR)
+                    {
+                        pwalletTxsMain->CleanUpAfterBlock(imp,height,height-1);
+                        hashLast=pindex->GetBlockHash();
+                        nBlocks++;
+                    }
+                }
+            }
+            if( (err == MC_ERR_NOERROR) && ((next == vEntries.size()) || (vEntries[next].first.nHeight > (uint32_t)nTipHeight)) )
+            {
+                err=pwalletTxsMain->ImportSkipBlocks(imp,nTipHeight);           // No more items up to the tip
+                if(err == MC_ERR_NOERROR)
+                {
+                    hashLast=hashTip;
+                }
+            }
+            SetRescanProgress(true,imp->m_Block,chainActive.Height());
+        }
+    }
+    
+    if(err == MC_ERR_NOERROR)
+    {
+        LOCK2(cs_main, pwallet->cs_wallet);
+        if( (imp->m_Block < nTipHeight) && (chainActive.Height() >= nTipHeight) && (chainActive[nTipHeight]->GetBlockHash() == hashTip) )
+        {
+            err=pwalletTxsMain->ImportSkipBlocks(imp,nTipHeight);               // No items at all
+            if(err == MC_ERR_NOERROR)
+            {
+                hashLast=hashTip;
+            }
+        }
+    }
+    
+    return err;
+}
+
+static int BackgroundRescan(CWallet *pwallet)
+{
+    mc_TxImport *imp;
+    int err;
+    int nBlocks=0;
+    int64_t nStart=GetTimeMillis();
+    uint256 hashLast=0;                                                         // Last block in the import, 0 - nothing imported yet
+    
+    {
+        LOCK2(cs_main, pwallet->cs_wallet);
+        imp=StartImport(pwallet,true,-1,&err);
+        if(imp == NULL)
+        {
+            if(err)
+            {
+                LogPrintf("Background rescan failed to start with error %d\n",err);
+            }
+            return err;
+        }
+        if(imp->m_Block >= 0)
+        {
+            hashLast=chainActive[imp->m_Block]->GetBlockHash();
+        }
+        SetRescanProgress(true,imp->m_Block,chainActive.Height());
+        LogPrint("wallet","wtxs: Background rescan started, import %d, block %d, chain height %d\n",imp->m_ImportID,imp->m_Block,chainActive.Height());
+    }
+    
+    CBlockPrefetcher prefetcher(max((int)GetArg("-rescanprefetchthreads",DEFAULT_RESCAN_PREFETCH_THREADS),0));
+    
+    try
+    {
+        err=IndexedRescan(pwallet,imp,hashLast,nBlocks);
+        
+        bool fDone=false;
+        while(!fDone && (err == MC_ERR_NOERROR))
+        {
+            boost::this_thread::interruption_point();
+            
+            vector<CBlockIndex*> vBatch;
+            {
+                LOCK2(cs_main, pwallet->cs_wallet);
+                
+                // Chain was reorganized below the import position, rolling the import back to the fork
+                if( (imp->m_Block >= 0) && 
+                    ((imp->m_Block > chainActive.Height()) || (chainActive[imp->m_Block]->GetBlockHash() != hashLast)) )
+                {
+                    BlockMap::iterator mi = mapBlockIndex.find(hashLast);
+                    const CBlockIndex *pfork=(mi != mapBlockIndex.end()) ? chainActive.FindFork(mi->second) : NULL;
+                    int fork_height=pfork ? pfork->nHeight : -1;
+                    LogPrint("wallet","wtxs: Background rescan: chain reorganized, rolling import back from %d to %d\n",imp->m_Block,fork_height);
+                    err=pwalletTxsMain->RollBack(imp,fork_height);
+                    hashLast=pfork ? pfork->GetBlockHash() : 0;
+                    prefetcher.Clear();
+                }
+                
+                if(err == MC_ERR_NOERROR)
+                {
+                    CBlockIndex *pindex=(imp->m_Block >= 0) ? chainActive.Next(chainActive[imp->m_Block]) : chainActive.Genesis();
+                    for(int i=0;pindex && (i<2*RESCAN_BATCH_BLOCKS);i++)
+                    {
+                        if(i<RESCAN_BATCH_BLOCKS)
+                        {
+                            vBatch.push_back(pindex);
+                        }
+                        prefetcher.Request(pindex);
+                        pindex=chainActive.Next(pindex);
+                    }
+
+                    // Import caught up with the chain, completing it in the same lock 
+                    if(vBatch.empty())
+                    {
+                        LogPrint("wallet","wtxs: Replaying import mempool, %d items\n",mempool.hashList->m_Count);
+                        vector<bool> vExists;
+                        mempool.existsHashList(0,vExists);
+                        for(int pos=0;pos<(int)vExists.size();pos++)
+                        {
+                            uint256 hash=*(uint256*)mempool.hashList->GetRow(pos);
+                            if(vExists[pos])
+                            {
+                                const CTransaction& tx = mempool.mapTx[hash].GetTx();
+                                pwalletTxsMain->AddTx(imp,tx,-1,NULL,-1,0);            
+                            }
+                        }
+                        err=pwalletTxsMain->CompleteImport(imp);
+                        fDone=true;
+                    }
+                }
+            }
+            
+            if(fDone || (err != MC_ERR_NOERROR))
+            {
+                break;
+            }
+            
+            // Blocks are read without locks held
+            vector<boost::shared_ptr<CBlock> > vBlocks;
+            for(unsigned int i=0;i<vBatch.size();i++)
+            {
+                vBlocks.push_back(prefetcher.Get(vBatch[i]));
+            }
+            
+            {
+                LOCK2(cs_main, pwallet->cs_wallet);
+                for(unsigned int i=0;(i<vBatch.size()) && (err == MC_ERR_NOERROR);i++)
+                {
+                    CBlockIndex *pindex=vBatch[i];
+                    if(chainActive[pindex->nHeight] != pindex)
+                    {
+                        break;                                                  // Reorganized, handled in the next iteration
+                    }
+                    if(!vBlocks[i])
+                    {
+                        LogPrintf("Background rescan: cannot read block %d\n",pindex->nHeight);
+                        err=MC_ERR_INTERNAL_ERROR;
+                        break;
+                    }
+                    
+                    CBlock& block=*vBlocks[i];
+                    CDiskTxPos pos(pindex->GetBlockPos(), GetSizeOfCompactSize(block.vtx.size()));
+                    int block_tx_index=0;
+                    BOOST_FOREACH(CTransaction& tx, block.vtx)
+                    {
+                        if(err == MC_ERR_NOERROR)
+                        {
+                            if(pindex->nHeight)                                 // Skip 0-block coinbase
+                            {
+                                err=pwalletTxsMain->AddTx(imp,tx,pindex->nHeight,&pos,block_tx_index,pindex->GetBlockHash());
+                            }
+                        }
+                        if(((mc_gState->m_WalletMode & MC_WMD_ADDRESS_TXS) == 0) || (mc_gState->m_WalletMode & MC_WMD_MAP_TXS))
+                        {
+                            pwallet->AddToWalletIfInvolvingMe(tx, &block, true);
+                        }
+                        pos.nTxOffset += ::GetSerializeSize(tx, SER_DISK, CLIENT_VERSION);
+                        block_tx_index++;
+                    }
+                    if(err == MC_ERR_NOERROR)
+                    {
+                        err=pwalletTxsMain->Commit(imp);
+                    }   
+                    if(err == MC_ERR_NOERROR)
+                    {
+                        pwalletTxsMain->CleanUpAfterBlock(imp,pindex->nHeight,pindex->nHeight-1);
+                        hashLast=pindex->GetBlockHash();
+                        nBlocks++;
+                    }                
+                }
+                SetRescanProgress(true,imp->m_Block,chainActive.Height());
+            }
+        }
+    }
+    catch(boost::thread_interrupted)
+    {
+        LOCK2(cs_main, pwallet->cs_wallet);
+        LogPrintf("Background rescan interrupted at block %d, import dropped\n",imp->m_Block);
+        pwalletTxsMain->DropImport(imp);
+        SetRescanProgress(false,-1,-1);
+        throw;
+    }
+    
+    if(err)
+    {
+        LOCK2(cs_main, pwallet->cs_wallet);
+        LogPrintf("Background rescan failed with error %d\n",err);            
+        pwalletTxsMain->DropImport(imp);
+    }
+    else
+    {
+        LogPrint("wallet","wtxs: Background rescan completed, %d blocks in %.3fs\n",nBlocks,0.001 * (GetTimeMillis() - nStart));
+    }
+    SetRescanProgress(false,-1,-1);
+    
+    return err;
+}
+
+void ThreadWalletRescan(CWallet* pwallet)
+{
+    RenameThread("bitcoin-rescan");
+    
+    while(true)
+    {
+        {
+            boost::unique_lock<boost::mutex> lock(mutexRescan);
+            while(!fRescanRequested)
+            {
+                condRescan.wait(lock);
+            }
+            fRescanRequested=false;
+        }
+        BackgroundRescan(pwallet);
+    }
+}
+
+/* AMB END */
+
 void CWallet::ReacceptWalletTransactions()
 {
     LOCK2(cs_main, cs_wallet);
@@ -1961,9 +2523,24 @@ void CWallet::AvailableCoins(vector<COutput>& vCoins, bool fOnlyConfirmed, const
         pwalletTxsMain->Lock();
         if(fOnlyCoinsNoTxs)
         {
-            for (map<COutPoint, mc_Coin>::const_iterator it = pwalletTxsMain->m_UTXOs[0].begin(); it != pwalletTxsMain->m_UTXOs[0].end(); ++it)
+/* AMB START */
+            vector<const mc_Coin*> vCandidateCoins;
+            if( (addresses != NULL) || (addr != 0) )                            // Only coins of requested addresses are visited
             {
-                const mc_Coin& coin = it->second;
+                pwalletTxsMain->GetAddressUTXOs(addr,addresses,vCandidateCoins);
+            }
+            else
+            {
+                vCandidateCoins.reserve(pwalletTxsMain->m_UTXOs[0].size());
+                for (map<COutPoint, mc_Coin>::const_iterator it = pwalletTxsMain->m_UTXOs[0].begin(); it != pwalletTxsMain->m_UTXOs[0].end(); ++it)
+                {
+                    vCandidateCoins.push_back(&(it->second));
+                }
+            }
+            for (unsigned int c=0; c<vCandidateCoins.size(); c++)
+            {
+                const mc_Coin& coin = *vCandidateCoins[c];
+/* AMB END */
                 if( ( (addresses == NULL) && (addr == 0) ) || 
                     (addr == coin.m_EntityID) || 
                     ( (addresses != NULL) && (addresses->count(coin.m_EntityID) != 0)) )
@@ -2581,13 +3158,18 @@ bool CWallet::CreateTransaction(const vector<pair<CScript, CAmount> >& vecSend,
                     txNew.vin.push_back(CTxIn(coin.first->GetHash(),coin.second));
 
                 // Sign
-                int nIn = 0;
+/* AMB START */
+                vector<CScript> vFromPubKeys;
+                vector<bool> vSigned;
+                vFromPubKeys.reserve(setCoins.size());
                 BOOST_FOREACH(const PAIRTYPE(const CWalletTx*,unsigned int)& coin, setCoins)
-                    if (!SignSignature(*this, *coin.first, txNew, nIn++))
-                    {                        
-                        strFailReason = _("Signing transaction failed");
-                        return false;
-                    }
+                    vFromPubKeys.push_back(coin.first->vout[coin.second].scriptPubKey);
+                if (!SignSignatures(*this, vFromPubKeys, txNew, vSigned))
+                {                        
+                    strFailReason = _("Signing transaction failed");
+                    return false;
+                }
+/* AMB END */
 
                 // Embed the constructed transaction data in wtxNew.
                 *static_cast<CTransaction*>(&wtxNew) = CTransaction(txNew);
@@ -53,6 +53,12 @@ static const CAmount DEFAULT_TRANSACTION_MAXFEE = 0.1 * COIN;
 static const CAmount nHighTransactionMaxFeeWarning = 100 * nHighTransactionFeeWarning;
 //! Largest (in bytes) free transaction we're willing to create
 static const unsigned int MAX_FREE_TRANSACTION_CREATE_SIZE = 1000;
+/* AMB START */
+//! -rescanprefetchthreads default
+static const int DEFAULT_RESCAN_PREFETCH_THREADS = 2;
+//! Blocks added to a background rescan import per cs_main lock
+static const int RESCAN_BATCH_BLOCKS = 100;
+/* AMB END */
 
 class CAccountingEntry;
 class CCoinControl;
@@ -1349,4 +1355,11 @@ private:
     std::vector<char> _ssExtra;
 };
 
+/* AMB START */
+/** Background rescan of entities not in sync, started by subscribe */
+void ThreadWalletRescan(CWallet* pwallet);
+void RequestBackgroundRescan();
+bool GetBackgroundRescanProgress(int *import_block,int *target_block);
+/* AMB END */
+
 #endif // BITCOIN_WALLET_H
@@ -1729,8 +1729,10 @@ CAmount BuildAssetTransaction(CWallet *lpWallet,
             return -2;            
         }
         
-        int nIn=0;
         unsigned int nSignatureBytes=0;
+        vector<CScript> vFromPubKeys;
+        vector<bool> vSigned;
+        vFromPubKeys.reserve(txNew.vin.size());
         coin_id=0;
         BOOST_FOREACH(const COutput& out, vCoins)                               // Signing
         {            
@@ -1743,15 +1745,7 @@ CAmount BuildAssetTransaction(CWallet *lpWallet,
 
                     if(flags & MC_CSF_SIGN)
                     {
-                        if (!SignSignature(*lpWallet, txout.scriptPubKey, txNew, nIn++))
-                        {
-                            CTransaction printableTx=CTransaction(txNew);
-                            if(fDebug)LogPrint("mchn","Cannot sign transaction input %d: (%s,%d), scriptPubKey %s \n",
-                                    nIn-1,txNew.vin[nIn-1].prevout.hash.ToString().c_str(),txNew.vin[nIn-1].prevout.n,txout.scriptPubKey.ToString().c_str());
-
-                            strFailReason = _("Signing transaction failed");
-                            return -2;
-                        }
+                        vFromPubKeys.push_back(txout.scriptPubKey);             // Inputs are signed together below
                     }
                     else
                     {
@@ -1769,6 +1763,24 @@ CAmount BuildAssetTransaction(CWallet *lpWallet,
             coin_id++;
         }
         
+        if(flags & MC_CSF_SIGN)
+        {
+            vFromPubKeys.resize(txNew.vin.size());
+            if (!SignSignatures(*lpWallet, vFromPubKeys, txNew, vSigned))
+            {
+                for(unsigned int nIn=0;nIn<vFromPubKeys.size();nIn++)
+                {
+                    if(!vFromPubKeys[nIn].empty() && !vSigned[nIn])
+                    {
+                        if(fDebug)LogPrint("mchn","Cannot sign transaction input %d: (%s,%d), scriptPubKey %s \n",
+                                nIn,txNew.vin[nIn].prevout.hash.ToString().c_str(),txNew.vin[nIn].prevout.n,vFromPubKeys[nIn].ToString().c_str());
+                    }
+                }
+                strFailReason = _("Signing transaction failed");
+                return -2;
+            }
+        }
+        
         wtxNew.fTimeReceivedIsTxTime = true;
         wtxNew.fFromMe=true;
         wtxNew.BindWallet(lpWallet);
@@ -221,6 +221,7 @@ void mc_TxDB::Zero()
     {
         m_RawMemPools[i]=NULL;
         m_MemPools[i]=NULL;
+        m_MemPoolPosIndex[i]=NULL;
         m_Imports[i].Zero();
     }
     m_RawUpdatePool=NULL;
@@ -238,6 +239,16 @@ void mc_TxDB::LogString(const char *message)
 {
     FILE *fHan;
     
+/* AMB START */
+    if(mc_gLogStringFunc)
+    {
+        if(mc_gLogStringFunc(m_LogFileName,message) == 0)
+        {
+            return;
+        }
+    }
+/* AMB END */
+    
     fHan=fopen(m_LogFileName,"a");
     if(fHan == NULL)
     {
@@ -498,6 +509,10 @@ int mc_TxDB::Destroy()
         {
             delete m_RawMemPools[i];
         }
+        if(m_MemPoolPosIndex[i])
+        {
+            delete m_MemPoolPosIndex[i];
+        }
     }
     
     if(m_RawUpdatePool)
@@ -1905,6 +1920,69 @@ exitlbl:
     return err;
 }
 
+int mc_TxDB::FindMemPoolRow(int slot,mc_TxEntity *entity,uint32_t pos)
+{
+    unsigned char key[sizeof(mc_TxEntity)+sizeof(uint32_t)+sizeof(int)];
+    mc_Buffer *mempool;
+    mc_Buffer *index;
+    mc_TxEntityRow *lpEnt;
+    int attempt,row,mprow;
+    
+    mempool=m_MemPools[slot];
+    if(mempool == NULL)
+    {
+        return -1;
+    }
+    
+    if(m_MemPoolPosIndex[slot] == NULL)
+    {
+        m_MemPoolPosIndex[slot]=new mc_Buffer;
+        m_MemPoolPosIndex[slot]->Initialize(sizeof(mc_TxEntity)+sizeof(uint32_t),sizeof(key),MC_BUF_MODE_MAP);
+    }
+    index=m_MemPoolPosIndex[slot];
+    
+    memcpy(key,entity,sizeof(mc_TxEntity));
+    memcpy(key+sizeof(mc_TxEntity),&pos,sizeof(uint32_t));
+    
+    for(attempt=0;attempt<2;attempt++)
+    {
+        if(attempt)                                                             // Mempool rows are added, moved and renumbered in many places, 
+        {                                                                       // index is verified on every hit and rebuilt when row is not found
+            index->Clear();
+            for(mprow=0;mprow<mempool->GetCount();mprow++)
+            {
+                lpEnt=(mc_TxEntityRow *)mempool->GetRow(mprow);
+                if(lpEnt->m_TempPos)
+                {
+                    memcpy(key,&(lpEnt->m_Entity),sizeof(mc_TxEntity));
+                    memcpy(key+sizeof(mc_TxEntity),&(lpEnt->m_TempPos),sizeof(uint32_t));
+                    memcpy(key+sizeof(mc_TxEntity)+sizeof(uint32_t),&mprow,sizeof(int));
+                    index->Add(key);
+                }
+            }
+            memcpy(key,entity,sizeof(mc_TxEntity));
+            memcpy(key+sizeof(mc_TxEntity),&pos,sizeof(uint32_t));
+        }
+        
+        row=index->Seek(key);
+        if(row >= 0)
+        {
+            mprow=*(int*)(index->GetRow(row)+sizeof(mc_TxEntity)+sizeof(uint32_t));
+            if(mprow < mempool->GetCount())
+            {
+                lpEnt=(mc_TxEntityRow *)mempool->GetRow(mprow);
+                if( (lpEnt->m_TempPos == pos) && 
+                    (memcmp(&(lpEnt->m_Entity),entity,sizeof(mc_TxEntity)) == 0))
+                {
+                    return mprow;
+                }
+            }
+        }
+    }
+    
+    return -1;
+}
+
 int mc_TxDB::GetRow(
                mc_TxEntityRow *erow)
 {
@@ -1928,16 +2006,13 @@ int mc_TxDB::GetRow(
     }
     else
     {
-        for(i=0;i<m_MemPools[0]->GetCount();i++)
+        i=FindMemPoolRow(0,&(erow->m_Entity),erow->m_Pos);
+        if(i >= 0)
         {
             lpEnt=(mc_TxEntityRow *)m_MemPools[0]->GetRow(i);
-            if( (lpEnt->m_TempPos == erow->m_Pos) && 
-                (memcmp(&(lpEnt->m_Entity),&(erow->m_Entity),sizeof(mc_TxEntity)) == 0))
-            {
-                memcpy(erow,lpEnt,MC_TDB_ROW_SIZE);
-                erow->m_Pos=lpEnt->m_TempPos;
-                return MC_ERR_NOERROR;
-            }            
+            memcpy(erow,lpEnt,MC_TDB_ROW_SIZE);
+            erow->m_Pos=lpEnt->m_TempPos;
+            return MC_ERR_NOERROR;
         }
     }
     
@@ -1966,7 +2041,7 @@ int mc_TxDB::GetList(
     mc_Buffer *mempool;
     int value_len; 
     unsigned char *ptr;
-    int err,mprow,found;
+    int err,mprow;
     char msg[256];
     
     txs->Clear();
@@ -2007,7 +2082,6 @@ int mc_TxDB::GetList(
     erow.Zero();
     memcpy(&erow.m_Entity,&(stat->m_Entity),sizeof(mc_TxEntity));
     erow.m_Generation=stat->m_Generation;
-    mprow=-1;
     for(i=first;i<=last;i++)
     {
         erow.m_Pos=i;
@@ -2034,25 +2108,15 @@ int mc_TxDB::GetList(
         }
         else                                                                    // mempool rows
         {
-            mprow++;
-            found=0;
-            while((found == 0) && (mprow < mempool->GetCount()))
+            mprow=FindMemPoolRow(import-m_Imports,entity,erow.m_Pos);
+            if(mprow >= 0)
             {
                 lpEnt=(mc_TxEntityRow *)mempool->GetRow(mprow);
-                if( (lpEnt->m_TempPos == erow.m_Pos) && 
-                    (memcmp(&(lpEnt->m_Entity),entity,sizeof(mc_TxEntity)) == 0))
-                {
-                    memcpy(&erow,lpEnt,MC_TDB_ROW_SIZE);
-                    erow.m_Pos=i;                    
-                    txs->Add((char*)&erow,(char*)&erow+MC_TDB_ENTITY_KEY_SIZE);                
-                    found=1;
-                }
-                else
-                {
-                    mprow++;
-                }
+                memcpy(&erow,lpEnt,MC_TDB_ROW_SIZE);
+                erow.m_Pos=i;                    
+                txs->Add((char*)&erow,(char*)&erow+MC_TDB_ENTITY_KEY_SIZE);                
             }
-            if(mprow >= mempool->GetCount())
+            else
             {
                 sprintf(msg,"GetList: couldn't find item %d in mempool, entity type %08X",i,erow.m_Entity.m_EntityType);
                 LogString(msg);
@@ -2087,7 +2151,7 @@ int mc_TxDB::GetList(
     mc_Buffer *mempool;
     int value_len; 
     unsigned char *ptr;
-    int err,mprow,found;
+    int err,mprow;
     char msg[256];
     
     txs->Clear();
@@ -2123,7 +2187,6 @@ int mc_TxDB::GetList(
     erow.Zero();
     memcpy(&erow.m_Entity,entity,sizeof(mc_TxEntity));
     erow.m_Generation=generation;
-    mprow=-1;
     for(i=first;i<=last;i++)
     {
         erow.m_Pos=i;
@@ -2150,25 +2213,15 @@ int mc_TxDB::GetList(
         }
         else                                                                    // mempool rows
         {
-            mprow++;
-            found=0;
-            while((found == 0) && (mprow < mempool->GetCount()))
+            mprow=FindMemPoolRow(import-m_Imports,entity,erow.m_Pos);
+            if(mprow >= 0)
             {
                 lpEnt=(mc_TxEntityRow *)mempool->GetRow(mprow);
-                if( (lpEnt->m_TempPos == erow.m_Pos) && 
-                    (memcmp(&(lpEnt->m_Entity),entity,sizeof(mc_TxEntity)) == 0))
-                {
-                    memcpy(&erow,lpEnt,MC_TDB_ROW_SIZE);
-                    erow.m_Pos=i;                    
-                    txs->Add((char*)&erow,(char*)&erow+MC_TDB_ENTITY_KEY_SIZE);                
-                    found=1;
-                }
-                else
-                {
-                    mprow++;
-                }
+                memcpy(&erow,lpEnt,MC_TDB_ROW_SIZE);
+                erow.m_Pos=i;                    
+                txs->Add((char*)&erow,(char*)&erow+MC_TDB_ENTITY_KEY_SIZE);                
             }
-            if(mprow >= mempool->GetCount())
+            else
             {
                 sprintf(msg,"GetList: couldn't find item %d in mempool, entity type %08X",i,erow.m_Entity.m_EntityType);
                 LogString(msg);
@@ -215,6 +215,7 @@ typedef struct mc_TxDB
     mc_TxEntityDB *m_Database;                                                  // Database 
     mc_Buffer *m_MemPools[MC_TDB_MAX_IMPORTS];                                  // mc_TxEntityRow mempool
     mc_Buffer *m_RawMemPools[MC_TDB_MAX_IMPORTS];                               // mc_TxDefRow mempool
+    mc_Buffer *m_MemPoolPosIndex[MC_TDB_MAX_IMPORTS];                           // (entity, m_TempPos) -> m_MemPools row, rebuilt on miss
     mc_Buffer *m_RawUpdatePool;                                                 // Updated txs mempool
     mc_TxImport m_Imports[MC_TDB_MAX_IMPORTS];                                  // Imports, 0 - chain
     mc_TxEntityDBStat m_DBStat;                                                 // Database stats
@@ -368,6 +369,7 @@ typedef struct mc_TxDB
     void Zero();    
     int Destroy();
     void Dump(const char *message);
+    int FindMemPoolRow(int slot,mc_TxEntity *entity,uint32_t pos);             // Returns m_MemPools[slot] row with specified entity and m_TempPos, -1 if not found
     
     int Lock(int write_mode, int allow_secondary);
     void UnLock();
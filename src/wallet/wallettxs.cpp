@@ -211,6 +211,7 @@ void mc_WalletTxs::Zero()
     for(i=0;i<MC_TDB_MAX_IMPORTS;i++)
     {
         m_UTXOs[i].clear();
+        m_AddressUTXOs[i].clear();
     }
     m_Mode=MC_WMD_NONE;
 }
@@ -1099,14 +1100,14 @@ int mc_WalletTxs::RollBack(mc_TxImport *import,int block)
                 {
                     if(txouts[i].m_Flags == MC_TFL_IMPOSSIBLE)                  // Outputs to delete
                     {
-                        m_UTXOs[import_pos].erase(txouts[i].m_OutPoint);                        
+                        UTXOErase(import_pos,txouts[i].m_OutPoint);                        
                     }
                     else                                                        // Inputs to restore
                     {
                         std::map<COutPoint, mc_Coin>::const_iterator itold = m_UTXOs[import_pos].find(txouts[i].m_OutPoint);
                         if (itold == m_UTXOs[import_pos].end())
                         {
-                            m_UTXOs[import_pos].insert(make_pair(txouts[i].m_OutPoint, txouts[i]));
+                            UTXOInsert(import_pos,txouts[i]);
                         }                    
                     }
                 }
@@ -1267,7 +1268,7 @@ mc_TxImport *mc_WalletTxs::StartImport(mc_Buffer *lpEntities,int block,int *err)
     imp=m_Database->StartImport(lpEntities,block,err);
     if(*err == MC_ERR_NOERROR)                                                  // BAD If block!=-1 old UXOs should be copied?
     {
-        m_UTXOs[imp-m_Database->m_Imports].clear();
+        UTXOClear(imp-m_Database->m_Imports);
     }
     if(fDebug)LogPrint("wallet","wtxs: StartImport: Import: %d, Block: %d\n",imp->m_ImportID,imp->m_Block);
     m_Database->UnLock();
@@ -1309,6 +1310,52 @@ int mc_WalletTxs::ImportGetBlock(mc_TxImport *import)
     
 }
 
+/* AMB START */
+size_t mc_WalletTxs::GetMempoolUsage()
+{
+    if((m_Mode & MC_WMD_TXS) == 0)
+    {
+        return 0;
+    }    
+    if(m_Database == NULL)
+    {
+        return 0;
+    }
+    return (size_t)m_Database->m_MemPools[0]->GetCount()*m_Database->m_MemPools[0]->m_RowSize+
+           (size_t)m_Database->m_RawMemPools[0]->GetCount()*m_Database->m_RawMemPools[0]->m_RowSize;
+}
+
+int mc_WalletTxs::ImportSkipBlocks(mc_TxImport *import,int block)
+{
+    int err;
+    if((m_Mode & MC_WMD_TXS) == 0)
+    {
+        return MC_ERR_NOT_SUPPORTED;
+    }    
+    if(m_Database == NULL)
+    {
+        return MC_ERR_INTERNAL_ERROR;
+    }
+    err=MC_ERR_NOERROR;
+    m_Database->Lock(1,0);
+    if( (import->m_ImportID == 0) ||                                            // Chain import cannot skip blocks
+        (m_Database->m_MemPools[import-m_Database->m_Imports]->GetCount() != 0) ) // Uncommitted rows
+    {
+        err=MC_ERR_INTERNAL_ERROR;
+    }
+    else
+    {
+        if(block > import->m_Block)                                             // Persisted by the next Commit
+        {
+            if(fDebug)LogPrint("wallet","wtxs: ImportSkipBlocks: Import: %d, Block: %d -> %d\n",import->m_ImportID,import->m_Block,block);
+            import->m_Block=block;
+        }
+    }
+    m_Database->UnLock();
+    return err;                
+}
+/* AMB END */
+
 int mc_WalletTxs::CompleteImport(mc_TxImport *import)
 {
     int err,import_pos,gen,count;
@@ -1359,7 +1406,7 @@ int mc_WalletTxs::CompleteImport(mc_TxImport *import)
                 {
                     if(it->second.m_Block >= 0)
                     {
-                        m_UTXOs[0].insert(make_pair(it->first, it->second));        
+                        UTXOInsert(0,it->second);        
                     }
                 }                    
                 else
@@ -1379,6 +1426,7 @@ int mc_WalletTxs::CompleteImport(mc_TxImport *import)
             if(count)
             {
                 m_UTXOs[0]=mapCurrent;            
+                UTXOReindex(0);
             }
         }    
 
@@ -1390,7 +1438,7 @@ int mc_WalletTxs::CompleteImport(mc_TxImport *import)
                 std::map<COutPoint, mc_Coin>::iterator itold = m_UTXOs[0].find(it->first);
                 if (itold == m_UTXOs[0].end())
                 {
-                    m_UTXOs[0].insert(make_pair(it->first, it->second));        
+                    UTXOInsert(0,it->second);        
                 }                    
                 else
                 {
@@ -1690,6 +1738,89 @@ int mc_WalletTxs::SaveUTXOMap(int import_id,int block)
     return MC_ERR_NOERROR;
 }
 
+/* AMB START */
+
+void mc_WalletTxs::UTXOInsert(int import_pos,const mc_Coin& coin)
+{
+    if(m_UTXOs[import_pos].insert(make_pair(coin.m_OutPoint, coin)).second)
+    {
+        m_AddressUTXOs[import_pos][coin.m_EntityID].insert(coin.m_OutPoint);
+    }
+}
+
+void mc_WalletTxs::UTXOErase(int import_pos,const COutPoint& outpoint)
+{
+    std::map<COutPoint, mc_Coin>::iterator it = m_UTXOs[import_pos].find(outpoint);
+    if(it == m_UTXOs[import_pos].end())
+    {
+        return;
+    }
+    std::map<uint160, std::set<COutPoint> >::iterator itaddr = m_AddressUTXOs[import_pos].find(it->second.m_EntityID);
+    if(itaddr != m_AddressUTXOs[import_pos].end())
+    {
+        itaddr->second.erase(outpoint);
+        if(itaddr->second.empty())
+        {
+            m_AddressUTXOs[import_pos].erase(itaddr);
+        }
+    }
+    m_UTXOs[import_pos].erase(it);
+}
+
+void mc_WalletTxs::UTXOClear(int import_pos)
+{
+    m_UTXOs[import_pos].clear();
+    m_AddressUTXOs[import_pos].clear();
+}
+
+void mc_WalletTxs::UTXOReindex(int import_pos)
+{
+    m_AddressUTXOs[import_pos].clear();
+    for (map<COutPoint, mc_Coin>::const_iterator it = m_UTXOs[import_pos].begin(); it != m_UTXOs[import_pos].end(); ++it)
+    {
+        m_AddressUTXOs[import_pos][it->second.m_EntityID].insert(it->first);
+    }
+}
+
+void mc_WalletTxs::GetAddressUTXOs(const uint160& addr,const std::set<uint160>* addresses,std::vector<const mc_Coin*>& vCoins)
+{
+    std::set<COutPoint> setOutPoints;
+    std::map<uint160, std::set<COutPoint> >::const_iterator itaddr;
+    
+    if(addr != 0)
+    {
+        itaddr = m_AddressUTXOs[0].find(addr);
+        if(itaddr != m_AddressUTXOs[0].end())
+        {
+            setOutPoints.insert(itaddr->second.begin(),itaddr->second.end());
+        }
+    }
+    if(addresses)
+    {
+        for (std::set<uint160>::const_iterator it = addresses->begin(); it != addresses->end(); ++it)
+        {
+            itaddr = m_AddressUTXOs[0].find(*it);
+            if(itaddr != m_AddressUTXOs[0].end())
+            {
+                setOutPoints.insert(itaddr->second.begin(),itaddr->second.end());
+            }
+        }
+    }
+    
+    vCoins.clear();
+    vCoins.reserve(setOutPoints.size());
+    for (std::set<COutPoint>::const_iterator it = setOutPoints.begin(); it != setOutPoints.end(); ++it)
+    {
+        std::map<COutPoint, mc_Coin>::const_iterator itcoin = m_UTXOs[0].find(*it);
+        if(itcoin != m_UTXOs[0].end())
+        {
+            vCoins.push_back(&(itcoin->second));
+        }
+    }
+}
+
+/* AMB END */
+
 int mc_WalletTxs::LoadUTXOMap(int import_id,int block)
 {
     char ShortName[65];                                     
@@ -1712,7 +1843,7 @@ int mc_WalletTxs::LoadUTXOMap(int import_id,int block)
 
     if(block < 0)
     {
-        m_UTXOs[import_pos].clear();
+        UTXOClear(import_pos);
         return MC_ERR_NOERROR;
     }
     
@@ -1749,6 +1880,7 @@ int mc_WalletTxs::LoadUTXOMap(int import_id,int block)
     }
     
     m_UTXOs[import_pos]=mapOut;
+    UTXOReindex(import_pos);
     
     if(fDebug)LogPrint("wallet","wtxs: Loaded %u unspent outputs for import %d\n",m_UTXOs[import_pos].size(),import_pos);
             
@@ -2563,6 +2695,12 @@ int mc_WalletTxs::AddTx(mc_TxImport *import,const CWalletTx& tx,int block,CDiskT
         block_file=block_pos->nFile;
         block_offset=block_pos->nPos;
         block_tx_offset=block_pos->nTxOffset;
+/* AMB START */
+        if(txsize != txfullsize)                                                // Shortened tx is read from block file, file should not be pruned
+        {
+            PinBlockFile(block_file);
+        }
+/* AMB END */
     }
     else
     {
@@ -2602,7 +2740,7 @@ int mc_WalletTxs::AddTx(mc_TxImport *import,const CWalletTx& tx,int block,CDiskT
     {
         for(i=0;i<(int)txoutsIn.size();i++)
         {
-            m_UTXOs[import_pos].erase(txoutsIn[i].m_OutPoint);
+            UTXOErase(import_pos,txoutsIn[i].m_OutPoint);
         }
         for(i=0;i<(int)txoutsOut.size();i++)
         {
@@ -2623,7 +2761,7 @@ int mc_WalletTxs::AddTx(mc_TxImport *import,const CWalletTx& tx,int block,CDiskT
                         }
                     }
                 }
-                m_UTXOs[import_pos].insert(make_pair(txoutsOut[i].m_OutPoint, txoutsOut[i]));
+                UTXOInsert(import_pos,txoutsOut[i]);
             }                    
         }
     }    
@@ -49,6 +49,7 @@ typedef struct mc_WalletTxs
     CWallet *m_lpWallet;
     uint32_t m_Mode;
     std::map<COutPoint, mc_Coin> m_UTXOs[MC_TDB_MAX_IMPORTS];    
+    std::map<uint160, std::set<COutPoint> > m_AddressUTXOs[MC_TDB_MAX_IMPORTS]; // Outpoints in m_UTXOs by mc_Coin::m_EntityID, maintained by UTXO* functions
     std::map<uint256,CWalletTx> m_UnconfirmedSends;
     std::vector<uint256> m_UnconfirmedSendsHashes;
     std::map<uint256, CWalletTx> vAvailableCoins;    
@@ -146,6 +147,10 @@ typedef struct mc_WalletTxs
     int ImportGetBlock(                                                         // Returns last processed block in the import
                        mc_TxImport *import);
     
+    size_t GetMempoolUsage();                                                   // Memory used by unconfirmed rows of chain import
+    
+    int ImportSkipBlocks(mc_TxImport *import,int block);                        // Moves import position without processing blocks, caller knows they are irrelevant
+    
     int CompleteImport(mc_TxImport *import);                                    // Completes import - merges with chain
     
     int DropImport(mc_TxImport *import);                                        // Drops uncompleted import
@@ -157,6 +162,11 @@ typedef struct mc_WalletTxs
 
     std::string Summary();                                                      // Wallet summary
     
+    void GetAddressUTXOs(                                                       // Returns chain unspent coins of specific addresses, ordered by outpoint
+                   const uint160& addr,                                         // Single address, 0 if not used
+                   const std::set<uint160>* addresses,                          // Address list, NULL if not used
+                   std::vector<const mc_Coin*>& vCoins);                        // Output, pointers into m_UTXOs[0], valid while wallet is locked
+    
 // Internal functions
     
     void Zero();    
@@ -179,6 +189,10 @@ typedef struct mc_WalletTxs
     int SaveUTXOMap(int import_id,int block);
     int LoadUTXOMap(int import_id,int block);
     int RemoveUTXOMap(int import_id,int block);
+    void UTXOInsert(int import_pos,const mc_Coin& coin);
+    void UTXOErase(int import_pos,const COutPoint& outpoint);
+    void UTXOClear(int import_pos);
+    void UTXOReindex(int import_pos);
     int GetBlock();
     
     void Lock();